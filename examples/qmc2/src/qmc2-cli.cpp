@@ -2,7 +2,9 @@
 #include "parakeet-crypto/qmc2/key_util.h"
 
 #include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <parakeet-crypto/IStreamingDecryptor.h>
 #include <parakeet-crypto/StreamHelper.h>
 
 #include <parakeet-crypto/qmc2/footer_parser.h>
@@ -46,9 +48,12 @@ void print_help()
               << "  --raw-ekey [ekey]      Raw ekey to qmc2 decryptor. This overrides '--ekey'.\n"
               << "                         Will attempt to read from file footer if not provided.\n"
               << "\n"
-              << "  --tail-trim            Number of bytes to trim off the tail. When key is provided, \n"
-              << "                         this will default to 0. When key is absent, this will\n"
-              << "                         auto-detect from tail\n"
+              << "  --tail-trim            Number of bytes to trim off the tail. Auto-detected from the\n"
+              << "                         footer when absent, whether the key is provided or not.\n"
+              << "\n"
+              << "Use '-' as input path to read from stdin. With a key provided (and no '--tail-trim'),\n"
+              << "the file is decrypted as it is received, and the footer is detected at the end.\n"
+              << "Otherwise, stdin is copied to a temporary file first.\n"
               << '\n';
 }
 
@@ -107,40 +112,105 @@ int main(int argc, char **argv)
     }
 
     bool useStdin = *path_file_in == "-";
-    std::ifstream input_file;
+    std::shared_ptr<IReadSeekable> input_stream{};
     if (!useStdin)
     {
-        input_file.open(*path_file_in, std::ifstream::binary);
-        if (!input_file.is_open())
+        input_stream = InputFDStream::Open(path_file_in->c_str());
+        if (!input_stream)
         {
             std::cerr << "ERROR: could not open input file\n";
             return 1;
         }
     }
 
-    auto input_stream = std::shared_ptr<IReadSeekable>(
-        useStdin ? dynamic_cast<IReadSeekable *>(InputMemoryStream::FromStdin().release())
-                 : dynamic_cast<IReadSeekable *>(new InputFileStream(input_file)));
+    bool useStdout = *path_file_out == "-";
+    std::shared_ptr<OutputFDStream> output_file{};
+    if (!useStdout)
+    {
+        output_file = OutputFDStream::Open(path_file_out->c_str());
+        if (!output_file)
+        {
+            std::cerr << "ERROR: could not open output file\n";
+            return 1;
+        }
+    }
+    auto writer = useStdout ? std::shared_ptr<IWriteable>(std::make_shared<WriteToStdoutStream>())
+                            : std::shared_ptr<IWriteable>(output_file);
 
     // setup crypto
     auto key_crypto = qmc2::CreateKeyCrypto(seed, qmc2_encv2_key1_local.data(), qmc2_encv2_key2_local.data());
 
     std::vector<uint8_t> ekey;
-    size_t footer_len_exclude{0};
     if (raw_ekey_str)
     {
-        footer_len_exclude = 0;
         ekey.assign(raw_ekey_str->begin(), raw_ekey_str->end());
     }
     else if (ekey_str)
     {
-        footer_len_exclude = 0;
         ekey = key_crypto->Decrypt(reinterpret_cast<const uint8_t *>(ekey_str->c_str()), // NOLINT(*reinterpret-cast)
                                    ekey_str->size());
     }
-    else
+    auto footer_exclude_override = args->get_int("tail-trim");
+    std::shared_ptr<qmc2::QMCFooterParser> footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
+
+    // Key is known, and the footer can be detected: decrypt stdin as it arrives.
+    // Only the last few KiB are held back, until the footer is found at the end of the stream.
+    if (useStdin && !ekey.empty() && !footer_exclude_override)
+    {
+        auto transformer =
+            transformer::CreateQMC2DecryptionTransformer(footer_parser, ekey.data(), ekey.size());
+        std::unique_ptr<IStreamingDecryptor> decryptor{};
+        auto decryption_result = transformer->CreateStreamingDecryptor(decryptor);
+        if (decryption_result == TransformResult::OK)
+        {
+            decryption_result = StreamingDecryptFromFile(*decryptor, stdin, &*writer);
+        }
+        if (decryption_result == TransformResult::OK && output_file && !output_file->Flush())
+        {
+            decryption_result = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+        }
+        if (decryption_result != TransformResult::OK)
+        {
+            std::cerr << "decryption failed - error(" << static_cast<uint32_t>(decryption_result) << ")\n";
+            return 1;
+        }
+
+        std::cerr << "done!\n";
+        return 0;
+    }
+
+    // Otherwise, the footer is needed first: spool stdin to a temporary file instead of memory.
+    if (useStdin)
+    {
+        FILE *spool_file = std::tmpfile();
+        if (spool_file == nullptr)
+        {
+            std::cerr << "ERROR: could not create temporary file\n";
+            return 1;
+        }
+
+        std::vector<uint8_t> buffer(kPipeReadSize);
+        size_t bytes_read{0};
+        while ((bytes_read = fread(buffer.data(), 1, buffer.size(), stdin)) > 0)
+        {
+            if (fwrite(buffer.data(), 1, bytes_read, spool_file) != bytes_read)
+            {
+                std::cerr << "ERROR: could not write temporary file\n";
+                return 1;
+            }
+        }
+        fflush(spool_file);
+
+        // The stream reads with positional reads, and keeps the temporary file open until it is destroyed.
+        auto *spool_stream = new InputFDStream(fileno(spool_file));
+        input_stream = std::shared_ptr<IReadSeekable>(spool_stream, [spool_file](IReadSeekable *stream) {
+            delete stream;
+            fclose(spool_file);
+        });
+    }
+
+    if (ekey.empty())
     {
-        auto footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
         auto footer = footer_parser->Parse(*input_stream);
         if (footer->state != qmc2::FooterParseState::OK)
         {
@@ -149,37 +219,38 @@ int main(int argc, char **argv)
             return 1;
         }
         ekey = footer->key;
-        footer_len_exclude = footer->footer_size;
     }
-    if (auto footer_exclude_override = args->get_int("tail-trim"))
+
+    // Create our transformer: it finds the footer the same way as the stdin decryptor above, unless overridden.
+    std::unique_ptr<ITransformer> transformer{};
+    size_t footer_len_exclude{0};
+    if (footer_exclude_override)
     {
+        transformer = (qmc2::GetEncryptionType(ekey) == qmc2::QMC2EncryptionType::RC4)
+                          ? transformer::CreateQMC2RC4DecryptionTransformer(ekey)
+                          : transformer::CreateQMC2MapDecryptionTransformer(ekey);
         footer_len_exclude = *footer_exclude_override;
     }
-
-    bool useStdout = *path_file_out == "-";
-    std::ofstream output_file{};
-    if (!useStdout)
+    else
     {
-        output_file.open(*path_file_out, std::ofstream::binary);
-        if (!output_file.is_open())
-        {
-            std::cerr << "ERROR: could not open output file\n";
-            return 1;
-        }
+        transformer = transformer::CreateQMC2DecryptionTransformer(footer_parser, ekey.data(), ekey.size());
     }
-    auto writer = std::shared_ptr<IWriteable>(useStdin ? dynamic_cast<IWriteable *>(new WriteToStdoutStream())
-                                                       : dynamic_cast<IWriteable *>(new OutputFileStream(output_file)));
-
-    // Create our transformer
-    auto transformer = (qmc2::GetEncryptionType(ekey) == qmc2::QMC2EncryptionType::RC4)
-                           ? transformer::CreateQMC2RC4DecryptionTransformer(ekey)
-                           : transformer::CreateQMC2MapDecryptionTransformer(ekey);
 
     // We need to create a "reader slice" so we don't "over-decrypt" key section.
     SlicedReadableStream reader{*input_stream, 0, input_stream->GetSize() - footer_len_exclude};
 
+    // The output is at most the input size: reserve it upfront.
+    if (output_file)
+    {
+        output_file->Preallocate(reader.GetSize());
+    }
+
     // Perform decryption...
     auto decryption_result = transformer->Transform(&*writer, &reader);
+    if (decryption_result == TransformResult::OK && output_file && !output_file->Flush())
+    {
+        decryption_result = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+    }
     if (decryption_result != TransformResult::OK)
     {
         std::cerr << "decryption failed - error(" << static_cast<uint32_t>(decryption_result) << ")\n";
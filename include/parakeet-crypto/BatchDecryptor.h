@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ITransformer.h"
+#include "TransformResult.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+/**
+ * @brief A file to decrypt, as part of a batch.
+ */
+struct BatchDecryptionJob
+{
+    std::string input_path;
+    std::string output_path;
+
+    /**
+     * @brief Transformer for this file. Not owned; may be shared between jobs only if it can be used from several
+     *        threads at the same time.
+     */
+    ITransformer *transformer{};
+
+    /**
+     * @brief Set by `IBatchDecryptor::Run`.
+     */
+    TransformResult result{TransformResult::ERROR_OTHER};
+};
+
+enum class BatchDecryptorBackend
+{
+    AUTO = 0,     // io_uring when available, threads otherwise.
+    IO_URING = 1, // Linux only.
+    THREADS = 2,
+};
+
+struct BatchDecryptorOptions
+{
+    static constexpr size_t kDefaultPageSize = static_cast<size_t>(256 * 1024);
+    static constexpr size_t kDefaultQueueDepth = 64;
+
+    BatchDecryptorBackend backend{BatchDecryptorBackend::AUTO};
+
+    /**
+     * @brief Size of each page buffer.
+     */
+    size_t page_size{kDefaultPageSize};
+
+    /**
+     * @brief Number of page buffers in flight (io_uring).
+     */
+    size_t queue_depth{kDefaultQueueDepth};
+
+    /**
+     * @brief Number of worker threads: files decrypted at once (threads backend), or threads decrypting the pages
+     *        read by the ring and the formats without a random access decryptor (io_uring); `0` to use the number of
+     *        CPU cores.
+     */
+    size_t thread_count{0};
+};
+
+/**
+ * @brief Decrypt many files to many files, keeping the disk and the CPU busy at the same time.
+ *
+ * The io_uring backend keeps a fixed number of page buffers in flight across the files of the batch: each
+ * completed read is decrypted on a worker thread by the format's `IRandomAccessDecryptor`, and written back while the
+ * other reads are pending. The output size is known from the header, and reserved upfront. Formats without a random
+ * access decryptor (e.g. JOOX, QRC) go through `ITransformer::Transform` on the same worker threads, in the meantime.
+ *
+ * The threads backend decrypts a file per worker thread, page by page.
+ */
+class IBatchDecryptor
+{
+  public:
+    virtual ~IBatchDecryptor() = default;
+
+    /**
+     * @brief Name of the backend in use, i.e. "io_uring" or "threads".
+     */
+    [[nodiscard]] virtual const char *GetBackendName() const = 0;
+
+    /**
+     * @brief Decrypt all jobs, and set their `result`. Returns when every job is complete.
+     *        Output files are only created for jobs whose header could be parsed.
+     */
+    virtual void Run(std::vector<BatchDecryptionJob> &jobs) = 0;
+};
+
+/**
+ * @brief Create a batch decryptor.
+ *
+ * @return std::unique_ptr<IBatchDecryptor> `nullptr` if the requested backend is not available.
+ */
+std::unique_ptr<IBatchDecryptor> CreateBatchDecryptor(const BatchDecryptorOptions &options = {});
+
+} // namespace parakeet_crypto
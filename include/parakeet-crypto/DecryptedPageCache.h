@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+struct DecryptedPageCacheStats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    size_t bytes_used{0};
+    size_t page_count{0};
+};
+
+/**
+ * @brief Process-wide LRU cache of decrypted pages, shared by readers of the same files.
+ *        Keyed by (file id, page index), bounded by the total size of the cached pages.
+ *
+ * The cache is split into independently locked shards, so concurrent readers rarely contend on the same lock.
+ * Pages are immutable once inserted, and handed out as shared pointers: an evicted page stays valid for
+ * readers still holding it.
+ *
+ * @note The file id is chosen by the caller, and must change when the file content or the decryption key does
+ *       (e.g. a hash of path, size and modification time).
+ */
+class DecryptedPageCache
+{
+  public:
+    using Page = std::shared_ptr<const std::vector<uint8_t>>;
+
+    static constexpr size_t kDefaultShardCount = 16;
+
+    /**
+     * @param capacity_bytes Maximum number of bytes of decrypted data to keep.
+     * @param shard_count Number of independently locked shards; reduced so that each shard holds at least one
+     *                    page of `GetPageSize()` bytes.
+     */
+    explicit DecryptedPageCache(size_t capacity_bytes, size_t shard_count = kDefaultShardCount);
+    DecryptedPageCache(const DecryptedPageCache &) = delete;
+    DecryptedPageCache(DecryptedPageCache &&) = delete;
+    DecryptedPageCache &operator=(const DecryptedPageCache &) = delete;
+    DecryptedPageCache &operator=(DecryptedPageCache &&) = delete;
+    ~DecryptedPageCache();
+
+    /**
+     * @brief Size of a page, in bytes. Every page except the last page of a file has this size.
+     */
+    [[nodiscard]] static size_t GetPageSize();
+
+    /**
+     * @brief Look up a page, and mark it as recently used.
+     *
+     * @return Page `nullptr` if the page is not cached.
+     */
+    Page Get(uint64_t file_id, size_t page_index);
+
+    /**
+     * @brief Insert or replace a page, evicting the least recently used pages if over capacity.
+     *        Pages larger than the capacity of a shard are not cached.
+     */
+    void Put(uint64_t file_id, size_t page_index, Page page);
+
+    /**
+     * @brief Drop all pages of a given file.
+     */
+    void Erase(uint64_t file_id);
+
+    /**
+     * @brief Drop all pages. Counters are kept.
+     */
+    void Clear();
+
+    [[nodiscard]] DecryptedPageCacheStats GetStats() const;
+
+  private:
+    struct PageKey
+    {
+        uint64_t file_id;
+        size_t page_index;
+
+        bool operator==(const PageKey &other) const
+        {
+            return file_id == other.file_id && page_index == other.page_index;
+        }
+    };
+
+    struct PageKeyHash
+    {
+        size_t operator()(const PageKey &key) const;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::pair<PageKey, Page>> lru; // most recently used first
+        std::unordered_map<PageKey, std::list<std::pair<PageKey, Page>>::iterator, PageKeyHash> index;
+        size_t bytes_used{0};
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_{};
+    size_t shard_capacity_{0};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+
+    Shard &GetShard(const PageKey &key);
+    void EvictLocked(Shard &shard);
+};
+
+} // namespace parakeet_crypto
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "parakeet-crypto/DecryptedPageCache.h"
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/ITransformer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace parakeet_crypto
+{
+
+/**
+ * @brief Plaintext view over an encrypted file.
+ *        Only the ranges being read are decrypted, so tag readers and audio decoders can consume the
+ *        encrypted file directly, without writing a decrypted copy first.
+ *
+ * Offsets are relative to the decrypted audio: the file header (e.g. KGM/NCM/Kuwo header) and footer
+ * (e.g. QMCv2 key footer) are not part of this stream.
+ */
+class DecryptingReadStream final : public IReadSeekable
+{
+  private:
+    IReadSeekable &input_;
+    std::shared_ptr<const IRandomAccessDecryptor> decryptor_{};
+    size_t offset_{0};
+
+    std::shared_ptr<DecryptedPageCache> page_cache_{};
+    uint64_t file_id_{0};
+
+    size_t ReadAtCached(size_t offset, uint8_t *buffer, size_t len);
+
+  public:
+    /**
+     * @param input Encrypted file. Must outlive this stream.
+     * @param decryptor Decryptor created from `input`. Can be shared with other streams over the same file.
+     */
+    DecryptingReadStream(IReadSeekable &input, std::shared_ptr<const IRandomAccessDecryptor> decryptor)
+        : input_(input), decryptor_(std::move(decryptor))
+    {
+    }
+
+    /**
+     * @brief Parse the header of `input` with `transformer`, and create a plaintext view of it.
+     *
+     * @param stream Receives the stream on success.
+     * @param transformer Transformer for the format of `input`.
+     * @param input Encrypted file. Must outlive the created stream.
+     * @return TransformResult `ERROR_NOT_IMPLEMENTED` if the format does not support random access.
+     */
+    static TransformResult Create(std::unique_ptr<DecryptingReadStream> &stream, ITransformer *transformer,
+                                  IReadSeekable *input);
+
+    [[nodiscard]] const IRandomAccessDecryptor &GetDecryptor() const
+    {
+        return *decryptor_;
+    }
+
+    /**
+     * @brief Look up decrypted pages in a shared cache before decrypting, and store the pages decrypted.
+     *
+     * @param page_cache Cache to use, `nullptr` to disable.
+     * @param file_id Identity of the input file in the cache; see `DecryptedPageCache`.
+     */
+    void SetPageCache(std::shared_ptr<DecryptedPageCache> page_cache, uint64_t file_id)
+    {
+        page_cache_ = std::move(page_cache);
+        file_id_ = file_id;
+    }
+
+    size_t Read(uint8_t *buffer, size_t len) override
+    {
+        auto bytes_read = ReadAt(offset_, buffer, len);
+        offset_ += bytes_read;
+        return bytes_read;
+    }
+    void Seek(size_t position, SeekDirection seek_dir) override
+    {
+        size_t next_offset{0};
+        switch (seek_dir)
+        {
+        case SeekDirection::SEEK_FILE_BEGIN:
+            next_offset = position;
+            break;
+        case SeekDirection::SEEK_CURRENT_POSITION:
+            next_offset = offset_ + position;
+            break;
+        case SeekDirection::SEEK_FILE_END:
+            next_offset = GetSize() + position;
+            break;
+        default:
+            return;
+        }
+        offset_ = std::min(next_offset, GetSize());
+    }
+    size_t GetSize() override
+    {
+        return decryptor_->GetDataSize();
+    }
+    size_t GetOffset() override
+    {
+        return offset_;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override;
+    bool IsConcurrentReadAtSupported() override
+    {
+        // Decryptors are thread-safe; only the input needs to support it.
+        return input_.IsConcurrentReadAtSupported();
+    }
+};
+
+} // namespace parakeet_crypto
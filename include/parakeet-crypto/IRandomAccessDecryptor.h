@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto
+{
+
+/**
+ * @brief Decrypt any range of the audio payload, without processing the bytes before it.
+ *        Created by `ITransformer::CreateRandomAccessDecryptor`, after the file header has been parsed.
+ *
+ * The payload is stored at `[GetDataOffset(), GetDataOffset() + GetDataSize())` of the encrypted file,
+ * and each encrypted byte decrypts to exactly one byte of audio.
+ */
+class IRandomAccessDecryptor
+{
+  public:
+    virtual ~IRandomAccessDecryptor() = default;
+
+    /**
+     * @brief Get decryptor name.
+     *
+     * @return const char*
+     */
+    [[nodiscard]] virtual const char *GetName() const = 0;
+
+    /**
+     * @brief Offset of the encrypted payload, from the beginning of the input stream.
+     *        Includes the position the input was at when the decryptor was created.
+     */
+    [[nodiscard]] virtual size_t GetDataOffset() const = 0;
+
+    /**
+     * @brief Size of the payload, in bytes. Also the size of the decrypted audio.
+     */
+    [[nodiscard]] virtual size_t GetDataSize() const = 0;
+
+    /**
+     * @brief Decrypt a range of the payload, in place.
+     *        This method does not modify the decryptor, and can be called from multiple threads at the same time.
+     *
+     * @param offset Offset relative to the payload, i.e. `file_offset - GetDataOffset()`.
+     * @param buffer Encrypted data read from the file; replaced with the decrypted data.
+     * @param len Number of bytes to decrypt.
+     * @return true Decrypted.
+     * @return false Range is out of the payload bounds, or the cipher failed.
+     */
+    [[nodiscard]] virtual bool DecryptAt(size_t offset, uint8_t *buffer, size_t len) const = 0;
+};
+
+} // namespace parakeet_crypto
@@ -24,6 +24,46 @@ class IReadSeekable
     virtual size_t GetSize() = 0;
     virtual size_t GetOffset() = 0;
 
+    /**
+     * @brief Get a read-only view to the underlying storage, without copying.
+     *        Only streams backed by contiguous memory (e.g. memory buffer, memory-mapped file) can provide this.
+     *
+     * @param offset Offset from the beginning of the stream.
+     * @param len Number of bytes requested.
+     * @return const uint8_t* Pointer to the data; `nullptr` if not supported, or the range is out of bounds.
+     */
+    virtual const uint8_t *GetContiguousView(size_t /*offset*/, size_t /*len*/)
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief Read from a given position, without moving the cursor used by `Read`/`Seek`.
+     *        Streams backed by memory or positional file reads (`pread`) are safe to call this concurrently;
+     *        the default implementation falls back to `Seek`/`Read` and is not.
+     *
+     * @param offset Offset from the beginning of the stream.
+     * @param buffer Output buffer.
+     * @param len Number of bytes to read.
+     * @return size_t Number of bytes read; less than `len` when reaching the end of the stream.
+     */
+    [[nodiscard("validate it")]] virtual size_t ReadAt(size_t offset, uint8_t *buffer, size_t len)
+    {
+        auto prev_offset = GetOffset();
+        Seek(offset, SeekDirection::SEEK_FILE_BEGIN);
+        auto bytes_read = Read(buffer, len);
+        Seek(prev_offset, SeekDirection::SEEK_FILE_BEGIN);
+        return bytes_read;
+    }
+
+    /**
+     * @brief Check if `ReadAt` can be called from multiple threads at the same time.
+     */
+    virtual bool IsConcurrentReadAtSupported()
+    {
+        return false;
+    }
+
     // Helpers
     [[nodiscard("check if we've read them all")]] bool ReadExact(uint8_t *buffer, size_t len)
     {
@@ -31,6 +71,12 @@ class IReadSeekable
         return bytes_read == len;
     }
 
+    [[nodiscard("check if we've read them all")]] bool ReadExactAt(size_t offset, uint8_t *buffer, size_t len)
+    {
+        auto bytes_read = ReadAt(offset, buffer, len);
+        return bytes_read == len;
+    }
+
     [[nodiscard("use it")]] std::vector<uint8_t> Read(size_t len)
     {
         std::vector<uint8_t> result(len, 0);
@@ -45,6 +91,42 @@ class IWriteable
   public:
     virtual ~IWriteable() = default;
     [[nodiscard]] virtual bool Write(const uint8_t *buffer, size_t len) = 0;
+
+    /**
+     * @brief Write at a given position, without moving the cursor used by `Write`.
+     *        Only streams backed by positional file writes (`pwrite`) support this, so out-of-order writers
+     *        can fill a file; the default implementation does not.
+     *
+     * @param offset Offset from the beginning of the stream.
+     * @param buffer Data to write.
+     * @param len Number of bytes to write.
+     * @return bool `false` if not supported, or the write failed.
+     */
+    [[nodiscard]] virtual bool WriteAt(size_t /*offset*/, const uint8_t * /*buffer*/, size_t /*len*/)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Check if `WriteAt` can be called from multiple threads at the same time.
+     */
+    virtual bool IsConcurrentWriteAtSupported()
+    {
+        return false;
+    }
+
+    /**
+     * @brief Reserve the next `len` bytes of the stream, to be filled with `WriteAt`: write out what `Write`
+     *        buffered, then move the cursor used by `Write` past the reserved range.
+     *
+     * @param len Number of bytes to reserve.
+     * @param offset Receives the offset of the reserved range, from the beginning of the stream.
+     * @return bool `false` if not supported, or the buffered data could not be written.
+     */
+    [[nodiscard]] virtual bool ReserveForWriteAt(size_t /*len*/, size_t & /*offset*/)
+    {
+        return false;
+    }
 };
 
 } // namespace parakeet_crypto
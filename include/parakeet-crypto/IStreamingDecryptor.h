@@ -0,0 +1,50 @@
+#pragma once
+
+#include "IStream.h"
+#include "TransformResult.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto
+{
+
+/**
+ * @brief Push-style decryptor: encrypted data is fed in chunks of any size, in order, and decrypted data is written
+ *        out as soon as possible. Created by `ITransformer::CreateStreamingDecryptor`.
+ *
+ * Only a few bytes are held back between calls: the file header until it can be parsed, and the partial cipher
+ * block for block ciphers.
+ */
+class IStreamingDecryptor
+{
+  public:
+    virtual ~IStreamingDecryptor() = default;
+
+    /**
+     * @brief Get decryptor name.
+     *
+     * @return const char*
+     */
+    [[nodiscard]] virtual const char *GetName() const = 0;
+
+    /**
+     * @brief Feed the next chunk of the encrypted file.
+     *
+     * @param input Encrypted data, following the previous chunk.
+     * @param len Size of `input`; can be `0`.
+     * @param output Receives the data decrypted so far.
+     * @return TransformResult Once an error is returned, every later call returns it too.
+     */
+    virtual TransformResult Update(const uint8_t *input, size_t len, IWriteable *output) = 0;
+
+    /**
+     * @brief Signal the end of the encrypted file, and write the remaining decrypted data.
+     *        Call it once, after the last `Update`.
+     *
+     * @return TransformResult `ERROR_INSUFFICIENT_INPUT` if the file was truncated.
+     */
+    virtual TransformResult Final(IWriteable *output) = 0;
+};
+
+} // namespace parakeet_crypto
@@ -1,22 +1,17 @@
 #pragma once
 
+#include "IRandomAccessDecryptor.h"
 #include "IStream.h"
+#include "IStreamingDecryptor.h"
+#include "TransformResult.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
 namespace parakeet_crypto
 {
 
-enum class TransformResult
-{
-    OK = 0,
-    ERROR_OTHER = 1,
-    ERROR_INSUFFICIENT_OUTPUT = 2,
-    ERROR_INVALID_FORMAT = 3,
-    ERROR_INVALID_KEY = 4, // Failed to decrypt content, etc.
-    ERROR_INSUFFICIENT_INPUT = 5,
-    ERROR_IO_OUTPUT_UNKNOWN = 6,
-    ERROR_NOT_IMPLEMENTED = 0xff,
-};
-
 class ITransformer
 {
   public:
@@ -30,15 +25,50 @@ class ITransformer
     virtual const char* GetName() = 0;
 
     /**
-     * @brief Transform a given block of data.
+     * @brief Transform a given stream.
      *
-     * @param output Output buffer.
-     * @param output_len Output size. Use `0` to get the output size.
-     * @param input Input buffer.
-     * @param input_len Input buffer size.
+     * @param output Output stream.
+     * @param input Input stream. The encrypted file starts at its current position, e.g. after a container header.
      * @return TransformResult
      */
     virtual TransformResult Transform(IWriteable *output, IReadSeekable *input) = 0;
+
+    /**
+     * @brief Transform a given block of data.
+     *
+     * @param output Output buffer. Can be `nullptr` when `output_len` is `0`.
+     * @param output_len Output buffer size. Use `0` to get the output size.
+     *                   Receives the number of bytes written, or the required size on `ERROR_INSUFFICIENT_OUTPUT`.
+     * @param input Input buffer, the whole encrypted file.
+     * @param input_len Input buffer size.
+     * @return TransformResult `ERROR_INSUFFICIENT_OUTPUT` if `output` is too small; nothing useful was written.
+     */
+    virtual TransformResult Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len);
+
+    /**
+     * @brief Parse the header of an encrypted file, and create a decryptor that can decrypt any range of its payload.
+     *
+     * @param decryptor Receives the decryptor on success.
+     * @param input The encrypted file, starting at its current position. The cursor position is not preserved.
+     * @return TransformResult `ERROR_NOT_IMPLEMENTED` if the format can only be decrypted sequentially.
+     */
+    virtual TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> & /*decryptor*/,
+                                                        IReadSeekable * /*input*/)
+    {
+        return TransformResult::ERROR_NOT_IMPLEMENTED;
+    }
+
+    /**
+     * @brief Create a push-style decryptor, for encrypted data arriving in chunks (e.g. from a socket).
+     *        The decryptor keeps a reference to this transformer, which must outlive it.
+     *
+     * @param decryptor Receives the decryptor on success.
+     * @return TransformResult `ERROR_NOT_IMPLEMENTED` if the format needs to seek (e.g. key in the footer).
+     */
+    virtual TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> & /*decryptor*/)
+    {
+        return TransformResult::ERROR_NOT_IMPLEMENTED;
+    }
 };
 
 } // namespace parakeet_crypto
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+/**
+ * @brief Derivations that can be cached. Part of the cache key: the same input bytes never collide across kinds.
+ */
+enum class KeyDerivationKind : uint8_t
+{
+    JOOX_V4_PBKDF2 = 1,    // PBKDF2-HMAC-SHA1 of install uuid and salt.
+    KGM_V4_SLOT_KEY = 2,   // MD5, hex, base64, then key expansion with the slot key table.
+    KGM_V4_FILE_KEY = 3,   // Key expansion with the file key table.
+    QMC2_EKEY = 4,         // base64, TEA (EncV2), then TEA-CBC.
+    MIGU3D_FILE_KEY = 5,   // MD5 of salt and file key.
+    QINGTING_FM_DEVICE = 6 // Device secret key from the device properties.
+};
+
+struct KeyDerivationCacheStats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    size_t entry_count{0};
+};
+
+/**
+ * @brief Bounded LRU cache of derived keys, keyed by the derivation kind and all of its inputs.
+ *        Share one instance between transformers (see the `key_cache` parameters of the factory functions) to
+ *        skip the derivations repeated for each file or transformer.
+ *
+ * Thread-safe. Derived keys are immutable once inserted, and handed out as shared pointers.
+ */
+class KeyDerivationCache
+{
+  public:
+    using Key = std::shared_ptr<const std::vector<uint8_t>>;
+    using DeriveFunction = std::function<std::vector<uint8_t>()>;
+
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    /**
+     * @param capacity Maximum number of derived keys to keep.
+     */
+    explicit KeyDerivationCache(size_t capacity = kDefaultCapacity);
+    KeyDerivationCache(const KeyDerivationCache &) = delete;
+    KeyDerivationCache(KeyDerivationCache &&) = delete;
+    KeyDerivationCache &operator=(const KeyDerivationCache &) = delete;
+    KeyDerivationCache &operator=(KeyDerivationCache &&) = delete;
+    ~KeyDerivationCache() = default;
+
+    /**
+     * @brief Look up a derived key, or derive and insert it.
+     *        `derive` runs without the lock held: concurrent misses for the same input may each derive it once.
+     *        An empty result means that the derivation failed, and is not cached.
+     *
+     * @param input All the inputs of the derivation, see `MakeKeyDerivationInput`.
+     */
+    Key GetOrDerive(KeyDerivationKind kind, const std::vector<uint8_t> &input, const DeriveFunction &derive);
+
+    /**
+     * @brief Drop all entries. Counters are kept.
+     */
+    void Clear();
+
+    [[nodiscard]] KeyDerivationCacheStats GetStats() const;
+
+  private:
+    using Entry = std::pair<std::string, Key>;
+
+    mutable std::mutex mutex_{};
+    std::list<Entry> lru_{}; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_{};
+    size_t capacity_{0};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+/**
+ * @brief Concatenate the inputs of a derivation, each prefixed with its size so that no two lists of inputs
+ *        produce the same bytes.
+ */
+inline std::vector<uint8_t> MakeKeyDerivationInput(std::initializer_list<std::pair<const void *, size_t>> parts)
+{
+    std::vector<uint8_t> result{};
+    for (const auto &[data, len] : parts)
+    {
+        auto len64 = static_cast<uint64_t>(len);
+        for (size_t i = 0; i < sizeof(len64); i++)
+        {
+            result.push_back(static_cast<uint8_t>(len64 >> (i * 8))); // NOLINT(*-magic-numbers)
+        }
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        result.insert(result.end(), bytes, bytes + len);
+    }
+    return result;
+}
+
+/**
+ * @brief Run `derive` through `cache` when one is given, or directly otherwise.
+ */
+inline std::vector<uint8_t> DeriveKey(KeyDerivationCache *cache, KeyDerivationKind kind,
+                                      const std::vector<uint8_t> &input,
+                                      const KeyDerivationCache::DeriveFunction &derive)
+{
+    if (cache == nullptr)
+    {
+        return derive();
+    }
+
+    auto key = cache->GetOrDerive(kind, input, derive);
+    return key ? *key : std::vector<uint8_t>{};
+}
+
+} // namespace parakeet_crypto
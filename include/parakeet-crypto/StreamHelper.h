@@ -1,17 +1,32 @@
+#pragma once
+
 #include "IStream.h"
+#include "IStreamingDecryptor.h"
+#include "TransformResult.h"
 #include "parakeet-crypto/IStream.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace parakeet_crypto
 {
 
+/**
+ * @brief Size of the reads from pipes (e.g. stdin).
+ */
+constexpr size_t kPipeReadSize = 0x10000;
+
 class InputFileStream final : public IReadSeekable
 {
   private:
     std::ifstream &ifs_;
+    size_t size_{0};
+    bool size_known_{false};
 
   public:
     InputFileStream(std::ifstream &ifs) : ifs_(ifs)
@@ -34,11 +49,16 @@ class InputFileStream final : public IReadSeekable
     }
     size_t GetSize() override
     {
-        auto pos = ifs_.tellg();
-        ifs_.seekg(0, std::ifstream::end);
-        auto size = ifs_.tellg();
-        ifs_.seekg(pos, std::ifstream::beg);
-        return size;
+        // Measured once: seeking to the end and back on every call is costly, and the input is not expected to grow.
+        if (!size_known_)
+        {
+            auto pos = ifs_.tellg();
+            ifs_.seekg(0, std::ifstream::end);
+            size_ = ifs_.tellg();
+            ifs_.seekg(pos, std::ifstream::beg);
+            size_known_ = true;
+        }
+        return size_;
     }
     size_t GetOffset() override
     {
@@ -46,6 +66,260 @@ class InputFileStream final : public IReadSeekable
     }
 };
 
+/**
+ * @brief Read-only, memory-mapped file.
+ *        The mapped pages can be accessed directly through `GetContiguousView`, so transformers
+ *        can decrypt straight from the page cache without an intermediate copy.
+ */
+class MappedFileStream final : public IReadSeekable
+{
+  private:
+    const uint8_t *data_{nullptr};
+    size_t size_{0};
+    size_t offset_{0};
+
+#if _WIN32
+    void *file_handle_{nullptr};
+    void *mapping_handle_{nullptr};
+#endif
+
+    MappedFileStream() = default;
+
+  public:
+    MappedFileStream(const MappedFileStream &) = delete;
+    MappedFileStream(MappedFileStream &&) = delete;
+    MappedFileStream &operator=(const MappedFileStream &) = delete;
+    MappedFileStream &operator=(MappedFileStream &&) = delete;
+    ~MappedFileStream() override;
+
+    /**
+     * @brief Map a file to memory.
+     *
+     * @param path Path to the file.
+     * @return std::unique_ptr<MappedFileStream> `nullptr` if the file could not be opened or mapped.
+     */
+    static std::unique_ptr<MappedFileStream> Open(const char *path);
+
+    size_t Read(uint8_t *buffer, size_t len) override
+    {
+        auto actual_read = std::min(len, size_ - offset_);
+        std::copy_n(data_ + offset_, actual_read, buffer);
+        offset_ += actual_read;
+        return actual_read;
+    }
+    void Seek(size_t position, SeekDirection seek_dir) override
+    {
+        size_t next_offset{0};
+        switch (seek_dir)
+        {
+        case SeekDirection::SEEK_FILE_BEGIN:
+            next_offset = position;
+            break;
+        case SeekDirection::SEEK_CURRENT_POSITION:
+            next_offset = offset_ + position;
+            break;
+        case SeekDirection::SEEK_FILE_END:
+            next_offset = size_ + position;
+            break;
+        default:
+            return;
+        }
+
+        offset_ = std::min(next_offset, size_);
+    }
+    size_t GetSize() override
+    {
+        return size_;
+    }
+    size_t GetOffset() override
+    {
+        return offset_;
+    }
+    const uint8_t *GetContiguousView(size_t offset, size_t len) override
+    {
+        if (offset > size_ || len > size_ - offset)
+        {
+            return nullptr;
+        }
+        return data_ + offset;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override
+    {
+        if (offset >= size_)
+        {
+            return 0;
+        }
+        auto actual_read = std::min(len, size_ - offset);
+        std::copy_n(data_ + offset, actual_read, buffer);
+        return actual_read;
+    }
+    bool IsConcurrentReadAtSupported() override
+    {
+        return true;
+    }
+};
+
+/**
+ * @brief File stream on top of a file descriptor, using positional reads (`pread`).
+ *        Neither `Read` nor `ReadAt` use the file offset of the descriptor,
+ *        so `ReadAt` can be called from multiple threads sharing this stream.
+ *        The file size is read once, when the stream is created.
+ */
+class InputFDStream final : public IReadSeekable
+{
+  private:
+    int fd_{-1};
+    bool owns_fd_{false};
+    size_t offset_{0};
+    size_t size_{0};
+
+  public:
+    /**
+     * @param fd File descriptor, opened for reading.
+     * @param owns_fd Close the file descriptor when this stream is destroyed.
+     */
+    InputFDStream(int fd, bool owns_fd = false);
+    InputFDStream(const InputFDStream &) = delete;
+    InputFDStream(InputFDStream &&) = delete;
+    InputFDStream &operator=(const InputFDStream &) = delete;
+    InputFDStream &operator=(InputFDStream &&) = delete;
+    ~InputFDStream() override;
+
+    /**
+     * @brief Open a file for reading, and advise the OS that it will be read sequentially
+     *        (`posix_fadvise`), for a larger read-ahead.
+     *
+     * @param path Path to the file.
+     * @return std::unique_ptr<InputFDStream> `nullptr` if the file could not be opened.
+     */
+    static std::unique_ptr<InputFDStream> Open(const char *path);
+
+    size_t Read(uint8_t *buffer, size_t len) override
+    {
+        auto bytes_read = ReadAt(offset_, buffer, len);
+        offset_ += bytes_read;
+        return bytes_read;
+    }
+    void Seek(size_t position, SeekDirection seek_dir) override
+    {
+        switch (seek_dir)
+        {
+        case SeekDirection::SEEK_FILE_BEGIN:
+            offset_ = position;
+            break;
+        case SeekDirection::SEEK_CURRENT_POSITION:
+            offset_ += position;
+            break;
+        case SeekDirection::SEEK_FILE_END:
+            offset_ = GetSize() + position;
+            break;
+        default:
+            return;
+        }
+    }
+    size_t GetSize() override
+    {
+        return size_;
+    }
+    size_t GetOffset() override
+    {
+        return offset_;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override;
+    bool IsConcurrentReadAtSupported() override
+    {
+        return true;
+    }
+
+    [[nodiscard]] int GetFD() const
+    {
+        return fd_;
+    }
+};
+
+/**
+ * @brief Output file stream on top of a file descriptor, using positional writes (`pwrite`).
+ *        `Write` appends through a large buffer, so small writes from transformers become few system calls;
+ *        `WriteAt` goes straight to the file, and can be called from multiple threads (e.g. workers filling
+ *        a preallocated file out of order). They should not be used on overlapping ranges.
+ */
+class OutputFDStream final : public IWriteable
+{
+  private:
+    int fd_{-1};
+    bool owns_fd_{false};
+    size_t offset_{0}; // file offset of `buffer_[0]`
+    size_t buffered_len_{0};
+    std::vector<uint8_t> buffer_{};
+
+  public:
+    /**
+     * @brief Size of the buffer used by `Write`.
+     */
+    static constexpr size_t kWriteBufferSize = static_cast<size_t>(1024 * 1024);
+
+    /**
+     * @param fd File descriptor, opened for writing.
+     * @param owns_fd Close the file descriptor when this stream is destroyed.
+     */
+    OutputFDStream(int fd, bool owns_fd = false) : fd_(fd), owns_fd_(owns_fd)
+    {
+    }
+    OutputFDStream(const OutputFDStream &) = delete;
+    OutputFDStream(OutputFDStream &&) = delete;
+    OutputFDStream &operator=(const OutputFDStream &) = delete;
+    OutputFDStream &operator=(OutputFDStream &&) = delete;
+
+    /**
+     * @brief Flush the buffered data, then close the file descriptor if owned.
+     *        Call `Flush` first to check that the buffered data was written.
+     */
+    ~OutputFDStream() override;
+
+    /**
+     * @brief Create (or truncate) a file for writing.
+     *
+     * @param path Path to the file.
+     * @return std::unique_ptr<OutputFDStream> `nullptr` if the file could not be opened.
+     */
+    static std::unique_ptr<OutputFDStream> Open(const char *path);
+
+    bool Write(const uint8_t *buffer, size_t len) override;
+    bool WriteAt(size_t offset, const uint8_t *buffer, size_t len) override;
+    bool IsConcurrentWriteAtSupported() override
+    {
+        return true;
+    }
+    bool ReserveForWriteAt(size_t len, size_t &offset) override;
+
+    /**
+     * @brief Write the data buffered by `Write` to the file. On failure, the data stays buffered.
+     */
+    [[nodiscard]] bool Flush();
+
+    /**
+     * @brief Reserve disk space for the final file size (`fallocate`), to reduce fragmentation and fail early when
+     *        the disk is full. The file size itself is unchanged, and grows as data is written.
+     *
+     * @param size Final size of the file.
+     * @return bool `false` if not supported by the platform or file system; writing still works.
+     */
+    bool Preallocate(size_t size);
+
+    /**
+     * @brief Offset of the next `Write`.
+     */
+    [[nodiscard]] size_t GetOffset() const
+    {
+        return offset_ + buffered_len_;
+    }
+
+    [[nodiscard]] int GetFD() const
+    {
+        return fd_;
+    }
+};
+
 class OutputFileStream final : public IWriteable
 {
   private:
@@ -85,7 +359,7 @@ class InputMemoryStream final : public IReadSeekable
     size_t Read(uint8_t *buffer, size_t len) override
     {
         auto actual_read = std::min(len, data_.size() - offset_);
-        std::copy_n(&data_.at(offset_), actual_read, buffer);
+        std::copy_n(data_.data() + offset_, actual_read, buffer);
         offset_ += actual_read;
         return actual_read;
     }
@@ -117,22 +391,128 @@ class InputMemoryStream final : public IReadSeekable
     {
         return offset_;
     }
+    const uint8_t *GetContiguousView(size_t offset, size_t len) override
+    {
+        if (offset > data_.size() || len > data_.size() - offset)
+        {
+            return nullptr;
+        }
+        return data_.data() + offset;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override
+    {
+        if (offset >= data_.size())
+        {
+            return 0;
+        }
+        auto actual_read = std::min(len, data_.size() - offset);
+        std::copy_n(data_.data() + offset, actual_read, buffer);
+        return actual_read;
+    }
+    bool IsConcurrentReadAtSupported() override
+    {
+        return true;
+    }
 
+    /**
+     * @brief Read the whole stdin to memory.
+     *        For large inputs, prefer `StreamingDecryptFromFile`, which only keeps a chunk in memory.
+     */
     static std::unique_ptr<InputMemoryStream> FromStdin()
     {
-        std::vector<uint8_t> input_data{};
-        uint8_t buffer[1024]{};
+        auto stream = std::make_unique<InputMemoryStream>();
+        auto &input_data = stream->GetData();
+        std::vector<uint8_t> buffer(kPipeReadSize);
 
-        while (!feof(stdin))
+        size_t bytes_read{0};
+        while ((bytes_read = fread(buffer.data(), 1, buffer.size(), stdin)) > 0)
         {
-            auto bytes_read = fread(buffer, 1, sizeof(buffer), stdin);
-            input_data.insert(input_data.end(), buffer, &buffer[bytes_read]);
+            input_data.insert(input_data.end(), buffer.data(), buffer.data() + bytes_read);
         }
 
-        return std::make_unique<InputMemoryStream>(input_data);
+        return stream;
+    }
+};
+
+/**
+ * @brief Read-only view over a caller-owned buffer; nothing is copied.
+ *        The buffer must outlive this stream.
+ */
+class InputMemoryViewStream final : public IReadSeekable
+{
+  private:
+    const uint8_t *data_{nullptr};
+    size_t size_{0};
+    size_t offset_{0};
+
+  public:
+    InputMemoryViewStream(const uint8_t *data, size_t size) : data_(data), size_(size)
+    {
+    }
+
+    size_t Read(uint8_t *buffer, size_t len) override
+    {
+        auto actual_read = std::min(len, size_ - offset_);
+        std::copy_n(data_ + offset_, actual_read, buffer);
+        offset_ += actual_read;
+        return actual_read;
+    }
+    void Seek(size_t position, SeekDirection seek_dir) override
+    {
+        size_t next_offset{0};
+        switch (seek_dir)
+        {
+        case SeekDirection::SEEK_FILE_BEGIN:
+            next_offset = position;
+            break;
+        case SeekDirection::SEEK_CURRENT_POSITION:
+            next_offset = offset_ + position;
+            break;
+        case SeekDirection::SEEK_FILE_END:
+            next_offset = size_ + position;
+            break;
+        default:
+            return;
+        }
+
+        offset_ = std::min(next_offset, size_);
+    }
+    size_t GetSize() override
+    {
+        return size_;
+    }
+    size_t GetOffset() override
+    {
+        return offset_;
+    }
+    const uint8_t *GetContiguousView(size_t offset, size_t len) override
+    {
+        if (offset > size_ || len > size_ - offset)
+        {
+            return nullptr;
+        }
+        return data_ + offset;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override
+    {
+        if (offset >= size_)
+        {
+            return 0;
+        }
+        auto actual_read = std::min(len, size_ - offset);
+        std::copy_n(data_ + offset, actual_read, buffer);
+        return actual_read;
+    }
+    bool IsConcurrentReadAtSupported() override
+    {
+        return true;
     }
 };
 
+/**
+ * @brief A window `[start_index, end_index)` of the parent stream.
+ *        Offsets are relative to `start_index`, e.g. `Seek(0, SEEK_FILE_BEGIN)` moves the parent to `start_index`.
+ */
 class SlicedReadableStream final : public IReadSeekable
 {
   private:
@@ -142,14 +522,24 @@ class SlicedReadableStream final : public IReadSeekable
 
   public:
     SlicedReadableStream(IReadSeekable &parent, size_t start_index, size_t end_index)
-        : parent_(parent), start_(start_index), end_(end_index)
+        : parent_(parent), start_(start_index), end_(std::max(start_index, end_index))
     {
     }
 
     size_t Read(uint8_t *buffer, size_t len) override
     {
-        auto offset = GetOffset();
-        size_t read_len = std::min(end_ - offset, len);
+        auto parent_offset = parent_.GetOffset();
+        if (parent_offset < start_)
+        {
+            parent_offset = start_;
+            parent_.Seek(start_, SeekDirection::SEEK_FILE_BEGIN);
+        }
+        if (parent_offset >= end_)
+        {
+            return 0;
+        }
+
+        size_t read_len = std::min(end_ - parent_offset, len);
         return parent_.Read(buffer, read_len);
     }
 
@@ -162,16 +552,16 @@ class SlicedReadableStream final : public IReadSeekable
             next_offset = position;
             break;
         case SeekDirection::SEEK_CURRENT_POSITION:
-            next_offset = parent_.GetOffset() + position;
+            next_offset = GetOffset() + position;
             break;
         case SeekDirection::SEEK_FILE_END:
-            next_offset = end_ + position;
+            next_offset = GetSize() + position;
             break;
         default:
             return;
         }
 
-        parent_.Seek(std::max(std::min(next_offset, end_), start_), SeekDirection::SEEK_FILE_BEGIN);
+        parent_.Seek(start_ + std::min(next_offset, GetSize()), SeekDirection::SEEK_FILE_BEGIN);
     }
     size_t GetSize() override
     {
@@ -180,13 +570,27 @@ class SlicedReadableStream final : public IReadSeekable
     size_t GetOffset() override
     {
         auto offset = parent_.GetOffset();
-        if (offset < start_)
+        return std::min(std::max(offset, start_), end_) - start_;
+    }
+    const uint8_t *GetContiguousView(size_t offset, size_t len) override
+    {
+        if (offset > GetSize() || len > GetSize() - offset)
         {
-            offset = start_;
-            parent_.Seek(start_, SeekDirection::SEEK_FILE_BEGIN);
+            return nullptr;
         }
-
-        return std::min(offset, end_);
+        return parent_.GetContiguousView(start_ + offset, len);
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override
+    {
+        if (offset >= GetSize())
+        {
+            return 0;
+        }
+        return parent_.ReadAt(start_ + offset, buffer, std::min(len, GetSize() - offset));
+    }
+    bool IsConcurrentReadAtSupported() override
+    {
+        return parent_.IsConcurrentReadAtSupported();
     }
 };
 
@@ -214,6 +618,46 @@ class OutputMemoryStream final : public IWriteable
     }
 };
 
+/**
+ * @brief Writes to a caller-owned buffer of fixed capacity.
+ *        Bytes past the capacity are dropped but still counted, so the required size is known after a full pass.
+ */
+class OutputBufferStream final : public IWriteable
+{
+  private:
+    uint8_t *data_{nullptr};
+    size_t capacity_{0};
+    size_t bytes_written_{0};
+
+  public:
+    OutputBufferStream(uint8_t *data, size_t capacity) : data_(data), capacity_(capacity)
+    {
+    }
+
+    bool Write(const uint8_t *buffer, size_t len) override
+    {
+        if (bytes_written_ < capacity_)
+        {
+            std::copy_n(buffer, std::min(len, capacity_ - bytes_written_), data_ + bytes_written_);
+        }
+        bytes_written_ += len;
+        return true;
+    }
+
+    /**
+     * @brief Total number of bytes written, including the ones that did not fit.
+     */
+    [[nodiscard]] size_t GetBytesWritten() const
+    {
+        return bytes_written_;
+    }
+
+    [[nodiscard]] bool IsOverflow() const
+    {
+        return bytes_written_ > capacity_;
+    }
+};
+
 class WriteToStdoutStream final : public IWriteable
 {
   public:
@@ -252,4 +696,33 @@ class CappedOutputStream final : public IWriteable
     }
 };
 
+/**
+ * @brief Decrypt a file that can only be read sequentially (e.g. stdin, a pipe or a socket), a chunk at a time.
+ *        Memory use is bounded by the chunk size, plus what the decryptor holds back (see `IStreamingDecryptor`).
+ *
+ * @param decryptor Decryptor created by `ITransformer::CreateStreamingDecryptor`.
+ * @param input File to read until the end.
+ * @param output Decrypted output.
+ * @return TransformResult `ERROR_INSUFFICIENT_INPUT` on read error.
+ */
+inline TransformResult StreamingDecryptFromFile(IStreamingDecryptor &decryptor, FILE *input, IWriteable *output)
+{
+    std::vector<uint8_t> buffer(kPipeReadSize);
+
+    size_t bytes_read{0};
+    while ((bytes_read = fread(buffer.data(), 1, buffer.size(), input)) > 0)
+    {
+        if (auto result = decryptor.Update(buffer.data(), bytes_read, output); result != TransformResult::OK)
+        {
+            return result;
+        }
+    }
+    if (ferror(input) != 0)
+    {
+        return TransformResult::ERROR_INSUFFICIENT_INPUT;
+    }
+
+    return decryptor.Final(output);
+}
+
 }; // namespace parakeet_crypto
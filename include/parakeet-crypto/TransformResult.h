@@ -0,0 +1,18 @@
+#pragma once
+
+namespace parakeet_crypto
+{
+
+enum class TransformResult
+{
+    OK = 0,
+    ERROR_OTHER = 1,
+    ERROR_INSUFFICIENT_OUTPUT = 2,
+    ERROR_INVALID_FORMAT = 3,
+    ERROR_INVALID_KEY = 4, // Failed to decrypt content, etc.
+    ERROR_INSUFFICIENT_INPUT = 5,
+    ERROR_IO_OUTPUT_UNKNOWN = 6,
+    ERROR_NOT_IMPLEMENTED = 0xff,
+};
+
+} // namespace parakeet_crypto
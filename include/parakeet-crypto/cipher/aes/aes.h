@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::cipher::aes
@@ -26,6 +27,25 @@ enum class CRYPTO_MODE : int
     Encrypt = 1,
 };
 
+enum class AESBackend : int
+{
+    REFERENCE = 0, // byte-wise, one block at a time (tiny-AES-c)
+    TTABLE,        // portable 32-bit lookup tables
+    AESNI,         // x86 AES-NI, several blocks in flight
+};
+
+/**
+ * @brief Check if the CPU can run the given backend.
+ */
+bool IsAESBackendSupported(AESBackend backend);
+
+/**
+ * @brief The fastest supported backend, detected on first use. This is the default of every new `AES` instance.
+ */
+AESBackend GetAESBackend();
+
+const char *GetAESBackendName(AESBackend backend);
+
 namespace detail
 {
 
@@ -87,8 +107,11 @@ class AES : public BlockCipher<detail::AESConfig<kKeySizeInBytes>::kBlockSize>
   private:
     std::array<uint8_t, CONFIG::kBlockSize> buffer_{};
     size_t buffer_idx_{0};
+    AESBackend backend_{GetAESBackend()};
 
   public:
+    using BlockCipher<CONFIG::kBlockSize>::TransformBlocks;
+
     AES() = default;
     inline AES(const uint8_t *key)
     {
@@ -106,6 +129,7 @@ class AES : public BlockCipher<detail::AESConfig<kKeySizeInBytes>::kBlockSize>
     ~AES() override
     {
         std::fill(key_.begin(), key_.end(), 0);
+        std::fill(inv_key_.begin(), inv_key_.end(), 0);
     };
 
     inline std::array<uint8_t, CONFIG::kKeyExpansionSize> GetRoundKey()
@@ -120,10 +144,50 @@ class AES : public BlockCipher<detail::AESConfig<kKeySizeInBytes>::kBlockSize>
         SetKey(key.data());
     }
 
-    CipherErrorCode TransformBlock(uint8_t *buffer) override;
+    [[nodiscard]] AESBackend GetBackend() const
+    {
+        return backend_;
+    }
+
+    /**
+     * @brief Switch to another backend. All backends produce the same output.
+     * @return false The CPU can't run `backend` (see `IsAESBackendSupported`); the current backend is kept.
+     */
+    bool SetBackend(AESBackend backend)
+    {
+        if (!IsAESBackendSupported(backend))
+        {
+            return false;
+        }
+        backend_ = backend;
+        return true;
+    }
+
+    CipherErrorCode TransformBlock(uint8_t *buffer) override
+    {
+        return std::as_const(*this).TransformBlock(buffer);
+    }
+    CipherErrorCode TransformBlocks(uint8_t *buffer, size_t n) override
+    {
+        return std::as_const(*this).TransformBlocks(buffer, n);
+    }
+
+    /**
+     * @brief Transform blocks in place. Only reads the round keys: an instance can be shared by several threads.
+     */
+    [[nodiscard]] CipherErrorCode TransformBlock(uint8_t *buffer) const;
+    [[nodiscard]] CipherErrorCode TransformBlocks(uint8_t *buffer, size_t n) const;
+    template <typename Container> [[nodiscard]] inline CipherErrorCode TransformBlocks(Container &buffer) const
+    {
+        return TransformBlocks(buffer.data(), buffer.size());
+    }
 
   private:
     std::array<uint8_t, CONFIG::kKeyExpansionSize> key_{};
+
+    // Decryption only: the round keys of the equivalent inverse cipher, in the order they are applied
+    //   (`InvMixColumns` applied to the inner round keys), as used by the T-table and AES-NI backends.
+    std::array<uint8_t, CONFIG::kKeyExpansionSize> inv_key_{};
 };
 
 using AES128Dec = AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>;
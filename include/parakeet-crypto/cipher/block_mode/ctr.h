@@ -28,6 +28,42 @@ template <typename Container> inline void increment_iv(Container &iv_array)
     }
 }
 
+/**
+ * Add `count` to the IV, as a big-endian integer: the same as `count` calls to `increment_iv`.
+ */
+template <typename Container> inline void add_to_iv(Container &iv_array, uint64_t count)
+{
+    constexpr uint64_t kByteMask = 0xFF;
+    constexpr unsigned kByteBits = 8;
+    for (auto it = iv_array.rbegin(); it != iv_array.rend() && count != 0; ++it)
+    {
+        auto sum = uint64_t{*it} + (count & kByteMask);
+        *it = static_cast<uint8_t>(sum);
+        count = (count >> kByteBits) + (sum >> kByteBits);
+    }
+}
+
+/**
+ * Number of keystream blocks generated by a single call to the parent cipher.
+ */
+constexpr size_t kKeystreamBatchBlocks = 32;
+
+/**
+ * Encrypt `n_blocks` consecutive counters, starting from `iv_array`, to `keystream` with a single `TransformBlocks`
+ * call (so that the parent cipher can process them in parallel); the IV is moved past them.
+ */
+template <typename ParentCipher, typename Container>
+inline CipherErrorCode generate_keystream(ParentCipher &cipher, Container &iv_array, uint8_t *keystream,
+                                          size_t n_blocks)
+{
+    for (size_t i = 0; i < n_blocks; i++)
+    {
+        std::copy(iv_array.begin(), iv_array.end(), &keystream[i * ParentCipher::block_size_]);
+        increment_iv(iv_array);
+    }
+    return cipher.TransformBlocks(keystream, n_blocks * ParentCipher::block_size_);
+}
+
 inline void xor_bytes(uint8_t *output, const uint8_t *input, size_t n)
 {
     while (n-- != 0)
@@ -60,15 +96,34 @@ template <typename ParentCipher> class CTR : public BlockCipher<ParentCipher::bl
         std::copy_n(iv, ParentCipher::block_size_, iv_.begin());
     }
 
-    [[nodiscard]] CipherErrorCode TransformBlock(uint8_t *buffer)
+    using BlockCipher<ParentCipher::block_size_>::TransformBlocks;
+
+    [[nodiscard]] CipherErrorCode TransformBlock(uint8_t *buffer) override
+    {
+        return TransformBlocks(buffer, ParentCipher::block_size_);
+    }
+
+    [[nodiscard]] CipherErrorCode TransformBlocks(uint8_t *buffer, size_t n) override
     {
-        auto current_iv = iv_;
-        if (auto err = cipher_->TransformBlock(current_iv.data()); err != CipherError::kSuccess)
+        if (n % ParentCipher::block_size_ != 0)
         {
-            return err;
+            return CipherError::kIncompleteInputData;
+        }
+
+        while (n > 0)
+        {
+            std::array<uint8_t, ctr_impl_details::kKeystreamBatchBlocks * ParentCipher::block_size_> keystream{};
+            auto process_len = std::min(n, keystream.size());
+            auto n_blocks = process_len / ParentCipher::block_size_;
+            if (auto err = ctr_impl_details::generate_keystream(*cipher_, iv_, keystream.data(), n_blocks);
+                err != CipherError::kSuccess)
+            {
+                return err;
+            }
+            ctr_impl_details::xor_bytes(buffer, keystream.data(), process_len);
+            buffer += process_len;
+            n -= process_len;
         }
-        ctr_impl_details::xor_bytes(buffer, current_iv.data(), ParentCipher::block_size_);
-        ctr_impl_details::increment_iv(iv_);
         return CipherError::kSuccess;
     }
 
@@ -91,7 +146,8 @@ template <typename ParentCipher> class CTR_Stream : public Cipher
             throw std::invalid_argument("cipher cannot be nullptr");
         }
 
-        std::copy_n(iv, ParentCipher::block_size_, iv_.begin());
+        std::copy_n(iv, ParentCipher::block_size_, initial_iv_.begin());
+        iv_ = initial_iv_;
     }
 
     // NOLINTNEXTLINE(*-identifier-length)
@@ -103,11 +159,12 @@ template <typename ParentCipher> class CTR_Stream : public Cipher
             throw std::invalid_argument("cipher cannot be nullptr");
         }
 
-        std::copy_n(iv.cbegin(), ParentCipher::block_size_, iv_.begin());
+        std::copy_n(iv.cbegin(), ParentCipher::block_size_, initial_iv_.begin());
+        iv_ = initial_iv_;
     }
 
     // Seek from current position, positive offset only.
-    // This is used to update the IV in CTR mode.
+    // This is used to update the IV in CTR mode: whole blocks are skipped by adding to the counter, in constant time.
     inline CipherErrorCode Skip(size_t count)
     {
         if (auto bytes_left = GetBufferBytesLeft(); bytes_left > 0)
@@ -117,31 +174,32 @@ template <typename ParentCipher> class CTR_Stream : public Cipher
             buffer_offset_ = (buffer_offset_ + skip_len) % ParentCipher::block_size_;
         }
 
-        if (count >= ParentCipher::block_size_)
+        if (count == 0)
         {
-            buffer_offset_ = 0;
-        }
-        while (count >= ParentCipher::block_size_)
-        {
-            count -= ParentCipher::block_size_;
-            if (auto err = IncrementCounter(); err != CipherError::kSuccess)
-            {
-                return err;
-            }
+            return CipherError::kSuccess;
         }
 
-        if (count > 0)
+        ctr_impl_details::add_to_iv(iv_, count / ParentCipher::block_size_);
+        if (auto remainder = count % ParentCipher::block_size_; remainder > 0)
         {
             if (auto err = IncrementCounter(); err != CipherError::kSuccess)
             {
                 return err;
             }
-            buffer_offset_ = count;
+            buffer_offset_ = remainder;
         }
 
         return CipherError::kSuccess;
     }
 
+    // Seek to an absolute offset of the stream, the IV given to the constructor being offset 0. Constant time.
+    inline CipherErrorCode SeekTo(size_t offset)
+    {
+        iv_ = initial_iv_;
+        buffer_offset_ = 0;
+        return Skip(offset);
+    }
+
     [[nodiscard]] CipherErrorCode Update(uint8_t *output, size_t &n_output, const uint8_t *input, size_t n) override
     {
         if (n_output < n)
@@ -170,17 +228,31 @@ template <typename ParentCipher> class CTR_Stream : public Cipher
             increment_by_length(process_len);
         }
 
-        while (n > 0)
+        // Whole blocks: keystream is generated in batches.
+        while (n >= ParentCipher::block_size_)
         {
-            auto process_len = std::min(n, ParentCipher::block_size_);
-            if (auto err = IncrementCounter(); err != CipherError::kSuccess)
+            std::array<uint8_t, ctr_impl_details::kKeystreamBatchBlocks * ParentCipher::block_size_> keystream{};
+            auto process_len = std::min(n - n % ParentCipher::block_size_, keystream.size());
+            auto n_blocks = process_len / ParentCipher::block_size_;
+            if (auto err = ctr_impl_details::generate_keystream(*cipher_, iv_, keystream.data(), n_blocks);
+                err != CipherError::kSuccess)
             {
                 return err;
             }
-            ctr_impl_details::xor_bytes(output, input, buffer_.data(), process_len);
+            ctr_impl_details::xor_bytes(output, input, keystream.data(), process_len);
             increment_by_length(process_len);
         }
 
+        if (n > 0)
+        {
+            if (auto err = IncrementCounter(); err != CipherError::kSuccess)
+            {
+                return err;
+            }
+            ctr_impl_details::xor_bytes(output, input, buffer_.data(), n);
+            increment_by_length(n);
+        }
+
         return CipherError::kSuccess;
     }
 
@@ -198,6 +270,7 @@ template <typename ParentCipher> class CTR_Stream : public Cipher
 
   private:
     std::shared_ptr<ParentCipher> cipher_;
+    std::array<uint8_t, ParentCipher::block_size_> initial_iv_{};
     std::array<uint8_t, ParentCipher::block_size_> iv_{};
     std::array<uint8_t, ParentCipher::block_size_> buffer_{};
     size_t buffer_offset_{0};
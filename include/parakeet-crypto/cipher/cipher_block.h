@@ -10,6 +10,10 @@ namespace parakeet_crypto::cipher
 
 template <size_t kBlockSize> class BlockCipher : public Cipher
 {
+  private:
+    // Whole blocks passed to `TransformBlocks` at once by `Update`: a bounded copy, and many blocks per call.
+    static constexpr size_t kUpdateChunkSize = kBlockSize * 256;
+
   protected:
     // NOLINTBEGIN(*-non-private-member-variables-in-classes)
     std::array<uint8_t, kBlockSize> block_{};
@@ -21,7 +25,12 @@ template <size_t kBlockSize> class BlockCipher : public Cipher
     ~BlockCipher() override = default;
 
     [[nodiscard]] virtual CipherErrorCode TransformBlock(uint8_t *buffer) = 0;
-    [[nodiscard]] inline CipherErrorCode TransformBlocks(uint8_t *buffer, size_t n)
+
+    /**
+     * Transform `n` bytes in place, `n` being a multiple of the block size.
+     * Ciphers that can process several blocks at once should override this.
+     */
+    [[nodiscard]] virtual CipherErrorCode TransformBlocks(uint8_t *buffer, size_t n)
     {
         if (n % kBlockSize != 0)
         {
@@ -83,15 +92,16 @@ template <size_t kBlockSize> class BlockCipher : public Cipher
 
         while (n >= kBlockSize)
         {
-            std::copy_n(input, kBlockSize, output);
-            if (auto err = TransformBlock(output); err != CipherError::kSuccess)
+            auto len_process = std::min(n - n % kBlockSize, kUpdateChunkSize);
+            std::copy_n(input, len_process, output);
+            if (auto err = TransformBlocks(output, len_process); err != CipherError::kSuccess)
             {
                 return err;
             }
-            output += kBlockSize;
-            n_output += kBlockSize;
-            input += kBlockSize;
-            n -= kBlockSize;
+            output += len_process;
+            n_output += len_process;
+            input += len_process;
+            n -= len_process;
         }
 
         if (n != 0)
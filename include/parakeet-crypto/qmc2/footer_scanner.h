@@ -0,0 +1,129 @@
+#pragma once
+
+#include "footer_parser.h"
+#include "key_crypto.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace parakeet_crypto::qmc2
+{
+
+enum class FooterKind : uint8_t
+{
+    UNKNOWN = 0,
+    ANDROID_QTAG = 1, // ekey, song id
+    ANDROID_STAG = 2, // unsupported: no ekey
+    PC = 3,           // ekey
+    PC_MUSICEX = 4,   // media file name; the key is looked up elsewhere
+};
+
+// NOLINTBEGIN(*-non-private-member-variables-in-classes)
+
+/**
+ * @brief Footer of a single file, found by `QMCFooterScanner`.
+ */
+struct FooterScanEntry
+{
+    FooterParseState state{FooterParseState::UnknownContent};
+    FooterKind kind{FooterKind::UNKNOWN};
+
+    /**
+     * @brief Same as `FooterParseResult::footer_size`.
+     */
+    uint32_t footer_size{0};
+
+    /**
+     * @brief Size of `data` in `FooterScanResult::data`.
+     */
+    uint32_t data_len{0};
+
+    uint64_t file_size{0};
+
+    /**
+     * @brief Offset of `data` in `FooterScanResult::data`:
+     *        - ANDROID_QTAG, PC: the key, or the ekey as stored in the footer if the scanner has no key crypto;
+     *        - PC_MUSICEX: the media file name.
+     */
+    uint64_t data_offset{0};
+};
+
+/**
+ * @brief Footers of a list of files, in the same order. Keys and names are packed in a single buffer.
+ */
+struct FooterScanResult
+{
+    std::vector<FooterScanEntry> entries{};
+    std::vector<uint8_t> data{};
+
+    [[nodiscard]] const uint8_t *GetData(const FooterScanEntry &entry) const
+    {
+        return data.data() + entry.data_offset;
+    }
+
+    [[nodiscard]] std::string_view GetMediaFileName(const FooterScanEntry &entry) const
+    {
+        if (entry.kind != FooterKind::PC_MUSICEX)
+        {
+            return {};
+        }
+        // NOLINTNEXTLINE(*-reinterpret-cast)
+        return {reinterpret_cast<const char *>(GetData(entry)), entry.data_len};
+    }
+};
+
+// NOLINTEND(*-non-private-member-variables-in-classes)
+
+struct FooterScanOptions
+{
+    static constexpr size_t kDefaultTailSize = 1024;
+
+    /**
+     * @brief Bytes read from the end of each file. Larger footers take a second read, of the missing bytes only.
+     */
+    size_t tail_size{kDefaultTailSize};
+
+    /**
+     * @brief Number of files scanned (and ekeys decrypted) at the same time; `0` to use the number of CPU cores.
+     *        Scanning is mostly waiting for the disk: more threads than cores may help on network or cold storage.
+     */
+    size_t thread_count{0};
+};
+
+/**
+ * @brief Read the footers of many files (e.g. to index a library), without decrypting any audio.
+ *
+ * Only the tail of each file is read, with positional reads into a buffer reused per thread: no per-file stream
+ * or result object is allocated.
+ */
+class QMCFooterScanner
+{
+  public:
+    virtual ~QMCFooterScanner() = default;
+
+    /**
+     * @brief Files that cannot be opened are reported as `IOReadFailure`.
+     */
+    virtual FooterScanResult ScanFiles(const std::vector<std::string> &paths) = 0;
+
+    /**
+     * @brief Scan files already open for reading. The file descriptors are not closed.
+     */
+    virtual FooterScanResult ScanFDs(const std::vector<int> &fds) = 0;
+};
+
+/**
+ * @brief Create a footer scanner.
+ *
+ * @param key_crypto Used to decrypt the ekeys; `nullptr` to report the ekeys as found. `Decrypt` is called from
+ *                   several threads at once, and must be thread-safe (as the one from `CreateKeyCrypto` is).
+ * @return std::unique_ptr<QMCFooterScanner> `nullptr` if `options.tail_size` is 0.
+ */
+std::unique_ptr<QMCFooterScanner> CreateQMC2FooterScanner(std::shared_ptr<IKeyCrypto> key_crypto,
+                                                          const FooterScanOptions &options = {});
+
+} // namespace parakeet_crypto::qmc2
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "parakeet-crypto/KeyDerivationCache.h"
+
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -19,6 +21,13 @@ class IKeyCrypto
   public:
     virtual ~IKeyCrypto() = default;
 
+    /**
+     * @brief Decrypt an ekey, as stored in the file footer.
+     *        The implementations from `CreateKeyCrypto` keep no state between calls (the `KeyDerivationCache` has its
+     *        own lock), and can be called from several threads at once.
+     *
+     * @return std::vector<uint8_t> Empty if the ekey could not be decrypted.
+     */
     virtual std::vector<uint8_t> Decrypt(const uint8_t *key, size_t len) = 0;
     virtual std::vector<uint8_t> Encrypt(const uint8_t *key, size_t len, KeyVersion version) = 0;
 };
@@ -26,4 +35,10 @@ class IKeyCrypto
 static constexpr size_t kEncV2KeyLen = 16;
 std::unique_ptr<IKeyCrypto> CreateKeyCrypto(uint8_t seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2);
 
+/**
+ * @brief Same as above, with decrypted ekeys looked up in (or added to) `key_cache`.
+ */
+std::unique_ptr<IKeyCrypto> CreateKeyCrypto(uint8_t seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2,
+                                            std::shared_ptr<KeyDerivationCache> key_cache);
+
 } // namespace parakeet_crypto::qmc2
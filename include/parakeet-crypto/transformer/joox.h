@@ -1,6 +1,7 @@
 #pragma once
 
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 
 #include <array>
 #include <cstddef>
@@ -17,9 +18,21 @@ struct JooxConfig
 {
     std::string install_uuid;
     std::array<uint8_t, kJooxSaltLen> salt;
+
+    // Optional: shared cache of the PBKDF2 derived keys.
+    std::shared_ptr<KeyDerivationCache> key_cache{};
 };
 
 std::unique_ptr<ITransformer> CreateJooxDecryptionV4Transformer(JooxConfig config);
 std::unique_ptr<ITransformer> CreateJooxEncryptionV4Transformer(JooxConfig config);
 
+/**
+ * @brief Same as above, processing several 1MiB blocks of a file at once. Blocks are written in order, and each
+ *        thread holds one block in memory.
+ *
+ * @param thread_count Number of threads; `0` to use the number of CPU cores.
+ */
+std::unique_ptr<ITransformer> CreateJooxDecryptionV4Transformer(JooxConfig config, size_t thread_count);
+std::unique_ptr<ITransformer> CreateJooxEncryptionV4Transformer(JooxConfig config, size_t thread_count);
+
 } // namespace parakeet_crypto::transformer
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -21,6 +22,9 @@ struct KGMConfig
 {
     std::map<uint32_t, std::vector<uint8_t>> slot_keys{};
     KGMConfigV4 v4;
+
+    // Optional: shared cache of the v4 key expansions.
+    std::shared_ptr<KeyDerivationCache> key_cache{};
 };
 
 std::unique_ptr<ITransformer> CreateKGMDecryptionTransformer(KGMConfig config);
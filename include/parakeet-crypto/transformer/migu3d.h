@@ -1,6 +1,7 @@
 #pragma once
 
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 
 #include <cstdint>
 #include <memory>
@@ -19,6 +20,12 @@ namespace parakeet_crypto::transformer
  */
 std::unique_ptr<ITransformer> CreateMiguTransformer(const uint8_t* salt, const uint8_t* file_key);
 
+/**
+ * @brief Migu3D transformer, with the derived key looked up in (or added to) `key_cache`.
+ */
+std::unique_ptr<ITransformer> CreateMiguTransformer(const uint8_t *salt, const uint8_t *file_key,
+                                                    std::shared_ptr<KeyDerivationCache> key_cache);
+
 /**
  * @brief Migu3D transformer (keyless)
  * 
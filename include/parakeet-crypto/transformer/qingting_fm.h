@@ -1,7 +1,10 @@
 #pragma once
 
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -34,6 +37,25 @@ std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
     const char *filename, const char *product, const char *device, const char *manufacturer, const char *brand,
     const char *board, const char *model);
 
+/**
+ * Same as above, with the device secret key looked up in (or added to) `key_cache`.
+ */
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
+    const char *filename, const char *product, const char *device, const char *manufacturer, const char *brand,
+    const char *board, const char *model, std::shared_ptr<KeyDerivationCache> key_cache);
+
+/**
+ * Same as above, decrypting large files on several threads: each one seeks its own AES-CTR stream to a batch of the
+ * file. Batches are written in order, or as soon as ready when the output supports concurrent `IWriteable::WriteAt`
+ * (see `IWriteable::ReserveForWriteAt`).
+ *
+ * @param key_cache       Optional, can be nullptr.
+ * @param thread_count    Number of threads; `0` to use the number of CPU cores.
+ */
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
+    const char *filename, const char *product, const char *device, const char *manufacturer, const char *brand,
+    const char *board, const char *model, std::shared_ptr<KeyDerivationCache> key_cache, size_t thread_count);
+
 /**
  * Create QingTingFM transformer with file name and pre-computed device fingerprint.
  *
@@ -43,4 +65,12 @@ std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
 std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer(const char *filename,
                                                                  const uint8_t *device_fingerprint);
 
+/**
+ * Same as above, decrypting large files on several threads.
+ *
+ * @param thread_count Number of threads; `0` to use the number of CPU cores.
+ */
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
+    const char *filename, const uint8_t *device_fingerprint, size_t thread_count);
+
 } // namespace parakeet_crypto::transformer
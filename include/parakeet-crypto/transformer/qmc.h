@@ -13,8 +13,23 @@ namespace parakeet_crypto::transformer
 std::unique_ptr<ITransformer> CreateQMC1StaticDecryptionTransformer(const uint8_t *key, size_t key_len);
 
 std::unique_ptr<ITransformer> CreateQMC2MapDecryptionTransformer(const uint8_t *key, size_t key_len);
+/**
+ * @brief QMCv2 (RC4) decryption.
+ *
+ * @return std::unique_ptr<ITransformer> `nullptr` if `key_len` is `0`.
+ */
 std::unique_ptr<ITransformer> CreateQMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len);
 
+/**
+ * @brief QMCv2 (RC4) decryption on several threads: the segments of the payload are independent, and are decrypted
+ *        in batches by a pool of workers. Written in order, or as soon as ready when the output supports concurrent
+ *        `IWriteable::WriteAt` (see `IWriteable::ReserveForWriteAt`).
+ *
+ * @param thread_count Number of threads; `0` to use the number of CPU cores.
+ */
+std::unique_ptr<ITransformer> CreateQMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len,
+                                                                 size_t thread_count);
+
 /**
  * @brief Transformer wrapper that will run the stream through `CreateQMC2MapDecryptionTransformer`
  *        or `CreateQMC2RC4DecryptionTransformer` depending on the key size it has parsed.
@@ -23,6 +38,11 @@ std::unique_ptr<ITransformer> CreateQMC2RC4DecryptionTransformer(const uint8_t *
  * @return std::unique_ptr<ITransformer>
  */
 std::unique_ptr<ITransformer> CreateQMC2DecryptionTransformer(std::shared_ptr<qmc2::QMCFooterParser> footer_parser);
+
+/**
+ * @brief Same as above, with the key already known (e.g. from a database): the footer is still left out of the
+ *        output, but its ekey is not decrypted, so files whose footer key cannot be decrypted are trimmed too.
+ */
 std::unique_ptr<ITransformer> CreateQMC2DecryptionTransformer(std::shared_ptr<qmc2::QMCFooterParser> footer_parser,
                                                               const uint8_t *key, size_t key_len);
 
@@ -0,0 +1,67 @@
+#include "parakeet-crypto/BatchDecryptor.h"
+#include "batch_job.h"
+#include "io_uring_batch_decryptor.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+namespace
+{
+
+/**
+ * @brief A whole file per worker thread: while a worker waits for the disk, the others decrypt.
+ */
+class ThreadBatchDecryptor final : public IBatchDecryptor
+{
+  private:
+    BatchDecryptorOptions options_;
+
+  public:
+    ThreadBatchDecryptor(const BatchDecryptorOptions &options) : options_(options)
+    {
+    }
+
+    [[nodiscard]] const char *GetBackendName() const override
+    {
+        return "threads";
+    }
+
+    void Run(std::vector<BatchDecryptionJob> &jobs) override
+    {
+        utils::RunOnThreads(jobs.size(), batch::GetBatchThreadCount(options_), [&](size_t /*worker*/, size_t i) {
+            jobs[i].result = batch::RunBatchJob(jobs[i], options_.page_size); //
+        });
+    }
+};
+
+} // namespace
+
+std::unique_ptr<IBatchDecryptor> CreateBatchDecryptor(const BatchDecryptorOptions &options)
+{
+    if (options.page_size == 0 || options.queue_depth == 0)
+    {
+        return nullptr;
+    }
+
+    switch (options.backend)
+    {
+    case BatchDecryptorBackend::AUTO:
+        if (auto decryptor = batch::CreateIoUringBatchDecryptor(options))
+        {
+            return decryptor;
+        }
+        return std::make_unique<ThreadBatchDecryptor>(options);
+    case BatchDecryptorBackend::IO_URING:
+        return batch::CreateIoUringBatchDecryptor(options);
+    case BatchDecryptorBackend::THREADS:
+        return std::make_unique<ThreadBatchDecryptor>(options);
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace parakeet_crypto
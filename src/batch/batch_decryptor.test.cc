@@ -0,0 +1,165 @@
+#include "parakeet-crypto/BatchDecryptor.h"
+#include "parakeet-crypto/transformer/joox.h"
+#include "parakeet-crypto/transformer/kgm.h"
+#include "parakeet-crypto/transformer/ncm.h"
+
+#include "test/read_fixture.test.hh"
+#include "test/test_env.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+std::string GetFixturePath(const char *name)
+{
+    return std::string(test::get_fixture_directory()) + name;
+}
+
+class BatchDecryptorTest : public ::testing::Test
+{
+  protected:
+    std::filesystem::path output_dir_{};
+    std::unique_ptr<ITransformer> kgm_{};
+    std::unique_ptr<ITransformer> ncm_{};
+    std::unique_ptr<ITransformer> joox_{};
+
+    void SetUp() override
+    {
+        const auto *test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+        output_dir_ = std::filesystem::temp_directory_path() / ("parakeet_batch_" + std::string(test_info->name()));
+        std::filesystem::create_directories(output_dir_);
+
+        transformer::KGMConfig kgm_config{};
+        kgm_config.slot_keys = {{1, {'0', '9', 'A', 'Z'}}};
+        kgm_ = transformer::CreateKGMDecryptionTransformer(kgm_config);
+
+        static constexpr std::array<const uint8_t, 16> kNCMKey = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                                  0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+        ncm_ = transformer::CreateNeteaseNCMDecryptionTransformer(kNCMKey.data());
+
+        transformer::JooxConfig joox_config{};
+        joox_config.install_uuid = "ffffffffffffffffffffffffffffffff";
+        joox_config.salt = {0xDA, 0x40, 0x7A, 0x0A, 0x02, 0x60, 0x45, 0x8B,
+                            0xE1, 0x66, 0x2D, 0x3E, 0x37, 0x6D, 0xD1, 0x63};
+        joox_ = transformer::CreateJooxDecryptionV4Transformer(joox_config);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(output_dir_);
+    }
+
+    BatchDecryptionJob MakeJob(const char *fixture_name, ITransformer *transformer, size_t index)
+    {
+        BatchDecryptionJob job{};
+        job.input_path = GetFixturePath(fixture_name);
+        job.output_path = (output_dir_ / (std::to_string(index) + ".ogg")).string();
+        job.transformer = transformer;
+        return job;
+    }
+
+    std::vector<BatchDecryptionJob> MakeJobs()
+    {
+        std::vector<BatchDecryptionJob> jobs{};
+        for (size_t i = 0; i < 4; i++)
+        {
+            jobs.push_back(MakeJob("test_kgm_v2.kgm", kgm_.get(), jobs.size()));
+            jobs.push_back(MakeJob("test.ncm", ncm_.get(), jobs.size()));
+            jobs.push_back(MakeJob("joox_[E!04].ofl_en", joox_.get(), jobs.size()));
+            jobs.push_back(MakeJob("test_kgm_v3.kgm", kgm_.get(), jobs.size()));
+        }
+        return jobs;
+    }
+
+    static void ExpectDecrypted(const std::vector<BatchDecryptionJob> &jobs)
+    {
+        static const auto fixture_plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+        for (const auto &job : jobs)
+        {
+            ASSERT_EQ(job.result, TransformResult::OK) << job.input_path;
+            auto output = test::read_file(job.output_path.c_str());
+            ASSERT_TRUE(output.has_value()) << job.output_path;
+            ASSERT_THAT(*output, ContainerEq(fixture_plain)) << job.input_path;
+        }
+    }
+};
+
+} // namespace
+
+TEST_F(BatchDecryptorTest, Threads)
+{
+    BatchDecryptorOptions options{};
+    options.backend = BatchDecryptorBackend::THREADS;
+    options.page_size = 4096;
+    options.thread_count = 3;
+    auto decryptor = CreateBatchDecryptor(options);
+    ASSERT_NE(decryptor, nullptr);
+    ASSERT_STREQ(decryptor->GetBackendName(), "threads");
+
+    auto jobs = MakeJobs();
+    decryptor->Run(jobs);
+    ExpectDecrypted(jobs);
+}
+
+TEST_F(BatchDecryptorTest, IoUring)
+{
+    BatchDecryptorOptions options{};
+    options.backend = BatchDecryptorBackend::IO_URING;
+    options.page_size = 4096; // many pages per file, from several files in flight
+    options.queue_depth = 8;
+    options.thread_count = 3; // pages decrypted by workers, while JOOX files run on the same workers
+    auto decryptor = CreateBatchDecryptor(options);
+    if (decryptor == nullptr)
+    {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    ASSERT_STREQ(decryptor->GetBackendName(), "io_uring");
+
+    auto jobs = MakeJobs();
+    decryptor->Run(jobs);
+    ExpectDecrypted(jobs);
+
+    // The rings are reused by the next batch.
+    jobs = MakeJobs();
+    decryptor->Run(jobs);
+    ExpectDecrypted(jobs);
+}
+
+TEST_F(BatchDecryptorTest, ReportsErrorsPerJob)
+{
+    auto decryptor = CreateBatchDecryptor();
+    ASSERT_NE(decryptor, nullptr);
+
+    std::vector<BatchDecryptionJob> jobs{};
+    jobs.push_back(MakeJob("test.ncm", ncm_.get(), 0));
+    jobs.push_back(MakeJob("does_not_exist.ncm", ncm_.get(), 1));
+    jobs.push_back(MakeJob("test_kgm_v2.kgm", ncm_.get(), 2)); // wrong format
+    jobs.push_back(MakeJob("test_kgm_v2.kgm", kgm_.get(), 3));
+    decryptor->Run(jobs);
+
+    ASSERT_EQ(jobs[0].result, TransformResult::OK);
+    ASSERT_NE(jobs[1].result, TransformResult::OK);
+    ASSERT_EQ(jobs[2].result, TransformResult::ERROR_INVALID_FORMAT);
+    ASSERT_EQ(jobs[3].result, TransformResult::OK);
+    ASSERT_FALSE(std::filesystem::exists(jobs[1].output_path));
+    ASSERT_FALSE(std::filesystem::exists(jobs[2].output_path));
+    ExpectDecrypted({jobs[0], jobs[3]});
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
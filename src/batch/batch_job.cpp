@@ -0,0 +1,94 @@
+#include "batch_job.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parakeet_crypto::batch
+{
+
+TransformResult OpenBatchInput(OpenedBatchJob &opened, const BatchDecryptionJob &job)
+{
+    if (job.transformer == nullptr)
+    {
+        return TransformResult::ERROR_OTHER;
+    }
+
+    opened.input = InputFDStream::Open(job.input_path.c_str());
+    if (!opened.input)
+    {
+        return TransformResult::ERROR_OTHER;
+    }
+
+    auto result = job.transformer->CreateRandomAccessDecryptor(opened.decryptor, opened.input.get());
+    if (result == TransformResult::ERROR_NOT_IMPLEMENTED)
+    {
+        opened.decryptor.reset();
+        opened.input->Seek(0, SeekDirection::SEEK_FILE_BEGIN);
+        return TransformResult::OK;
+    }
+    return result;
+}
+
+TransformResult OpenBatchOutput(OpenedBatchJob &opened, const BatchDecryptionJob &job)
+{
+    opened.output = OutputFDStream::Open(job.output_path.c_str());
+    if (!opened.output)
+    {
+        return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+    }
+
+    if (opened.decryptor)
+    {
+        opened.output->Preallocate(opened.decryptor->GetDataSize());
+    }
+    return TransformResult::OK;
+}
+
+TransformResult RunBatchJob(const BatchDecryptionJob &job, size_t page_size)
+{
+    OpenedBatchJob opened{};
+    if (auto result = OpenBatchInput(opened, job); result != TransformResult::OK)
+    {
+        return result;
+    }
+    if (auto result = OpenBatchOutput(opened, job); result != TransformResult::OK)
+    {
+        return result;
+    }
+
+    if (!opened.decryptor)
+    {
+        auto result = job.transformer->Transform(opened.output.get(), opened.input.get());
+        if (result == TransformResult::OK && !opened.output->Flush())
+        {
+            result = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+        }
+        return result;
+    }
+
+    const auto data_offset = opened.decryptor->GetDataOffset();
+    const auto data_size = opened.decryptor->GetDataSize();
+    std::vector<uint8_t> page(std::min(page_size, data_size));
+    for (size_t offset = 0; offset < data_size; offset += page.size())
+    {
+        auto len = std::min(page.size(), data_size - offset);
+        if (!opened.input->ReadExactAt(data_offset + offset, page.data(), len))
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        if (!opened.decryptor->DecryptAt(offset, page.data(), len))
+        {
+            return TransformResult::ERROR_INVALID_KEY;
+        }
+        if (!opened.output->WriteAt(offset, page.data(), len))
+        {
+            return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+        }
+    }
+
+    return TransformResult::OK;
+}
+
+} // namespace parakeet_crypto::batch
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "parakeet-crypto/BatchDecryptor.h"
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+#include "parakeet-crypto/StreamHelper.h"
+#include "utils/parallel.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace parakeet_crypto::batch
+{
+
+struct OpenedBatchJob
+{
+    std::unique_ptr<InputFDStream> input{};
+    std::unique_ptr<OutputFDStream> output{};
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{}; // `nullptr`: the format can only be decrypted in order.
+};
+
+/**
+ * @brief Open the input file, and parse its header.
+ *        Formats without a random access decryptor are not an error: `decryptor` is left empty,
+ *        and the input is rewound for `ITransformer::Transform`.
+ */
+TransformResult OpenBatchInput(OpenedBatchJob &opened, const BatchDecryptionJob &job);
+
+/**
+ * @brief Create the output file, and reserve its final size when known.
+ */
+TransformResult OpenBatchOutput(OpenedBatchJob &opened, const BatchDecryptionJob &job);
+
+/**
+ * @brief Decrypt a whole job on the calling thread.
+ */
+TransformResult RunBatchJob(const BatchDecryptionJob &job, size_t page_size);
+
+inline size_t GetBatchThreadCount(const BatchDecryptorOptions &options)
+{
+    return options.thread_count != 0 ? options.thread_count : utils::GetDefaultThreadCount();
+}
+
+} // namespace parakeet_crypto::batch
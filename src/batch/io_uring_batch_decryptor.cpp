@@ -0,0 +1,786 @@
+#include "io_uring_batch_decryptor.h"
+#include "batch_job.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define PARAKEET_CRYPTO_HAS_IO_URING 1
+#endif
+#endif
+
+#if PARAKEET_CRYPTO_HAS_IO_URING
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace parakeet_crypto::batch
+{
+
+#if PARAKEET_CRYPTO_HAS_IO_URING
+
+namespace
+{
+
+/**
+ * @brief Submission and completion rings, set up with the raw system calls (no liburing dependency).
+ *        Single-threaded: one thread queues, submits and reaps.
+ */
+class IoUring
+{
+  private:
+    int fd_{-1};
+    void *sq_ring_{MAP_FAILED};
+    size_t sq_ring_size_{0};
+    void *cq_ring_{MAP_FAILED};
+    size_t cq_ring_size_{0};
+    void *sqes_{MAP_FAILED};
+    size_t sqes_size_{0};
+
+    unsigned *sq_head_{};
+    unsigned *sq_tail_{};
+    unsigned *sq_mask_{};
+    unsigned *sq_entries_{};
+    unsigned *sq_array_{};
+    unsigned *cq_head_{};
+    unsigned *cq_tail_{};
+    unsigned *cq_mask_{};
+    io_uring_cqe *cqes_{};
+
+    unsigned sq_local_tail_{0};
+    unsigned to_submit_{0};
+
+    template <typename T> static T *RingField(void *ring, uint32_t offset)
+    {
+        return reinterpret_cast<T *>(static_cast<uint8_t *>(ring) + offset); // NOLINT(*-reinterpret-cast)
+    }
+
+  public:
+    IoUring() = default;
+    IoUring(const IoUring &) = delete;
+    IoUring(IoUring &&) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+    IoUring &operator=(IoUring &&) = delete;
+
+    ~IoUring()
+    {
+        if (sqes_ != MAP_FAILED)
+        {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED)
+        {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED)
+        {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    bool Init(unsigned entries)
+    {
+        io_uring_params params{};
+        auto fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0)
+        {
+            return false;
+        }
+        fd_ = static_cast<int>(fd);
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                        IORING_OFF_SQ_RING);
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                        IORING_OFF_CQ_RING);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED)
+        {
+            return false;
+        }
+
+        sq_head_ = RingField<unsigned>(sq_ring_, params.sq_off.head);
+        sq_tail_ = RingField<unsigned>(sq_ring_, params.sq_off.tail);
+        sq_mask_ = RingField<unsigned>(sq_ring_, params.sq_off.ring_mask);
+        sq_entries_ = RingField<unsigned>(sq_ring_, params.sq_off.ring_entries);
+        sq_array_ = RingField<unsigned>(sq_ring_, params.sq_off.array);
+        cq_head_ = RingField<unsigned>(cq_ring_, params.cq_off.head);
+        cq_tail_ = RingField<unsigned>(cq_ring_, params.cq_off.tail);
+        cq_mask_ = RingField<unsigned>(cq_ring_, params.cq_off.ring_mask);
+        cqes_ = RingField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+        sq_local_tail_ = *sq_tail_;
+        return true;
+    }
+
+    /**
+     * @brief Next free submission entry, zeroed; `nullptr` if the submission ring is full.
+     */
+    io_uring_sqe *GetSqe()
+    {
+        auto head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= *sq_entries_)
+        {
+            return nullptr;
+        }
+
+        auto index = sq_local_tail_ & *sq_mask_;
+        auto *sqe = &static_cast<io_uring_sqe *>(sqes_)[index];
+        *sqe = io_uring_sqe{};
+        sq_array_[index] = index;
+        sq_local_tail_++;
+        to_submit_++;
+        return sqe;
+    }
+
+    /**
+     * @brief Submit the queued entries, and wait for at least `wait_count` completions.
+     * @return false The ring can't be used anymore.
+     */
+    bool Submit(unsigned wait_count)
+    {
+        __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+        while (true)
+        {
+            unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+            auto submitted = syscall(__NR_io_uring_enter, fd_, to_submit_, wait_count, flags, nullptr, 0);
+            if (submitted >= 0)
+            {
+                to_submit_ -= std::min(to_submit_, static_cast<unsigned>(submitted));
+                return true;
+            }
+            if (errno == EAGAIN || errno == EBUSY)
+            {
+                return true; // completion ring is full: reap, then submit again.
+            }
+            if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    // std::function<void(uint64_t user_data, int32_t result)>
+    template <typename Callback> void ForEachCompletion(Callback callback)
+    {
+        auto head = *cq_head_;
+        auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            const auto &cqe = cqes_[head & *cq_mask_];
+            auto user_data = cqe.user_data;
+            auto result = cqe.res;
+            __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+            callback(user_data, result);
+        }
+    }
+};
+
+/**
+ * @brief eventfd read by the ring, to wake up the ring thread when a worker has decrypted a page.
+ */
+class WakeEvent
+{
+  private:
+    int fd_{-1};
+    uint64_t value_{0};
+    iovec iov_{&value_, sizeof(value_)};
+
+  public:
+    WakeEvent() = default;
+    WakeEvent(const WakeEvent &) = delete;
+    WakeEvent(WakeEvent &&) = delete;
+    WakeEvent &operator=(const WakeEvent &) = delete;
+    WakeEvent &operator=(WakeEvent &&) = delete;
+
+    ~WakeEvent()
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    bool Init()
+    {
+        fd_ = eventfd(0, EFD_CLOEXEC);
+        return fd_ >= 0;
+    }
+
+    void Signal() const
+    {
+        uint64_t value{1};
+        while (write(fd_, &value, sizeof(value)) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    void PrepareRead(io_uring_sqe *sqe)
+    {
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd_;
+        sqe->addr = reinterpret_cast<uintptr_t>(&iov_); // NOLINT(*-reinterpret-cast)
+        sqe->len = 1;
+    }
+};
+
+struct PageSlot
+{
+    std::vector<uint8_t> buffer{};
+    iovec iov{};
+    size_t job_index{0};
+    size_t offset{0}; // offset in the payload, also the offset in the output file
+    size_t len{0};
+    size_t done{0}; // bytes transferred by the current read or write
+    bool writing{false};
+
+    const IRandomAccessDecryptor *decryptor{}; // set while the page is handed to a worker
+    bool decrypted{false};
+};
+
+/**
+ * @brief Worker threads of a `Run`: they decrypt the pages read by the ring, and run the jobs of formats without a
+ *        random access decryptor in the meantime. Pages are taken first, as they hold a ring slot.
+ */
+class PageDecryptWorkers
+{
+  private:
+    std::vector<PageSlot> &slots_;
+    std::vector<BatchDecryptionJob> &jobs_;
+    size_t page_size_;
+    const WakeEvent &wake_;
+
+    std::mutex mutex_{};
+    std::condition_variable work_ready_{};
+    std::deque<size_t> pending_pages_{}; // slot indices
+    std::deque<size_t> pending_jobs_{};  // job indices
+    std::vector<size_t> decrypted_pages_{};
+    bool closing_{false};
+    std::vector<std::thread> threads_{};
+
+  public:
+    PageDecryptWorkers(std::vector<PageSlot> &slots, std::vector<BatchDecryptionJob> &jobs, size_t page_size,
+                       const WakeEvent &wake, size_t thread_count)
+        : slots_(slots), jobs_(jobs), page_size_(page_size), wake_(wake)
+    {
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            threads_.emplace_back([this]() { Work(); });
+        }
+    }
+
+    PageDecryptWorkers(const PageDecryptWorkers &) = delete;
+    PageDecryptWorkers(PageDecryptWorkers &&) = delete;
+    PageDecryptWorkers &operator=(const PageDecryptWorkers &) = delete;
+    PageDecryptWorkers &operator=(PageDecryptWorkers &&) = delete;
+
+    ~PageDecryptWorkers()
+    {
+        Close();
+    }
+
+    /**
+     * @brief Decrypt a page; it is returned by `TakeDecryptedPages`, after a `WakeEvent` signal.
+     */
+    void DecryptPage(size_t slot_index)
+    {
+        Push(pending_pages_, slot_index);
+    }
+
+    void RunSequentialJob(size_t job_index)
+    {
+        Push(pending_jobs_, job_index);
+    }
+
+    void TakeDecryptedPages(std::vector<size_t> &pages)
+    {
+        pages.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(pages, decrypted_pages_);
+    }
+
+    /**
+     * @brief Wait for the queued pages and jobs to complete, and stop the threads.
+     */
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+  private:
+    void Push(std::deque<size_t> &queue, size_t index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue.push_back(index);
+        }
+        work_ready_.notify_one();
+    }
+
+    void Work()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            work_ready_.wait(lock, [&]() { return closing_ || !pending_pages_.empty() || !pending_jobs_.empty(); });
+            if (!pending_pages_.empty())
+            {
+                auto slot_index = pending_pages_.front();
+                pending_pages_.pop_front();
+                lock.unlock();
+
+                auto &slot = slots_[slot_index];
+                slot.decrypted = slot.decryptor->DecryptAt(slot.offset, slot.buffer.data(), slot.len);
+
+                lock.lock();
+                decrypted_pages_.push_back(slot_index);
+                wake_.Signal();
+            }
+            else if (!pending_jobs_.empty())
+            {
+                auto job_index = pending_jobs_.front();
+                pending_jobs_.pop_front();
+                lock.unlock();
+
+                auto &job = jobs_[job_index];
+                job.result = RunBatchJob(job, page_size_);
+
+                lock.lock();
+            }
+            else
+            {
+                return; // closing, and nothing left to do
+            }
+        }
+    }
+};
+
+struct RingJob
+{
+    OpenedBatchJob opened{};
+    size_t next_offset{0}; // next page to read
+    size_t data_size{0};
+    size_t in_flight{0};
+    TransformResult result{TransformResult::OK};
+};
+
+/**
+ * @brief State of a single `Run`: pages are scheduled from one file at a time, in order, and the next file
+ *        is opened once every page of the current file has been scheduled. Completed reads are decrypted by the
+ *        workers, and their writes are queued by the ring thread once the workers hand them back.
+ */
+class IoUringBatchRun
+{
+  private:
+    static constexpr uint64_t kWakeUserData = UINT64_MAX;
+
+    IoUring &ring_;
+    WakeEvent &wake_;
+    PageDecryptWorkers &workers_;
+    std::vector<PageSlot> &slots_;
+    std::vector<BatchDecryptionJob> &jobs_;
+
+    std::vector<RingJob> ring_jobs_{};
+    std::vector<size_t> free_slots_{};
+    std::vector<size_t> decrypted_pages_{};
+    size_t in_flight_{0}; // pages being read, decrypted or written
+    size_t next_job_{0};
+    size_t current_job_{0};
+    bool has_current_job_{false};
+    bool wake_pending_{false};
+
+  public:
+    IoUringBatchRun(IoUring &ring, WakeEvent &wake, PageDecryptWorkers &workers, std::vector<PageSlot> &slots,
+                    std::vector<BatchDecryptionJob> &jobs)
+        : ring_(ring), wake_(wake), workers_(workers), slots_(slots), jobs_(jobs), ring_jobs_(jobs.size())
+    {
+        for (size_t i = slots.size(); i > 0; i--)
+        {
+            free_slots_.push_back(i - 1);
+        }
+    }
+
+    /**
+     * @return false The ring failed; unfinished jobs are marked as failed, and pages may still be in flight.
+     */
+    bool Run()
+    {
+        while (true)
+        {
+            while (!free_slots_.empty() && ScheduleRead())
+            {
+            }
+            if (in_flight_ == 0)
+            {
+                break;
+            }
+
+            if (!(wake_pending_ || QueueWakeRead()) || !SubmitAndReap())
+            {
+                workers_.Close(); // the workers may still use the decryptors of the failed jobs
+                FailAll();
+                return false;
+            }
+
+            workers_.TakeDecryptedPages(decrypted_pages_);
+            for (auto slot_index : decrypted_pages_)
+            {
+                OnPageDecrypted(slot_index);
+            }
+        }
+
+        // The pending read of the eventfd refers to it: complete it before the next `Run`.
+        if (wake_pending_)
+        {
+            wake_.Signal();
+        }
+        while (wake_pending_)
+        {
+            if (!SubmitAndReap())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    bool SubmitAndReap()
+    {
+        if (!ring_.Submit(1))
+        {
+            return false;
+        }
+        ring_.ForEachCompletion([&](uint64_t user_data, int32_t result) {
+            if (user_data == kWakeUserData)
+            {
+                wake_pending_ = false;
+                return;
+            }
+            OnCompletion(static_cast<size_t>(user_data), result);
+        });
+        return true;
+    }
+
+    bool QueueWakeRead()
+    {
+        auto *sqe = ring_.GetSqe();
+        if (sqe == nullptr && ring_.Submit(0))
+        {
+            sqe = ring_.GetSqe();
+        }
+        if (sqe == nullptr)
+        {
+            return false;
+        }
+
+        wake_.PrepareRead(sqe);
+        sqe->user_data = kWakeUserData;
+        wake_pending_ = true;
+        return true;
+    }
+
+    void FinishJob(size_t index)
+    {
+        auto &job = ring_jobs_[index];
+        job.opened = OpenedBatchJob{};
+        jobs_[index].result = job.result;
+    }
+
+    void FailJob(size_t index, TransformResult result)
+    {
+        auto &job = ring_jobs_[index];
+        if (job.result == TransformResult::OK)
+        {
+            job.result = result;
+        }
+        job.next_offset = job.data_size; // stop scheduling its pages
+    }
+
+    void FailAll()
+    {
+        for (size_t i = 0; i < jobs_.size(); i++)
+        {
+            if (i >= next_job_ || ring_jobs_[i].opened.input)
+            {
+                FailJob(i, TransformResult::ERROR_OTHER);
+                FinishJob(i);
+            }
+        }
+        next_job_ = jobs_.size();
+    }
+
+    bool OpenNextJob()
+    {
+        while (next_job_ < jobs_.size())
+        {
+            auto index = next_job_++;
+            auto &job = ring_jobs_[index];
+
+            auto result = OpenBatchInput(job.opened, jobs_[index]);
+            if (result == TransformResult::OK && !job.opened.decryptor)
+            {
+                job.opened = OpenedBatchJob{};
+                workers_.RunSequentialJob(index);
+                continue;
+            }
+            if (result == TransformResult::OK)
+            {
+                result = OpenBatchOutput(job.opened, jobs_[index]);
+            }
+            if (result != TransformResult::OK)
+            {
+                job.result = result;
+                FinishJob(index);
+                continue;
+            }
+
+            job.data_size = job.opened.decryptor->GetDataSize();
+            if (job.data_size == 0)
+            {
+                FinishJob(index);
+                continue;
+            }
+
+            current_job_ = index;
+            has_current_job_ = true;
+            return true;
+        }
+        return false;
+    }
+
+    bool ScheduleRead()
+    {
+        while (!has_current_job_ || ring_jobs_[current_job_].next_offset >= ring_jobs_[current_job_].data_size)
+        {
+            has_current_job_ = false;
+            if (!OpenNextJob())
+            {
+                return false;
+            }
+        }
+
+        auto slot_index = free_slots_.back();
+        free_slots_.pop_back();
+
+        auto &job = ring_jobs_[current_job_];
+        auto &slot = slots_[slot_index];
+        slot.job_index = current_job_;
+        slot.offset = job.next_offset;
+        slot.len = std::min(slot.buffer.size(), job.data_size - job.next_offset);
+        slot.done = 0;
+        slot.writing = false;
+
+        job.next_offset += slot.len;
+        job.in_flight++;
+        in_flight_++;
+        QueueIO(slot_index);
+        return true;
+    }
+
+    void QueueIO(size_t slot_index)
+    {
+        auto &slot = slots_[slot_index];
+        auto &job = ring_jobs_[slot.job_index];
+
+        auto *sqe = ring_.GetSqe();
+        if (sqe == nullptr && ring_.Submit(0))
+        {
+            sqe = ring_.GetSqe();
+        }
+        if (sqe == nullptr)
+        {
+            FailJob(slot.job_index, TransformResult::ERROR_OTHER);
+            ReleaseSlot(slot_index);
+            return;
+        }
+
+        slot.iov.iov_base = slot.buffer.data() + slot.done;
+        slot.iov.iov_len = slot.len - slot.done;
+        if (slot.writing)
+        {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->fd = job.opened.output->GetFD();
+            sqe->off = slot.offset + slot.done;
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = job.opened.input->GetFD();
+            sqe->off = job.opened.decryptor->GetDataOffset() + slot.offset + slot.done;
+        }
+        sqe->addr = reinterpret_cast<uintptr_t>(&slot.iov); // NOLINT(*-reinterpret-cast)
+        sqe->len = 1;
+        sqe->user_data = slot_index;
+    }
+
+    void ReleaseSlot(size_t slot_index)
+    {
+        auto job_index = slots_[slot_index].job_index;
+        auto &job = ring_jobs_[job_index];
+        free_slots_.push_back(slot_index);
+        in_flight_--;
+        job.in_flight--;
+
+        if (job.in_flight == 0 && job.next_offset >= job.data_size)
+        {
+            if (has_current_job_ && current_job_ == job_index)
+            {
+                has_current_job_ = false;
+            }
+            FinishJob(job_index);
+        }
+    }
+
+    void OnCompletion(size_t slot_index, int32_t result)
+    {
+        auto &slot = slots_[slot_index];
+        auto &job = ring_jobs_[slot.job_index];
+
+        if (result == -EINTR || result == -EAGAIN)
+        {
+            QueueIO(slot_index);
+            return;
+        }
+        if (result <= 0)
+        {
+            FailJob(slot.job_index, slot.writing   ? TransformResult::ERROR_IO_OUTPUT_UNKNOWN
+                                    : result == 0 ? TransformResult::ERROR_INSUFFICIENT_INPUT
+                                                  : TransformResult::ERROR_OTHER);
+            ReleaseSlot(slot_index);
+            return;
+        }
+
+        slot.done += static_cast<size_t>(result);
+        if (slot.done < slot.len)
+        {
+            QueueIO(slot_index); // short read or write
+            return;
+        }
+
+        if (!slot.writing && job.result == TransformResult::OK)
+        {
+            // Decrypted by a worker while the other pages are read or written.
+            slot.decryptor = job.opened.decryptor.get();
+            workers_.DecryptPage(slot_index);
+            return;
+        }
+
+        ReleaseSlot(slot_index);
+    }
+
+    void OnPageDecrypted(size_t slot_index)
+    {
+        auto &slot = slots_[slot_index];
+        if (!slot.decrypted)
+        {
+            FailJob(slot.job_index, TransformResult::ERROR_INVALID_KEY);
+        }
+        if (ring_jobs_[slot.job_index].result != TransformResult::OK)
+        {
+            ReleaseSlot(slot_index);
+            return;
+        }
+
+        slot.writing = true;
+        slot.done = 0;
+        QueueIO(slot_index);
+    }
+};
+
+class IoUringBatchDecryptor final : public IBatchDecryptor
+{
+  private:
+    BatchDecryptorOptions options_;
+    std::vector<PageSlot> slots_{};
+    WakeEvent wake_{};
+    IoUring ring_{}; // declared last: closed before the page buffers it may still write to are freed
+    bool ring_failed_{false};
+
+  public:
+    IoUringBatchDecryptor(const BatchDecryptorOptions &options) : options_(options), slots_(options.queue_depth)
+    {
+    }
+
+    bool Init()
+    {
+        return wake_.Init() && ring_.Init(static_cast<unsigned>(options_.queue_depth));
+    }
+
+    [[nodiscard]] const char *GetBackendName() const override
+    {
+        return "io_uring";
+    }
+
+    void Run(std::vector<BatchDecryptionJob> &jobs) override
+    {
+        if (ring_failed_)
+        {
+            for (auto &job : jobs)
+            {
+                job.result = TransformResult::ERROR_OTHER;
+            }
+            return;
+        }
+
+        for (auto &slot : slots_)
+        {
+            slot.buffer.resize(options_.page_size);
+        }
+
+        PageDecryptWorkers workers{slots_, jobs, options_.page_size, wake_, GetBatchThreadCount(options_)};
+        IoUringBatchRun run{ring_, wake_, workers, slots_, jobs};
+        ring_failed_ = !run.Run();
+        workers.Close();
+    }
+};
+
+} // namespace
+
+std::unique_ptr<IBatchDecryptor> CreateIoUringBatchDecryptor(const BatchDecryptorOptions &options)
+{
+    auto decryptor = std::make_unique<IoUringBatchDecryptor>(options);
+    if (!decryptor->Init())
+    {
+        return nullptr;
+    }
+    return decryptor;
+}
+
+#else
+
+std::unique_ptr<IBatchDecryptor> CreateIoUringBatchDecryptor(const BatchDecryptorOptions & /*options*/)
+{
+    return nullptr;
+}
+
+#endif
+
+} // namespace parakeet_crypto::batch
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "parakeet-crypto/BatchDecryptor.h"
+
+#include <memory>
+
+namespace parakeet_crypto::batch
+{
+
+/**
+ * @brief Create the io_uring backend.
+ *
+ * @return std::unique_ptr<IBatchDecryptor> `nullptr` if io_uring is not available (not Linux, kernel too old,
+ *         or disabled by a seccomp policy).
+ */
+std::unique_ptr<IBatchDecryptor> CreateIoUringBatchDecryptor(const BatchDecryptorOptions &options);
+
+} // namespace parakeet_crypto::batch
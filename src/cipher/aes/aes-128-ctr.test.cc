@@ -3,6 +3,8 @@
 #include "parakeet-crypto/cipher/cipher.h"
 #include "parakeet-crypto/cipher/cipher_error.h"
 
+#include "test/make_sequence.test.hh"
+
 #include "gmock/gmock.h"
 #include <cstdint>
 #include <gmock/gmock.h>
@@ -17,6 +19,7 @@ using ::testing::ContainerEq;
 using namespace parakeet_crypto::cipher;
 using namespace parakeet_crypto::cipher::aes;
 using namespace parakeet_crypto::cipher::block_mode;
+using parakeet_crypto::test::make_sequence;
 
 // NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 
@@ -202,4 +205,86 @@ TEST(aes_128_ctr, counter_with_overflow_block_mode)
     }
 }
 
+TEST(aes_128_ctr, add_to_iv)
+{
+    std::array<uint8_t, 16> expected{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+                                     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    std::array<uint8_t, 16> actual = expected;
+    for (size_t i = 0; i < 0x1234; i++)
+    {
+        ctr_impl_details::increment_iv(expected);
+    }
+    ctr_impl_details::add_to_iv(actual, 0x1234);
+    ASSERT_THAT(actual, ContainerEq(expected));
+
+    // Carry across every byte.
+    std::array<uint8_t, 4> wrap{0xFF, 0xFF, 0xFF, 0xFE};
+    ctr_impl_details::add_to_iv(wrap, 0x0102);
+    ASSERT_THAT(wrap, ContainerEq(std::array<uint8_t, 4>{0x00, 0x00, 0x01, 0x00}));
+}
+
+TEST(aes_128_ctr, seek_and_batches)
+{
+    auto aes_enc = std::make_shared<AES128Enc>(&g_aes_128_ctr_test_key[0]);
+
+    // NOLINTNEXTLINE
+    uint8_t test_iv[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                         0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0};
+
+    const auto input = make_sequence(5000, 13);
+
+    // Reference: the keystream one block at a time, with the block cipher only.
+    std::vector<uint8_t> expected = input;
+    {
+        std::array<uint8_t, 16> counter{};
+        std::copy_n(&test_iv[0], counter.size(), counter.begin());
+        for (size_t offset = 0; offset < expected.size(); offset += 16)
+        {
+            auto keystream = counter;
+            ASSERT_EQ(aes_enc->TransformBlock(keystream.data()), CipherError::kSuccess);
+            for (size_t i = 0; i < 16 && offset + i < expected.size(); i++)
+            {
+                expected[offset + i] ^= keystream[i];
+            }
+            ctr_impl_details::increment_iv(counter);
+        }
+    }
+
+    // Several batches at once.
+    {
+        auto aes_128_ctr = CTR_Stream(aes_enc, &test_iv[0]);
+        std::vector<uint8_t> actual(input.size());
+        size_t buffer_len{actual.size()};
+        ASSERT_EQ(aes_128_ctr.Update(actual.data(), buffer_len, input.data(), input.size()), CipherError::kSuccess);
+        ASSERT_THAT(actual, ContainerEq(expected));
+    }
+
+    // Seek then decrypt to the end, at any offset; seeking backwards included.
+    auto aes_128_ctr = CTR_Stream(aes_enc, &test_iv[0]);
+    for (size_t offset : {4321, 0, 1, 15, 16, 17, 511, 512, 513, 4999})
+    {
+        ASSERT_EQ(aes_128_ctr.SeekTo(offset), CipherError::kSuccess);
+        std::vector<uint8_t> actual(input.size() - offset);
+        size_t buffer_len{actual.size()};
+        ASSERT_EQ(aes_128_ctr.Update(actual.data(), buffer_len, &input[offset], actual.size()), CipherError::kSuccess);
+        ASSERT_TRUE(std::equal(actual.begin(), actual.end(), &expected[offset])) << "offset " << offset;
+    }
+
+    // Skip from within a block.
+    ASSERT_EQ(aes_128_ctr.SeekTo(3), CipherError::kSuccess);
+    ASSERT_EQ(aes_128_ctr.Skip(2000), CipherError::kSuccess);
+    std::vector<uint8_t> actual(input.size() - 2003);
+    size_t buffer_len{actual.size()};
+    ASSERT_EQ(aes_128_ctr.Update(actual.data(), buffer_len, &input[2003], actual.size()), CipherError::kSuccess);
+    ASSERT_TRUE(std::equal(actual.begin(), actual.end(), &expected[2003]));
+
+    // The block mode generates the same keystream.
+    {
+        auto aes_128_ctr_blocks = CTR(aes_enc, &test_iv[0]);
+        std::vector<uint8_t> blocks(input.begin(), input.begin() + 4992);
+        ASSERT_EQ(aes_128_ctr_blocks.TransformBlocks(blocks), CipherError::kSuccess);
+        ASSERT_TRUE(std::equal(blocks.begin(), blocks.end(), expected.begin()));
+    }
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -1,4 +1,39 @@
 #include "parakeet-crypto/cipher/aes/aes.h"
 
+#include "aes_backend.h"
 #include "ecb_crypto.hpp"
 #include "key_expansion.hpp"
+
+namespace parakeet_crypto::cipher::aes
+{
+
+bool IsAESBackendSupported(AESBackend backend)
+{
+    if (backend == AESBackend::AESNI)
+    {
+        return detail::IsAESNISupported();
+    }
+    return true;
+}
+
+AESBackend GetAESBackend()
+{
+    static const AESBackend kSelectedBackend =
+        IsAESBackendSupported(AESBackend::AESNI) ? AESBackend::AESNI : AESBackend::TTABLE;
+    return kSelectedBackend;
+}
+
+const char *GetAESBackendName(AESBackend backend)
+{
+    switch (backend)
+    {
+    case AESBackend::TTABLE:
+        return "ttable";
+    case AESBackend::AESNI:
+        return "aesni";
+    default:
+        return "reference";
+    }
+}
+
+} // namespace parakeet_crypto::cipher::aes
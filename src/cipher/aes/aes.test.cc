@@ -1,5 +1,7 @@
 #include "parakeet-crypto/cipher/aes/aes.h"
 
+#include "test/make_sequence.test.hh"
+
 #include <cstdint>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -10,6 +12,7 @@
 
 using ::testing::ContainerEq;
 using namespace parakeet_crypto::cipher::aes;
+using parakeet_crypto::test::make_sequence;
 
 // NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 
@@ -177,4 +180,90 @@ TEST(aess, InitAes256)
     }
 }
 
+namespace
+{
+
+template <BLOCK_SIZE kKeySize, CRYPTO_MODE kMode> void ExpectBackendsMatchReference()
+{
+    const auto key = make_sequence(static_cast<size_t>(kKeySize), static_cast<uint32_t>(kKeySize));
+    const auto src = make_sequence(16 * 29, 7);
+
+    AES<kKeySize, kMode> reference(key.data());
+    reference.SetBackend(AESBackend::REFERENCE);
+
+    for (auto backend : {AESBackend::TTABLE, AESBackend::AESNI})
+    {
+        if (!IsAESBackendSupported(backend))
+        {
+            continue;
+        }
+
+        AES<kKeySize, kMode> aes(key.data());
+        ASSERT_TRUE(aes.SetBackend(backend));
+
+        // 1 to 29 blocks: every combination of the 8-, 4- and 1-block paths.
+        for (size_t n_blocks = 1; n_blocks <= 29; n_blocks++)
+        {
+            std::vector<uint8_t> expected(src.begin(), src.begin() + static_cast<std::ptrdiff_t>(n_blocks * 16));
+            std::vector<uint8_t> actual = expected;
+            ASSERT_EQ(reference.TransformBlocks(expected), 0);
+            ASSERT_EQ(aes.TransformBlocks(actual), 0);
+            ASSERT_THAT(actual, ContainerEq(expected))
+                << GetAESBackendName(backend) << ", key " << key.size() << ", blocks " << n_blocks;
+        }
+    }
+}
+
+} // namespace
+
+TEST(aess, AllBackendsMatchReference)
+{
+    ASSERT_TRUE(IsAESBackendSupported(GetAESBackend()));
+    ASSERT_EQ(AES128Enc{}.GetBackend(), GetAESBackend());
+
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_128, CRYPTO_MODE::Encrypt>();
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_192, CRYPTO_MODE::Encrypt>();
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_256, CRYPTO_MODE::Encrypt>();
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>();
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_192, CRYPTO_MODE::Decrypt>();
+    ExpectBackendsMatchReference<BLOCK_SIZE::AES_256, CRYPTO_MODE::Decrypt>();
+}
+
+TEST(aess, SetBackendKeepsCurrentWhenUnsupported)
+{
+    AES128Enc aes{};
+    ASSERT_TRUE(aes.SetBackend(AESBackend::TTABLE));
+    ASSERT_EQ(aes.SetBackend(AESBackend::AESNI), IsAESBackendSupported(AESBackend::AESNI));
+    ASSERT_EQ(aes.GetBackend(), IsAESBackendSupported(AESBackend::AESNI) ? AESBackend::AESNI : AESBackend::TTABLE);
+}
+
+TEST(aess, UpdateInPieces)
+{
+    const auto key = make_sequence(16, 3);
+    const auto src = make_sequence(16 * 20, 4);
+
+    AES128Dec reference(key.data());
+    reference.SetBackend(AESBackend::REFERENCE);
+    std::vector<uint8_t> expected = src;
+    ASSERT_EQ(reference.TransformBlocks(expected), 0);
+
+    // Partial blocks carried between calls, then a run of whole blocks in one call.
+    AES128Dec aes(key.data());
+    std::vector<uint8_t> actual(src.size());
+    size_t in_offset{0};
+    size_t out_offset{0};
+    for (size_t len : {size_t{5}, size_t{11}, size_t{7}, size_t{16 * 17 + 3}, size_t{22}})
+    {
+        size_t n_output = actual.size() - out_offset;
+        ASSERT_EQ(aes.Update(&actual[out_offset], n_output, &src[in_offset], len), 0);
+        in_offset += len;
+        out_offset += n_output;
+        ASSERT_EQ(out_offset, in_offset / 16 * 16);
+    }
+    size_t n_final{0};
+    ASSERT_EQ(aes.Final(nullptr, n_final), 0);
+    ASSERT_EQ(out_offset, src.size());
+    ASSERT_THAT(actual, ContainerEq(expected));
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
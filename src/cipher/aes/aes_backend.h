@@ -0,0 +1,29 @@
+#pragma once
+
+#include "utils/simd_target.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto::cipher::aes::detail
+{
+
+// Multi-block kernels of the AES backends, on `n_blocks` consecutive 16-byte blocks, in place.
+//   Encryption takes the expanded key (`rounds + 1` round keys); decryption takes the round keys of the equivalent
+//   inverse cipher, in the order they are applied (see `AES::inv_key_`).
+
+void EncryptBlocksTTable(const uint8_t *round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks);
+void DecryptBlocksTTable(const uint8_t *inv_round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks);
+
+/**
+ * @brief Check for the AES-NI instructions, with `cpuid`. Always false outside x86.
+ */
+bool IsAESNISupported();
+
+#if PARAKEET_SIMD_X86
+// Only built for x86: elsewhere, `AESBackend::AESNI` is never selected (`IsAESNISupported` is false).
+void EncryptBlocksAESNI(const uint8_t *round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks);
+void DecryptBlocksAESNI(const uint8_t *inv_round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks);
+#endif
+
+} // namespace parakeet_crypto::cipher::aes::detail
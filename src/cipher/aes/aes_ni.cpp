@@ -0,0 +1,129 @@
+#include "aes_backend.h"
+
+#include "parakeet-crypto/cipher/aes/aes.h"
+#include "utils/simd_target.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if PARAKEET_SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace parakeet_crypto::cipher::aes::detail
+{
+
+#if PARAKEET_SIMD_X86
+
+namespace
+{
+
+// NOLINTBEGIN(*-reinterpret-cast,*-avoid-c-arrays)
+
+constexpr size_t kAESBlockSize = 16;
+constexpr size_t kMaxRoundKeys = kKeyRounds_256 + 1;
+// Plain arrays of `__m128i`: `std::array` would drop its alignment attribute (`-Wignored-attributes`).
+struct RoundKeys
+{
+    alignas(16) __m128i keys[kMaxRoundKeys];
+};
+
+PARAKEET_TARGET("aes,sse2") inline void LoadRoundKeys(RoundKeys &keys, const uint8_t *round_keys, size_t rounds)
+{
+    for (size_t i = 0; i <= rounds; i++)
+    {
+        keys.keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&round_keys[i * kAESBlockSize]));
+    }
+}
+
+template <bool kDecrypt> PARAKEET_TARGET("aes,sse2") inline __m128i Round(__m128i block, __m128i key)
+{
+    return kDecrypt ? _mm_aesdec_si128(block, key) : _mm_aesenc_si128(block, key);
+}
+
+template <bool kDecrypt> PARAKEET_TARGET("aes,sse2") inline __m128i LastRound(__m128i block, __m128i key)
+{
+    return kDecrypt ? _mm_aesdeclast_si128(block, key) : _mm_aesenclast_si128(block, key);
+}
+
+// Independent blocks, one per lane, interleaved in each round: `aesenc` has a latency of several cycles, but a new
+//   one can start every cycle. The lanes are unrolled (parameter packs) so that they stay in registers.
+template <bool kDecrypt, size_t... kLane>
+PARAKEET_TARGET("aes,sse2")
+inline void TransformLanes(const RoundKeys &round_keys, size_t rounds, uint8_t *buffer, std::index_sequence<kLane...>)
+{
+    const auto &keys = round_keys.keys;
+    auto *p_blocks = reinterpret_cast<__m128i *>(buffer);
+    alignas(16) __m128i lanes[]{_mm_xor_si128(_mm_loadu_si128(&p_blocks[kLane]), keys[0])...};
+    for (size_t round = 1; round < rounds; round++)
+    {
+        ((lanes[kLane] = Round<kDecrypt>(lanes[kLane], keys[round])), ...);
+    }
+    (_mm_storeu_si128(&p_blocks[kLane], LastRound<kDecrypt>(lanes[kLane], keys[rounds])), ...);
+}
+
+template <bool kDecrypt>
+PARAKEET_TARGET("aes,sse2")
+void TransformBlocks(const uint8_t *round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks)
+{
+    constexpr size_t kWideLanes = 8;
+    constexpr size_t kNarrowLanes = 4;
+
+    RoundKeys keys{};
+    LoadRoundKeys(keys, round_keys, rounds);
+
+    for (; n_blocks >= kWideLanes; n_blocks -= kWideLanes, buffer += kWideLanes * kAESBlockSize)
+    {
+        TransformLanes<kDecrypt>(keys, rounds, buffer, std::make_index_sequence<kWideLanes>{});
+    }
+    if (n_blocks >= kNarrowLanes)
+    {
+        TransformLanes<kDecrypt>(keys, rounds, buffer, std::make_index_sequence<kNarrowLanes>{});
+        n_blocks -= kNarrowLanes;
+        buffer += kNarrowLanes * kAESBlockSize;
+    }
+    for (; n_blocks > 0; n_blocks--, buffer += kAESBlockSize)
+    {
+        TransformLanes<kDecrypt>(keys, rounds, buffer, std::index_sequence<0>{});
+    }
+}
+
+// NOLINTEND(*-reinterpret-cast,*-avoid-c-arrays)
+
+} // namespace
+
+bool IsAESNISupported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    constexpr int kEcxAES = 1 << 25;
+    std::array<int, 4> regs{}; // eax, ebx, ecx, edx
+    __cpuid(regs.data(), 1);
+    return (regs[2] & kEcxAES) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") != 0;
+#endif
+}
+
+void EncryptBlocksAESNI(const uint8_t *round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks)
+{
+    TransformBlocks<false>(round_keys, rounds, buffer, n_blocks);
+}
+
+void DecryptBlocksAESNI(const uint8_t *inv_round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks)
+{
+    TransformBlocks<true>(inv_round_keys, rounds, buffer, n_blocks);
+}
+
+#else
+
+bool IsAESNISupported()
+{
+    return false;
+}
+
+#endif // PARAKEET_SIMD_X86
+
+} // namespace parakeet_crypto::cipher::aes::detail
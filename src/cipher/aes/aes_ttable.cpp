@@ -0,0 +1,167 @@
+#include "aes_backend.h"
+#include "helper.hpp"
+
+#include "parakeet-crypto/cipher/aes/aes.h"
+#include "utils/endian_helper.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto::cipher::aes::detail
+{
+
+namespace
+{
+
+// NOLINTBEGIN(*-magic-numbers,*-identifier-length)
+
+constexpr size_t kMaxRoundKeyWords = 4 * (kKeyRounds_256 + 1);
+
+constexpr uint8_t GFMultiply(uint8_t x, uint8_t y)
+{
+    uint8_t result{0};
+    for (; y != 0; y >>= 1)
+    {
+        if ((y & 1) != 0)
+        {
+            result ^= x;
+        }
+        x = static_cast<uint8_t>((x << 1) ^ (((x >> 7) & 1) * 0x1b));
+    }
+    return result;
+}
+
+constexpr uint32_t PackColumn(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    return (uint32_t{b0} << 24) | (uint32_t{b1} << 16) | (uint32_t{b2} << 8) | uint32_t{b3};
+}
+
+constexpr uint32_t RotateRight(uint32_t value, size_t n)
+{
+    return n == 0 ? value : (value >> n) | (value << (32 - n));
+}
+
+using Table = std::array<std::array<uint32_t, 256>, 4>;
+
+// Columns are big-endian words: the first byte of a column is its most significant byte.
+//   `Te[i][x]` is `MixColumns` of `sbox[x]` sitting in row `i`; `Td[i][x]`, `InvMixColumns` of `rsbox[x]`.
+constexpr Table kTe = ([]() {
+    Table result{};
+    for (size_t x = 0; x < 256; x++)
+    {
+        auto s = sbox[x];
+        auto column = PackColumn(GFMultiply(s, 2), s, s, GFMultiply(s, 3));
+        for (size_t i = 0; i < 4; i++)
+        {
+            result[i][x] = RotateRight(column, 8 * i);
+        }
+    }
+    return result;
+})();
+
+constexpr Table kTd = ([]() {
+    Table result{};
+    for (size_t x = 0; x < 256; x++)
+    {
+        auto s = rsbox[x];
+        auto column = PackColumn(GFMultiply(s, 0x0e), GFMultiply(s, 0x09), GFMultiply(s, 0x0d), GFMultiply(s, 0x0b));
+        for (size_t i = 0; i < 4; i++)
+        {
+            result[i][x] = RotateRight(column, 8 * i);
+        }
+    }
+    return result;
+})();
+
+inline uint8_t Byte(uint32_t word, size_t row)
+{
+    return static_cast<uint8_t>(word >> (24 - 8 * row));
+}
+
+inline void LoadRoundKeys(std::array<uint32_t, kMaxRoundKeyWords> &words, const uint8_t *round_keys, size_t rounds)
+{
+    for (size_t i = 0; i < 4 * (rounds + 1); i++)
+    {
+        words[i] = ReadBigEndian<uint32_t>(&round_keys[i * 4]);
+    }
+}
+
+// One round reads row `r` of column `(j + shift[r]) % 4`: ShiftRows moves left when encrypting, right when
+//   decrypting.
+template <bool kDecrypt> inline size_t Column(size_t j, size_t row)
+{
+    return kDecrypt ? (j + 4 - row) % 4 : (j + row) % 4;
+}
+
+template <bool kDecrypt>
+inline uint32_t RoundColumn(const Table &table, const std::array<uint32_t, 4> &s, size_t j, uint32_t round_key)
+{
+    return table[0][Byte(s[Column<kDecrypt>(j, 0)], 0)] ^ table[1][Byte(s[Column<kDecrypt>(j, 1)], 1)] ^
+           table[2][Byte(s[Column<kDecrypt>(j, 2)], 2)] ^ table[3][Byte(s[Column<kDecrypt>(j, 3)], 3)] ^ round_key;
+}
+
+template <bool kDecrypt>
+inline uint32_t LastRoundColumn(const std::array<uint8_t, 256> &last_sbox, const std::array<uint32_t, 4> &s, size_t j,
+                                uint32_t round_key)
+{
+    return PackColumn(last_sbox[Byte(s[Column<kDecrypt>(j, 0)], 0)], last_sbox[Byte(s[Column<kDecrypt>(j, 1)], 1)],
+                      last_sbox[Byte(s[Column<kDecrypt>(j, 2)], 2)], last_sbox[Byte(s[Column<kDecrypt>(j, 3)], 3)]) ^
+           round_key;
+}
+
+// The four columns are spelt out, so that the state stays in registers.
+template <bool kDecrypt>
+inline void TransformBlock(const Table &table, const std::array<uint8_t, 256> &last_sbox, const uint32_t *rk,
+                           size_t rounds, uint8_t *block)
+{
+    std::array<uint32_t, 4> s{
+        ReadBigEndian<uint32_t>(&block[0]) ^ rk[0],
+        ReadBigEndian<uint32_t>(&block[4]) ^ rk[1],
+        ReadBigEndian<uint32_t>(&block[8]) ^ rk[2],
+        ReadBigEndian<uint32_t>(&block[12]) ^ rk[3],
+    };
+
+    for (size_t round = 1; round < rounds; round++)
+    {
+        rk += 4;
+        s = {
+            RoundColumn<kDecrypt>(table, s, 0, rk[0]),
+            RoundColumn<kDecrypt>(table, s, 1, rk[1]),
+            RoundColumn<kDecrypt>(table, s, 2, rk[2]),
+            RoundColumn<kDecrypt>(table, s, 3, rk[3]),
+        };
+    }
+
+    rk += 4;
+    WriteBigEndian(&block[0], LastRoundColumn<kDecrypt>(last_sbox, s, 0, rk[0]));
+    WriteBigEndian(&block[4], LastRoundColumn<kDecrypt>(last_sbox, s, 1, rk[1]));
+    WriteBigEndian(&block[8], LastRoundColumn<kDecrypt>(last_sbox, s, 2, rk[2]));
+    WriteBigEndian(&block[12], LastRoundColumn<kDecrypt>(last_sbox, s, 3, rk[3]));
+}
+
+// NOLINTEND(*-magic-numbers,*-identifier-length)
+
+} // namespace
+
+void EncryptBlocksTTable(const uint8_t *round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks)
+{
+    std::array<uint32_t, kMaxRoundKeyWords> words{};
+    LoadRoundKeys(words, round_keys, rounds);
+    for (size_t i = 0; i < n_blocks; i++)
+    {
+        TransformBlock<false>(kTe, sbox, words.data(), rounds, &buffer[i * kBlockBufferSize]);
+    }
+}
+
+void DecryptBlocksTTable(const uint8_t *inv_round_keys, size_t rounds, uint8_t *buffer, size_t n_blocks)
+{
+    std::array<uint32_t, kMaxRoundKeyWords> words{};
+    LoadRoundKeys(words, inv_round_keys, rounds);
+    for (size_t i = 0; i < n_blocks; i++)
+    {
+        TransformBlock<true>(kTd, rsbox, words.data(), rounds, &buffer[i * kBlockBufferSize]);
+    }
+}
+
+} // namespace parakeet_crypto::cipher::aes::detail
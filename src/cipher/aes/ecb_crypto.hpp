@@ -1,3 +1,4 @@
+#include "aes_backend.h"
 #include "helper.hpp"
 
 #include "parakeet-crypto/cipher/aes/aes.h"
@@ -47,37 +48,86 @@ template <BLOCK_SIZE kBlockSize, typename T> inline void DecryptBlock(const T &r
 }
 
 template <BLOCK_SIZE kBlockSize, CRYPTO_MODE kMode>
-CipherErrorCode AES<kBlockSize, kMode>::TransformBlock(uint8_t *buffer)
+CipherErrorCode AES<kBlockSize, kMode>::TransformBlock(uint8_t *buffer) const
 {
+    return TransformBlocks(buffer, CONFIG::kBlockSize);
+}
+
+template <BLOCK_SIZE kBlockSize, CRYPTO_MODE kMode>
+CipherErrorCode AES<kBlockSize, kMode>::TransformBlocks(uint8_t *buffer, size_t n) const
+{
+    if (n % CONFIG::kBlockSize != 0)
+    {
+        return CipherError::kIncompleteInputData;
+    }
+
+    const auto n_blocks = n / CONFIG::kBlockSize;
     if constexpr (kMode == CRYPTO_MODE::Encrypt)
     {
-        EncryptBlock<kBlockSize>(key_, buffer);
+        switch (backend_)
+        {
+#if PARAKEET_SIMD_X86
+        case AESBackend::AESNI:
+            detail::EncryptBlocksAESNI(key_.data(), CONFIG::kKeyRounds, buffer, n_blocks);
+            break;
+#endif
+        case AESBackend::TTABLE:
+            detail::EncryptBlocksTTable(key_.data(), CONFIG::kKeyRounds, buffer, n_blocks);
+            break;
+        default:
+            for (size_t i = 0; i < n; i += CONFIG::kBlockSize)
+            {
+                EncryptBlock<kBlockSize>(key_, &buffer[i]);
+            }
+            break;
+        }
     }
     else
     {
-        DecryptBlock<kBlockSize>(key_, buffer);
+        switch (backend_)
+        {
+#if PARAKEET_SIMD_X86
+        case AESBackend::AESNI:
+            detail::DecryptBlocksAESNI(inv_key_.data(), CONFIG::kKeyRounds, buffer, n_blocks);
+            break;
+#endif
+        case AESBackend::TTABLE:
+            detail::DecryptBlocksTTable(inv_key_.data(), CONFIG::kKeyRounds, buffer, n_blocks);
+            break;
+        default:
+            for (size_t i = 0; i < n; i += CONFIG::kBlockSize)
+            {
+                DecryptBlock<kBlockSize>(key_, &buffer[i]);
+            }
+            break;
+        }
     }
+
     return CipherError::kSuccess;
 }
 
-// {
-//     const auto *p_in_end = input + n;
-//     while (input < p_in_end)
-//     {
-//         UpdateBlock(output, input);
-//         input += CONFIG::kBlockSize;
-//         output +=
-//     }
-//     return true;
-// }
 // Specializations
 
-template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer);
-template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer);
-template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer);
+template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Encrypt>::TransformBlock(uint8_t *buffer) const;
+
+template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer) const;
+
+template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Encrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Encrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Encrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
 
-template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer);
-template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer);
-template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Decrypt>::TransformBlock(uint8_t *buffer);
+template CipherErrorCode AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_192, CRYPTO_MODE::Decrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
+template CipherErrorCode AES<BLOCK_SIZE::AES_256, CRYPTO_MODE::Decrypt>::TransformBlocks(uint8_t *buffer,
+                                                                                         size_t n) const;
 
 } // namespace parakeet_crypto::cipher::aes
@@ -43,6 +43,20 @@ template <BLOCK_SIZE kBlockSize, CRYPTO_MODE mode> void AES<kBlockSize, mode>::S
 
         p_key_words[i] = p_key_words[i - CONFIG::kKeyWordSize] ^ temp;
     }
+
+    if constexpr (mode == CRYPTO_MODE::Decrypt)
+    {
+        constexpr size_t kRoundKeySize = CONFIG::kBlockSize;
+        for (size_t round = 0; round <= CONFIG::kKeyRounds; round++)
+        {
+            auto *p_inv_round_key = &inv_key_[round * kRoundKeySize];
+            std::copy_n(&key_[(CONFIG::kKeyRounds - round) * kRoundKeySize], kRoundKeySize, p_inv_round_key);
+            if (round != 0 && round != CONFIG::kKeyRounds)
+            {
+                InvMixColumns(p_inv_round_key);
+            }
+        }
+    }
 }
 
 template void AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Encrypt>::SetKey(const uint8_t *key);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "parakeet-crypto/transformer/joox.h"
+
+namespace parakeet_crypto::test
+{
+
+// NOLINTBEGIN(*-magic-numbers)
+
+/**
+ * @brief Config of the JOOX fixtures: install uuid and salt, without a key cache.
+ */
+inline transformer::JooxConfig MakeTestConfig()
+{
+    transformer::JooxConfig config{};
+    config.install_uuid = "ffffffffffffffffffffffffffffffff";
+    config.salt = {0xDA, 0x40, 0x7A, 0x0A, 0x02, 0x60, 0x45, 0x8B, 0xE1, 0x66, 0x2D, 0x3E, 0x37, 0x6D, 0xD1, 0x63};
+    return config;
+}
+
+// NOLINTEND(*-magic-numbers)
+
+} // namespace parakeet_crypto::test
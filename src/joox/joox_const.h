@@ -1,10 +1,36 @@
 #pragma once
 
+#include "parakeet-crypto/KeyDerivationCache.h"
+#include "parakeet-crypto/transformer/joox.h"
+#include "parakeet-crypto/utils/hash/pbkdf2_hmac_sha1.h"
+#include "parakeet-crypto/utils/hash/sha1.h"
+
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace parakeet_crypto::joox
 {
 
 constexpr size_t kDeriveIteration = 1000;
 
+inline std::array<uint8_t, utils::hash::kSHA1DigestSize> DeriveKey(const transformer::JooxConfig &config)
+{
+    auto input = MakeKeyDerivationInput({
+        {config.install_uuid.data(), config.install_uuid.size()},
+        {config.salt.data(), config.salt.size()},
+    });
+    auto derived = parakeet_crypto::DeriveKey(config.key_cache.get(), KeyDerivationKind::JOOX_V4_PBKDF2, input, [&]() {
+        std::vector<uint8_t> key(utils::hash::kSHA1DigestSize);
+        utils::hash::pbkdf2_hmac_sha1(key, config.install_uuid, config.salt, kDeriveIteration);
+        return key;
+    });
+
+    std::array<uint8_t, utils::hash::kSHA1DigestSize> key{};
+    std::copy_n(derived.begin(), key.size(), key.begin());
+    return key;
+}
+
 } // namespace parakeet_crypto::joox
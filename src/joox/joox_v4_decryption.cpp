@@ -1,4 +1,5 @@
 #include "joox/joox_const.h"
+#include "parakeet-crypto/IStreamingDecryptor.h"
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/cipher/aes/aes.h"
 #include "parakeet-crypto/transformer/joox.h"
@@ -6,10 +7,13 @@
 #include "parakeet-crypto/utils/hash/sha1.h"
 #include "utils/endian_helper.h"
 #include "utils/paged_reader.h"
+#include "utils/parallel.h"
+#include "utils/parallel_decrypt.h"
 #include "utils/pkcs7.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -27,17 +31,185 @@ class JooxDecryptionV4Transformer final : public ITransformer
     static constexpr std::size_t kPlainBlockSize = 0x100000;                   // 1MiB
     static constexpr std::size_t kEncryptedBlockSize = kPlainBlockSize + 0x10; // padding (0x10, ...)
 
+    static constexpr std::size_t kVer4HeaderSize = 12; /* 'E!04' + uint64_t_be(file size) */
+    constexpr static std::array<uint8_t, 4> kMagicHeader{'E', '!', '0', '4'};
+
     std::array<uint8_t, utils::hash::kSHA1DigestSize> key_{};
+    size_t thread_count_{1};
 
-    inline void SetupKey(JooxConfig &config)
+    /**
+     * @brief Decrypt AES blocks as they arrive. Keeps the partial AES block received, and the last decrypted block:
+     *        it is only known to be padding once the end of the encrypted block (or file) is reached.
+     */
+    class StreamingDecryptor final : public IStreamingDecryptor
     {
-        utils::hash::pbkdf2_hmac_sha1(key_, config.install_uuid, config.salt, joox::kDeriveIteration);
-    }
+      private:
+        cipher::aes::AES128Dec aes_dec_;
+        TransformResult error_{TransformResult::OK};
+
+        std::array<uint8_t, kVer4HeaderSize> header_{};
+        size_t header_len_{0};
+
+        std::array<uint8_t, kAESBlockSize> carry_{};
+        size_t carry_len_{0};
+        std::array<uint8_t, kAESBlockSize> last_block_{};
+        bool has_last_block_{false};
+        size_t block_offset_{0}; // offset within the current encrypted block
+
+        std::vector<uint8_t> work_;
+
+        [[nodiscard]] bool WriteLastBlock(IWriteable *output, bool is_padded)
+        {
+            size_t len{kAESBlockSize};
+            if (is_padded && !UnpadLastBlock(last_block_, len))
+            {
+                error_ = TransformResult::ERROR_INVALID_KEY;
+                return false;
+            }
+            has_last_block_ = false;
+            if (!output->Write(last_block_.data(), len))
+            {
+                error_ = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+                return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool DecryptBlocks(uint8_t *buffer, size_t n, IWriteable *output)
+        {
+            while (n > 0)
+            {
+                auto process_len = std::min(n, kEncryptedBlockSize - block_offset_);
+                if (aes_dec_.TransformBlocks(buffer, process_len) != cipher::CipherError::kSuccess)
+                {
+                    error_ = TransformResult::ERROR_INVALID_KEY;
+                    return false;
+                }
+                if (has_last_block_ && !WriteLastBlock(output, false))
+                {
+                    return false;
+                }
+
+                auto body_len = process_len - kAESBlockSize;
+                if (body_len > 0 && !output->Write(buffer, body_len))
+                {
+                    error_ = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+                    return false;
+                }
+                std::copy_n(&buffer[body_len], kAESBlockSize, last_block_.begin());
+                has_last_block_ = true;
+
+                block_offset_ += process_len;
+                if (block_offset_ == kEncryptedBlockSize)
+                {
+                    block_offset_ = 0;
+                    if (!WriteLastBlock(output, true))
+                    {
+                        return false;
+                    }
+                }
+
+                buffer += process_len;
+                n -= process_len;
+            }
+            return true;
+        }
+
+      public:
+        StreamingDecryptor(const uint8_t *key) : aes_dec_(key), work_(utils::kDecryptionPageSize)
+        {
+        }
+
+        [[nodiscard]] const char *GetName() const override
+        {
+            return "JOOX (Dv4)";
+        }
+
+        TransformResult Update(const uint8_t *input, size_t len, IWriteable *output) override
+        {
+            if (error_ != TransformResult::OK)
+            {
+                return error_;
+            }
+
+            if (header_len_ < kVer4HeaderSize)
+            {
+                auto copy_len = std::min(len, kVer4HeaderSize - header_len_);
+                std::copy_n(input, copy_len, &header_[header_len_]);
+                header_len_ += copy_len;
+                input += copy_len;
+                len -= copy_len;
+
+                if (header_len_ < kVer4HeaderSize)
+                {
+                    return TransformResult::OK;
+                }
+                if (!std::equal(kMagicHeader.begin(), kMagicHeader.end(), header_.begin()))
+                {
+                    error_ = TransformResult::ERROR_INVALID_FORMAT;
+                    return error_;
+                }
+            }
+
+            if (carry_len_ != 0)
+            {
+                auto copy_len = std::min(len, kAESBlockSize - carry_len_);
+                std::copy_n(input, copy_len, &carry_[carry_len_]);
+                carry_len_ += copy_len;
+                input += copy_len;
+                len -= copy_len;
+
+                if (carry_len_ < kAESBlockSize)
+                {
+                    return TransformResult::OK;
+                }
+                carry_len_ = 0;
+                if (!DecryptBlocks(carry_.data(), carry_.size(), output))
+                {
+                    return error_;
+                }
+            }
+
+            while (len >= kAESBlockSize)
+            {
+                auto process_len = std::min(len, work_.size()) / kAESBlockSize * kAESBlockSize;
+                std::copy_n(input, process_len, work_.begin());
+                if (!DecryptBlocks(work_.data(), process_len, output))
+                {
+                    return error_;
+                }
+                input += process_len;
+                len -= process_len;
+            }
+
+            std::copy_n(input, len, carry_.begin());
+            carry_len_ = len;
+            return TransformResult::OK;
+        }
+
+        TransformResult Final(IWriteable *output) override
+        {
+            if (error_ != TransformResult::OK)
+            {
+                return error_;
+            }
+            if (header_len_ < kVer4HeaderSize || carry_len_ != 0)
+            {
+                error_ = TransformResult::ERROR_INSUFFICIENT_INPUT;
+                return error_;
+            }
+            if (has_last_block_ && !WriteLastBlock(output, true))
+            {
+                return error_;
+            }
+            return TransformResult::OK;
+        }
+    };
 
   public:
-    JooxDecryptionV4Transformer(JooxConfig config)
+    JooxDecryptionV4Transformer(const JooxConfig &config, size_t thread_count)
+        : key_(joox::DeriveKey(config)), thread_count_(thread_count)
     {
-        SetupKey(config);
     }
 
     const char *GetName() override
@@ -47,9 +219,6 @@ class JooxDecryptionV4Transformer final : public ITransformer
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        constexpr std::size_t kVer4HeaderSize = 12; /* 'E!04' + uint64_t_be(file size) */
-        constexpr static std::array<uint8_t, 4> kMagicHeader{'E', '!', '0', '4'};
-
         std::array<uint8_t, kVer4HeaderSize> header{};
         if (!input->ReadExact(header.data(), header.size()))
         {
@@ -60,28 +229,20 @@ class JooxDecryptionV4Transformer final : public ITransformer
             return TransformResult::ERROR_INVALID_FORMAT;
         }
 
-        // auto actual_size = ReadBigEndian<uint64_t>(&header.at(4)); // is this used?
+        const auto payload_offset = input->GetOffset();
+        const auto payload_len = input->GetSize() - payload_offset;
+        if (thread_count_ > 1 && payload_len > kEncryptedBlockSize)
+        {
+            return TransformInParallel(output, input, payload_offset, payload_len);
+        }
 
         using Reader = utils::PagedReader;
-        using namespace cipher::aes;
-        using AES128Dec = AES<BLOCK_SIZE::AES_128, CRYPTO_MODE::Decrypt>;
 
-        AES128Dec aes_dec(key_.data());
+        cipher::aes::AES128Dec aes_dec(key_.data());
         bool io_ok{true};
         auto decrypt_ok = Reader{input}.WithPageSize(kEncryptedBlockSize, [&](size_t, uint8_t *buffer, size_t n) {
-            if (n % AES128Dec::CONFIG::kBlockSize != 0)
-            {
-                return false; // buffer not in blocked size
-            }
-
-            // Decrypt content
-            if (aes_dec.TransformBlocks(buffer, n) != cipher::CipherError::kSuccess)
-            {
-                return false; // buffer not in blocked size
-            }
-
             size_t unpadded_len{0};
-            if (utils::PKCS7_unpad<kAESBlockSize>(buffer, n, unpadded_len) != 0)
+            if (!DecryptBlock(aes_dec, buffer, n, unpadded_len))
             {
                 return false;
             }
@@ -95,11 +256,192 @@ class JooxDecryptionV4Transformer final : public ITransformer
                : io_ok    ? TransformResult::ERROR_INVALID_KEY
                           : TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
     }
+
+    TransformResult Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len) override
+    {
+        if (input_len < kVer4HeaderSize)
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        if (!std::equal(kMagicHeader.begin(), kMagicHeader.end(), input))
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        // The header stores the plaintext size; it must agree with the encrypted payload size.
+        auto plain_size = ReadBigEndian<uint64_t>(&input[4]);
+        auto payload_len = input_len - kVer4HeaderSize;
+        if (plain_size > payload_len || GetEncryptedSize(plain_size) != payload_len)
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+        if (output == nullptr || output_len < plain_size)
+        {
+            output_len = static_cast<size_t>(plain_size);
+            return TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+        }
+
+        const auto aes_dec = cipher::aes::AES128Dec(key_.data());
+        const uint8_t *src = &input[kVer4HeaderSize];
+        if (thread_count_ > 1 && payload_len > kEncryptedBlockSize)
+        {
+            output_len = static_cast<size_t>(plain_size);
+            return TransformBufferInParallel(aes_dec, output, src, payload_len, output_len);
+        }
+
+        uint8_t *dst = output;
+        while (payload_len > 0)
+        {
+            auto block_len = std::min(payload_len, kEncryptedBlockSize);
+            auto dst_len = static_cast<size_t>(plain_size) - (dst - output);
+            size_t plain_len{0};
+            if (!DecryptBlockTo(aes_dec, dst, dst_len, src, block_len, plain_len))
+            {
+                return TransformResult::ERROR_INVALID_KEY;
+            }
+
+            src += block_len;
+            dst += plain_len;
+            payload_len -= block_len;
+        }
+
+        output_len = dst - output;
+        return output_len == plain_size ? TransformResult::OK : TransformResult::ERROR_INVALID_KEY;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<StreamingDecryptor>(key_.data());
+        return TransformResult::OK;
+    }
+
+  private:
+    /**
+     * @brief Decrypt an encrypted block (up to `kEncryptedBlockSize` bytes) in place, and validate its padding.
+     */
+    static bool DecryptBlock(const cipher::aes::AES128Dec &aes_dec, uint8_t *buffer, size_t n, size_t &unpadded_len)
+    {
+        return n % kAESBlockSize == 0 && aes_dec.TransformBlocks(buffer, n) == cipher::CipherError::kSuccess &&
+               utils::PKCS7_unpad<kAESBlockSize>(buffer, n, unpadded_len) == 0;
+    }
+
+    /**
+     * @brief Decrypt an encrypted block to `dst`, which only needs room for its plaintext (`plain_len`).
+     *        Fails if the plaintext is longer than `dst_len`.
+     */
+    static bool DecryptBlockTo(const cipher::aes::AES128Dec &aes_dec, uint8_t *dst, size_t dst_len, const uint8_t *src,
+                               size_t block_len, size_t &plain_len)
+    {
+        // Every block ends with a padded AES block. Decrypt the other AES blocks straight to the output,
+        // and the last one aside: its plaintext is shorter, and may not fit.
+        auto body_len = block_len - kAESBlockSize;
+        if (body_len > dst_len)
+        {
+            return false;
+        }
+        std::copy_n(src, body_len, dst);
+        std::array<uint8_t, kAESBlockSize> tail_block{};
+        std::copy_n(&src[body_len], kAESBlockSize, tail_block.begin());
+        size_t tail_len{0};
+        if (aes_dec.TransformBlocks(dst, body_len) != cipher::CipherError::kSuccess ||
+            aes_dec.TransformBlocks(tail_block) != cipher::CipherError::kSuccess ||
+            !UnpadLastBlock(tail_block, tail_len) || body_len + tail_len > dst_len)
+        {
+            return false;
+        }
+        std::copy_n(tail_block.begin(), tail_len, &dst[body_len]);
+        plain_len = body_len + tail_len;
+        return true;
+    }
+
+    /**
+     * @brief Decrypt several encrypted blocks at once, and write them in order. Each worker holds one block.
+     */
+    TransformResult TransformInParallel(IWriteable *output, IReadSeekable *input, size_t payload_offset,
+                                        size_t payload_len) const
+    {
+        const cipher::aes::AES128Dec aes_dec(key_.data());
+        return utils::ParallelTransformBlocks(
+            output, input, payload_offset, payload_len, kEncryptedBlockSize, kPlainBlockSize, thread_count_,
+            [&](uint8_t *buffer, size_t len, size_t &plain_len) {
+                return DecryptBlock(aes_dec, buffer, len, plain_len) ? TransformResult::OK
+                                                                     : TransformResult::ERROR_INVALID_KEY;
+            });
+    }
+
+    /**
+     * @brief Decrypt the blocks of a buffer on several threads. Every block but the last decrypts to a whole plain
+     *        block, at a known offset of the output.
+     */
+    TransformResult TransformBufferInParallel(const cipher::aes::AES128Dec &aes_dec, uint8_t *output,
+                                              const uint8_t *input, size_t payload_len, size_t plain_size) const
+    {
+        const auto block_count = (payload_len + kEncryptedBlockSize - 1) / kEncryptedBlockSize;
+        std::atomic<bool> failed{false};
+        size_t last_plain_len{0};
+        utils::RunOnThreads(block_count, thread_count_, [&](size_t /*worker*/, size_t block) {
+            auto block_len = std::min(kEncryptedBlockSize, payload_len - block * kEncryptedBlockSize);
+            auto plain_offset = block * kPlainBlockSize;
+            auto dst_len = std::min(kPlainBlockSize, plain_size - plain_offset); // overruns the next block otherwise.
+            size_t plain_len{0};
+            if (failed || !DecryptBlockTo(aes_dec, &output[plain_offset], dst_len, &input[block * kEncryptedBlockSize],
+                                          block_len, plain_len))
+            {
+                failed = true;
+            }
+            else if (block + 1 == block_count)
+            {
+                last_plain_len = plain_len;
+            }
+            else if (plain_len != kPlainBlockSize)
+            {
+                failed = true;
+            }
+        });
+
+        auto total_len = (block_count - 1) * kPlainBlockSize + last_plain_len;
+        return !failed && total_len == plain_size ? TransformResult::OK : TransformResult::ERROR_INVALID_KEY;
+    }
+
+    /**
+     * @brief Validate the PKCS#7 padding of the last AES block of an encrypted block.
+     *        A whole block of padding is valid here.
+     */
+    static bool UnpadLastBlock(const std::array<uint8_t, kAESBlockSize> &block, size_t &unpadded_len)
+    {
+        size_t padding_len = block.back();
+        if (padding_len == 0 || padding_len > kAESBlockSize ||
+            !std::all_of(block.end() - padding_len, block.end(), [&](auto value) { return value == padding_len; }))
+        {
+            return false;
+        }
+        unpadded_len = kAESBlockSize - padding_len;
+        return true;
+    }
+
+    static uint64_t GetEncryptedSize(uint64_t plain_size)
+    {
+        // Each plain block (1MiB, or what is left) is padded to the next multiple of the AES block size.
+        auto full_blocks = plain_size / kPlainBlockSize;
+        auto last_block_len = plain_size % kPlainBlockSize;
+        auto encrypted_size = full_blocks * kEncryptedBlockSize;
+        if (last_block_len != 0)
+        {
+            encrypted_size += (last_block_len / kAESBlockSize + 1) * kAESBlockSize;
+        }
+        return encrypted_size;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateJooxDecryptionV4Transformer(JooxConfig config)
 {
-    return std::make_unique<JooxDecryptionV4Transformer>(std::move(config));
+    return std::make_unique<JooxDecryptionV4Transformer>(config, 1);
+}
+
+std::unique_ptr<ITransformer> CreateJooxDecryptionV4Transformer(JooxConfig config, size_t thread_count)
+{
+    return std::make_unique<JooxDecryptionV4Transformer>(
+        config, thread_count != 0 ? thread_count : utils::GetDefaultThreadCount());
 }
 
 } // namespace parakeet_crypto::transformer
@@ -1,5 +1,8 @@
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/transformer/joox.h"
+
+#include "joox_config.test.hh"
+
 #include "test/read_fixture.test.hh"
 #include "test/test_decryption.test.hh"
 
@@ -7,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <memory>
 
 using namespace parakeet_crypto;
 
@@ -14,11 +18,36 @@ using namespace parakeet_crypto;
 
 TEST(JOOX_v4, DecryptionFixture)
 {
-    transformer::JooxConfig config{};
-    config.install_uuid = "ffffffffffffffffffffffffffffffff";
-    config.salt = {0xDA, 0x40, 0x7A, 0x0A, 0x02, 0x60, 0x45, 0x8B, 0xE1, 0x66, 0x2D, 0x3E, 0x37, 0x6D, 0xD1, 0x63};
+    auto config = test::MakeTestConfig();
     auto transformer = transformer::CreateJooxDecryptionV4Transformer(config);
     test::should_decrypt_to_fixture("joox_[E!04].ofl_en", transformer);
 }
 
+TEST(JOOX_v4, BufferTransform)
+{
+    auto config = test::MakeTestConfig();
+    auto transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    test::should_buffer_transform_to_fixture("joox_[E!04].ofl_en", transformer);
+}
+
+TEST(JOOX_v4, StreamingDecryption)
+{
+    auto config = test::MakeTestConfig();
+    auto transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    test::should_stream_decrypt_to_fixture("joox_[E!04].ofl_en", transformer);
+}
+
+TEST(JOOX_v4, SharedKeyCache)
+{
+    auto config = test::MakeTestConfig();
+    config.key_cache = std::make_shared<KeyDerivationCache>();
+    auto first = transformer::CreateJooxDecryptionV4Transformer(config);
+    auto second = transformer::CreateJooxDecryptionV4Transformer(config);
+    test::should_decrypt_to_fixture("joox_[E!04].ofl_en", second);
+
+    auto stats = config.key_cache->GetStats();
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.hits, 1);
+}
+
 // NOLINTEND (*-magic-numbers,*-non-const-global-variables,cppcoreguidelines-owning-memory)
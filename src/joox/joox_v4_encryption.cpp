@@ -7,6 +7,8 @@
 #include "parakeet-crypto/utils/hash/sha1.h"
 #include "utils/endian_helper.h"
 #include "utils/paged_reader.h"
+#include "utils/parallel.h"
+#include "utils/parallel_decrypt.h"
 
 #include <algorithm>
 #include <array>
@@ -28,16 +30,39 @@ class JooxEncryptionV4Transformer final : public ITransformer
     static constexpr std::size_t kEncryptedBlockSize = kPlainBlockSize + 0x10; // padding (0x10, ...)
 
     std::array<uint8_t, utils::hash::kSHA1DigestSize> key_{};
+    size_t thread_count_{1};
 
-    inline void SetupKey(JooxConfig &config)
+    /**
+     * @brief Encrypt a plain block (up to `kPlainBlockSize` bytes) in place, padded with PKCS#7.
+     *        `buffer` has room for `kEncryptedBlockSize` bytes; returns the encrypted length.
+     */
+    static size_t EncryptBlock(const cipher::aes::AES128Enc &aes_enc, uint8_t *buffer, size_t n)
     {
-        utils::hash::pbkdf2_hmac_sha1(key_, config.install_uuid, config.salt, joox::kDeriveIteration);
+        auto padding_len = kAESBlockSize - n % kAESBlockSize;
+        std::fill_n(&buffer[n], padding_len, static_cast<uint8_t>(padding_len));
+        auto encrypted_len = n + padding_len;
+        return aes_enc.TransformBlocks(buffer, encrypted_len) == cipher::CipherError::kSuccess ? encrypted_len : 0;
+    }
+
+    /**
+     * @brief Encrypt several plain blocks at once, and write them in order. Each worker holds one block.
+     */
+    TransformResult TransformInParallel(IWriteable *output, IReadSeekable *input, size_t plain_offset,
+                                        size_t plain_size) const
+    {
+        const cipher::aes::AES128Enc aes_enc(key_.data());
+        return utils::ParallelTransformBlocks(
+            output, input, plain_offset, plain_size, kPlainBlockSize, kEncryptedBlockSize, thread_count_,
+            [&](uint8_t *buffer, size_t len, size_t &encrypted_len) {
+                encrypted_len = EncryptBlock(aes_enc, buffer, len);
+                return encrypted_len != 0 ? TransformResult::OK : TransformResult::ERROR_OTHER;
+            });
     }
 
   public:
-    JooxEncryptionV4Transformer(JooxConfig config)
+    JooxEncryptionV4Transformer(const JooxConfig &config, size_t thread_count)
+        : key_(joox::DeriveKey(config)), thread_count_(thread_count)
     {
-        SetupKey(config);
     }
 
     const char *GetName() override
@@ -58,6 +83,13 @@ class JooxEncryptionV4Transformer final : public ITransformer
             return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
         }
 
+        const auto plain_offset = input->GetOffset();
+        const auto plain_size = input->GetSize() - plain_offset;
+        if (thread_count_ > 1 && plain_size > kPlainBlockSize)
+        {
+            return TransformInParallel(output, input, plain_offset, plain_size);
+        }
+
         using Reader = utils::PagedReader;
 
         auto aes_enc = cipher::aes::AES128Enc(key_.data());
@@ -94,7 +126,13 @@ class JooxEncryptionV4Transformer final : public ITransformer
 
 std::unique_ptr<ITransformer> CreateJooxEncryptionV4Transformer(JooxConfig config)
 {
-    return std::make_unique<JooxEncryptionV4Transformer>(std::move(config));
+    return std::make_unique<JooxEncryptionV4Transformer>(config, 1);
+}
+
+std::unique_ptr<ITransformer> CreateJooxEncryptionV4Transformer(JooxConfig config, size_t thread_count)
+{
+    return std::make_unique<JooxEncryptionV4Transformer>(
+        config, thread_count != 0 ? thread_count : utils::GetDefaultThreadCount());
 }
 
 } // namespace parakeet_crypto::transformer
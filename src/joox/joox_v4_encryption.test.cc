@@ -1,5 +1,9 @@
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/transformer/joox.h"
+
+#include "joox_config.test.hh"
+
+#include "test/make_sequence.test.hh"
 #include "test/read_fixture.test.hh"
 #include "test/test_decryption.test.hh"
 
@@ -7,7 +11,9 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 using testing::ContainerEq;
 
@@ -18,9 +24,7 @@ using namespace parakeet_crypto;
 TEST(JOOX_v4, EncryptionAndDecryption__Encryption)
 {
     auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
-    transformer::JooxConfig config{};
-    config.install_uuid = "ffffffffffffffffffffffffffffffff";
-    config.salt = {0xDA, 0x40, 0x7A, 0x0A, 0x02, 0x60, 0x45, 0x8B, 0xE1, 0x66, 0x2D, 0x3E, 0x37, 0x6D, 0xD1, 0x63};
+    auto config = test::MakeTestConfig();
 
     auto encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config);
     auto [en_state, en_data] = test::transform_vector(plain, encryption_transformer);
@@ -33,4 +37,97 @@ TEST(JOOX_v4, EncryptionAndDecryption__Encryption)
     ASSERT_THAT(de_data, ContainerEq(plain));
 }
 
+TEST(JOOX_v4, EncryptionAndDecryption__BufferTransform)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    plain.resize(0x200000); // plaintext block aligned: the last encrypted block is padding only.
+    auto config = test::MakeTestConfig();
+
+    // The encryption transformer has no buffer implementation, and falls back to its stream implementation.
+    auto encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config);
+    auto [en_state, en_data] = test::transform_vector(plain, encryption_transformer);
+    ASSERT_EQ(en_state, TransformResult::OK);
+    test::should_buffer_transform_to(plain, en_data, encryption_transformer);
+
+    auto decryption_transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    test::should_buffer_transform_to(en_data, plain, decryption_transformer);
+}
+
+TEST(JOOX_v4, EncryptionAndDecryption__WrongKey)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    plain.resize(0x180000); // spans two encrypted blocks.
+    auto config = test::MakeTestConfig();
+
+    auto encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config);
+    auto [en_state, en_data] = test::transform_vector(plain, encryption_transformer);
+    ASSERT_EQ(en_state, TransformResult::OK);
+
+    // The padding comes from the wrong key: nothing may be written past the plaintext size from the header.
+    constexpr size_t kGuardSize = 64;
+    config.install_uuid = "eeeeeeeeeeeeeeeeeeeeeeeeeeeeeeee";
+    auto decryption_transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    std::vector<uint8_t> output(plain.size() + kGuardSize, 0xCC);
+    size_t output_len = plain.size();
+    ASSERT_EQ(decryption_transformer->Transform(output.data(), output_len, en_data.data(), en_data.size()),
+              TransformResult::ERROR_INVALID_KEY);
+    ASSERT_THAT(std::vector<uint8_t>(output.begin() + static_cast<ptrdiff_t>(plain.size()), output.end()),
+                ContainerEq(std::vector<uint8_t>(kGuardSize, 0xCC)));
+}
+
+TEST(JOOX_v4, EncryptionAndDecryption__StreamingDecryption)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    plain.resize(0x180000); // spans two encrypted blocks.
+    auto config = test::MakeTestConfig();
+
+    auto encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config);
+    auto [en_state, en_data] = test::transform_vector(plain, encryption_transformer);
+    ASSERT_EQ(en_state, TransformResult::OK);
+
+    auto decryption_transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    test::should_stream_decrypt_to(en_data, plain, decryption_transformer);
+
+    // Truncated within an AES block.
+    std::unique_ptr<IStreamingDecryptor> decryptor{};
+    ASSERT_EQ(decryption_transformer->CreateStreamingDecryptor(decryptor), TransformResult::OK);
+    OutputMemoryStream output{};
+    ASSERT_EQ(decryptor->Update(en_data.data(), en_data.size() - 1, &output), TransformResult::OK);
+    ASSERT_EQ(decryptor->Final(&output), TransformResult::ERROR_INSUFFICIENT_INPUT);
+}
+
+TEST(JOOX_v4, EncryptionAndDecryption__Parallel)
+{
+    // Three whole plain blocks, and a partial one.
+    const auto plain = test::make_sequence(0x300000 + 0x1235, 7);
+    auto config = test::MakeTestConfig();
+
+    auto encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config);
+    auto [en_state, en_data] = test::transform_vector(plain, encryption_transformer);
+    ASSERT_EQ(en_state, TransformResult::OK);
+
+    auto parallel_encryption_transformer = transformer::CreateJooxEncryptionV4Transformer(config, 3);
+    auto [parallel_en_state, parallel_en_data] = test::transform_vector(plain, parallel_encryption_transformer);
+    ASSERT_EQ(parallel_en_state, TransformResult::OK);
+    ASSERT_THAT(parallel_en_data, ContainerEq(en_data));
+
+    auto decryption_transformer = transformer::CreateJooxDecryptionV4Transformer(config, 3);
+    auto [de_state, de_data] = test::transform_vector(en_data, decryption_transformer);
+    ASSERT_EQ(de_state, TransformResult::OK);
+    ASSERT_THAT(de_data, ContainerEq(plain));
+    test::should_buffer_transform_to(en_data, plain, decryption_transformer);
+
+    // Bad padding in the second block is still reported as a key error.
+    auto corrupted = en_data;
+    corrupted[12 + 2 * 0x100010 - 1] ^= 0x55;
+    auto [corrupted_state, corrupted_data] = test::transform_vector(corrupted, decryption_transformer);
+    ASSERT_EQ(corrupted_state, TransformResult::ERROR_INVALID_KEY);
+    ASSERT_EQ(corrupted_data.size(), 0x100000); // the first block was written.
+
+    std::vector<uint8_t> output(plain.size());
+    size_t output_len = output.size();
+    ASSERT_EQ(decryption_transformer->Transform(output.data(), output_len, corrupted.data(), corrupted.size()),
+              TransformResult::ERROR_INVALID_KEY);
+}
+
 // NOLINTEND (*-magic-numbers,*-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -52,4 +52,33 @@ TEST(KGMCrypto, Type4)
     test::should_decrypt_to_fixture("test_kgm_v4.kgm", transformer);
 }
 
+TEST(KGMCrypto, RandomAccess)
+{
+    auto transformer = transformer::CreateKGMDecryptionTransformer(GetTestKGMConfig());
+    test::should_random_access_decrypt_to_fixture("test_kgm_v2.kgm", transformer);
+    test::should_random_access_decrypt_to_fixture("test_kgm_v3.kgm", transformer);
+    test::should_random_access_decrypt_to_fixture("test_kgm_v4.kgm", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_kgm_v4.kgm", transformer);
+}
+
+TEST(KGMCrypto, BufferTransform)
+{
+    auto transformer = transformer::CreateKGMDecryptionTransformer(GetTestKGMConfig());
+    test::should_buffer_transform_to_fixture("test_kgm_v4.kgm", transformer);
+}
+
+TEST(KGMCrypto, StreamingDecryption)
+{
+    auto transformer = transformer::CreateKGMDecryptionTransformer(GetTestKGMConfig());
+    test::should_stream_decrypt_to_fixture("test_kgm_v2.kgm", transformer);
+    test::should_stream_decrypt_to_fixture("test_kgm_v4.kgm", transformer);
+}
+
+TEST(KGMCrypto, ReusedAcrossThreads)
+{
+    auto transformer = transformer::CreateKGMDecryptionTransformer(GetTestKGMConfig());
+    test::should_decrypt_concurrently_to_fixture("test_kgm_v3.kgm", transformer);
+    test::should_decrypt_concurrently_to_fixture("test_kgm_v4.kgm", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
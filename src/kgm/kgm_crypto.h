@@ -4,10 +4,15 @@
 #include "kgm_header.h"
 
 #include "parakeet-crypto/transformer/kgm.h"
+#include "utils/xor_helper.h"
+
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace parakeet_crypto::kgm
 {
@@ -23,25 +28,85 @@ enum class Mode
     VPR = 2,
 };
 
+constexpr size_t kType3SlotKeySize = 16;
+constexpr size_t kType3FileKeySize = 17;
+
+/**
+ * @brief Key material derived from a slot key; computed once per transformer, and shared by every file of that slot.
+ */
+struct SlotKey
+{
+    std::vector<uint8_t> key{};                               // Type 2: used as-is.
+    std::array<uint8_t, kType3SlotKeySize> type3_key{};       // Type 3: hashed slot key.
+    std::shared_ptr<const utils::PeriodicXorKey> type4_key{}; // Type 4: expanded slot key; `nullptr` without tables.
+};
+
+std::array<uint8_t, kType3SlotKeySize> DeriveType3SlotKey(const std::vector<uint8_t> &slot_key);
+std::vector<uint8_t> DeriveType4SlotKey(const transformer::KGMConfig &config, const std::vector<uint8_t> &slot_key);
+
+// Per file.
+std::array<uint8_t, kType3FileKeySize> DeriveType3FileKey(const FileHeader &header);
+std::vector<uint8_t> DeriveType4FileKey(const transformer::KGMConfig &config, const FileHeader &header);
+
+/**
+ * @brief Immutable, thread-safe: the configuration and the slot keys derived from it.
+ */
+class KeyStore
+{
+  private:
+    transformer::KGMConfig config_{};
+    std::map<uint32_t, SlotKey> slot_keys_{};
+
+  public:
+    explicit KeyStore(transformer::KGMConfig config) : config_(std::move(config))
+    {
+        const bool has_v4_tables = !config_.v4.slot_key_table.empty() && !config_.v4.file_key_table.empty();
+        for (const auto &[slot, key] : config_.slot_keys)
+        {
+            SlotKey slot_key{};
+            slot_key.key = key;
+            slot_key.type3_key = DeriveType3SlotKey(key);
+            if (auto type4_key = has_v4_tables ? DeriveType4SlotKey(config_, key) : std::vector<uint8_t>{};
+                !type4_key.empty())
+            {
+                slot_key.type4_key = std::make_shared<const utils::PeriodicXorKey>(type4_key);
+            }
+            slot_keys_.emplace(slot, std::move(slot_key));
+        }
+    }
+
+    [[nodiscard]] const transformer::KGMConfig &GetConfig() const
+    {
+        return config_;
+    }
+
+    [[nodiscard]] const SlotKey *FindSlotKey(uint32_t slot) const
+    {
+        auto it = slot_keys_.find(slot);
+        return it == slot_keys_.end() ? nullptr : &it->second;
+    }
+};
+
 class IKGMCrypto
 {
   public:
     virtual ~IKGMCrypto() = default;
-    virtual bool Configure(const transformer::KGMConfig &config, const std::vector<uint8_t> &slot_key,
+    virtual bool Configure(const transformer::KGMConfig &config, const SlotKey &slot_key,
                            const FileHeader &header) = 0;
 
-    virtual void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) = 0;
-    virtual void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) = 0;
+    // Neither modifies the crypto state: a configured crypto can be used from several threads.
+    virtual void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) const = 0;
+    virtual void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) const = 0;
 };
 
 std::unique_ptr<IKGMCrypto> CreateKGMCryptoType2();
 std::unique_ptr<IKGMCrypto> CreateKGMCryptoType3();
 std::unique_ptr<IKGMCrypto> CreateKGMCryptoType4();
 
-inline std::unique_ptr<IKGMCrypto> CreateKGMCrypto(const FileHeader &header, const transformer::KGMConfig &config)
+inline std::unique_ptr<IKGMCrypto> CreateKGMCrypto(const FileHeader &header, const KeyStore &key_store)
 {
-    auto slot_key_it = config.slot_keys.find(header.key_slot);
-    if (slot_key_it == config.slot_keys.end())
+    const auto *slot_key = key_store.FindSlotKey(header.key_slot);
+    if (slot_key == nullptr)
     {
         return nullptr;
     }
@@ -60,7 +125,7 @@ inline std::unique_ptr<IKGMCrypto> CreateKGMCrypto(const FileHeader &header, con
         }
     })();
 
-    if (kgm_crypto && kgm_crypto->Configure(config, slot_key_it->second, header))
+    if (kgm_crypto && kgm_crypto->Configure(key_store.GetConfig(), *slot_key, header))
     {
         return kgm_crypto;
     }
@@ -68,8 +133,7 @@ inline std::unique_ptr<IKGMCrypto> CreateKGMCrypto(const FileHeader &header, con
     return nullptr;
 }
 
-inline std::unique_ptr<IKGMCrypto> CreateKGMDecryptionCrypto(const FileHeader &header,
-                                                             const transformer::KGMConfig &config)
+inline std::unique_ptr<IKGMCrypto> CreateKGMDecryptionCrypto(const FileHeader &header, const KeyStore &key_store)
 {
     Mode mode{Mode::KGM};
     if (IsKGMHeader(&header.magic_header[0]))
@@ -85,7 +149,7 @@ inline std::unique_ptr<IKGMCrypto> CreateKGMDecryptionCrypto(const FileHeader &h
         return nullptr;
     }
 
-    auto kgm_crypto = CreateKGMCrypto(header, config);
+    auto kgm_crypto = CreateKGMCrypto(header, key_store);
     if (!kgm_crypto)
     {
         return nullptr;
@@ -1,7 +1,12 @@
 #include "kgm_crypto.h"
+#include "kgm_kernel.h"
+#include "utils/xor_helper.h"
+
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace parakeet_crypto::kgm
 {
@@ -9,52 +14,43 @@ namespace parakeet_crypto::kgm
 class KGMCryptoType2 final : public IKGMCrypto
 {
   private:
-    // provide a fixed size of 4 to let compiler optimise
-    std::array<uint8_t, 4> key_{};
+    static constexpr size_t kKeySize = 4;
+
+    // The combined keystream is the first bytes of the slot key.
+    std::optional<utils::PeriodicXorKey> key_{};
 
   public:
-    bool Configure(const transformer::KGMConfig & /*config*/, const std::vector<uint8_t> &slot_key,
+    bool Configure(const transformer::KGMConfig & /*config*/, const SlotKey &slot_key,
                    const FileHeader & /*header*/) override
     {
-        if (slot_key.size() < key_.size())
+        if (slot_key.key.size() < kKeySize)
         {
             return false;
         }
 
-        std::copy_n(slot_key.begin(), key_.size(), key_.begin());
+        key_.emplace(slot_key.key.data(), kKeySize);
         return true;
     }
 
-    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len)
+    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len) const
     {
-        auto *end = buffer + len;
-        for (auto *it = buffer; it < end; it++)
+        while (len > 0)
         {
-            uint8_t key = key_[offset % key_.size()];
-
-            auto v = *it; // NOLINT(readability-identifier-length)
-            if constexpr (IS_ENCRYPT)
-            {
-                v ^= key;
-                v ^= v << 4;
-            }
-            else
-            {
-                v ^= v << 4;
-                v ^= key;
-            }
-            *it = v;
+            auto process_len = std::min(len, utils::PeriodicXorKey::kMinExpandedWindow);
+            XorShift<IS_ENCRYPT>(buffer, key_->GetWindow(static_cast<size_t>(offset)), process_len, 0, 0, 0);
 
-            offset++;
+            offset += process_len;
+            buffer += process_len;
+            len -= process_len;
         }
     }
 
-    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<true>(offset, buffer, len);
     }
 
-    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<false>(offset, buffer, len);
     }
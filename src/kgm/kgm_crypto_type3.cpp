@@ -1,90 +1,98 @@
 #include "kgm_crypto.h"
+#include "kgm_kernel.h"
 #include "parakeet-crypto/utils/hash/md5.h"
-#include "utils/loop_iterator.h"
+#include "utils/xor_helper.h"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace parakeet_crypto::kgm
 {
 using utils::hash::kMD5DigestSize;
 
-class KGMCryptoType3 final : public IKGMCrypto
+namespace
 {
-  private:
-    // NOLINTBEGIN(*-magic-numbers)
-    std::array<uint8_t, 16> slot_key_{};
-    std::array<uint8_t, 17> file_key_{};
-    // NOLINTEND(*-magic-numbers)
 
-    static inline std::array<uint8_t, kMD5DigestSize> hash_type3(const uint8_t *data, size_t len)
-    {
-        constexpr size_t kDigestMidIndex = kMD5DigestSize / 2;
-        auto digest = utils::hash::md5(data, len);
+inline std::array<uint8_t, kMD5DigestSize> hash_type3(const uint8_t *data, size_t len)
+{
+    auto digest = utils::hash::md5(data, len);
 
-        // Reverse 2-bytes at a time.
-        for (int i = 0; i < kMD5DigestSize / 2; i += 2)
-        {
-            std::swap(digest[i + 0], digest[kMD5DigestSize - 2 - i]);
-            std::swap(digest[i + 1], digest[kMD5DigestSize - 1 - i]);
-        }
-        return digest;
+    // Reverse 2-bytes at a time.
+    for (int i = 0; i < kMD5DigestSize / 2; i += 2)
+    {
+        std::swap(digest[i + 0], digest[kMD5DigestSize - 2 - i]);
+        std::swap(digest[i + 1], digest[kMD5DigestSize - 1 - i]);
     }
+    return digest;
+}
+
+} // namespace
+
+std::array<uint8_t, kType3SlotKeySize> DeriveType3SlotKey(const std::vector<uint8_t> &slot_key)
+{
+    static_assert(kType3SlotKeySize == kMD5DigestSize);
+    return hash_type3(slot_key.data(), slot_key.size());
+}
+
+std::array<uint8_t, kType3FileKeySize> DeriveType3FileKey(const FileHeader &header)
+{
+    static_assert(sizeof(header.file_key) == 16); // NOLINT(*-magic-numbers)
+
+    std::array<uint8_t, kType3FileKeySize> file_key{};
+    auto file_key_hash = hash_type3(&header.file_key[0], sizeof(header.file_key));
+    std::copy(file_key_hash.cbegin(), file_key_hash.cend(), file_key.begin());
+    file_key.back() = 'k';
+    return file_key;
+}
+
+class KGMCryptoType3 final : public IKGMCrypto
+{
+  private:
+    static constexpr size_t kKeyPeriod = kType3SlotKeySize * kType3FileKeySize; // 272
+
+    // `slot_key[i % 16] ^ M(file_key[i % 17])`, see `kgm_kernel.h`.
+    std::optional<utils::PeriodicXorKey> key_{};
 
   public:
-    bool Configure(const transformer::KGMConfig & /*config*/, const std::vector<uint8_t> &slot_key,
+    bool Configure(const transformer::KGMConfig & /*config*/, const SlotKey &slot_key,
                    const FileHeader &header) override
     {
-        static_assert(sizeof(header.file_key) == 16); // NOLINT(*-magic-numbers)
-
-        slot_key_ = hash_type3(slot_key.data(), slot_key.size());
-        auto file_key = hash_type3(&header.file_key[0], sizeof(header.file_key));
-        std::copy(file_key.cbegin(), file_key.cend(), file_key_.begin());
-        file_key_.back() = 'k';
+        auto file_key = DeriveType3FileKey(header);
+        std::array<uint8_t, kKeyPeriod> key{};
+        for (size_t i = 0; i < kKeyPeriod; i++)
+        {
+            key[i] = slot_key.type3_key[i % kType3SlotKeySize] ^ ShiftXor(file_key[i % kType3FileKeySize]);
+        }
+        key_.emplace(key);
 
         return true;
     }
 
-    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len)
+    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len) const
     {
-        utils::LoopIterator slot_key{slot_key_.data(), slot_key_.size(), static_cast<size_t>(offset)};
-        utils::LoopIterator file_key{file_key_.data(), file_key_.size(), static_cast<size_t>(offset)};
-
-        auto *end = buffer + len;
-        for (auto *it = buffer; it < end; it++)
+        while (len > 0)
         {
-            uint8_t offset_key = xor_u32_bytes(static_cast<uint32_t>(offset));
-
-            auto v = *it; // NOLINT(readability-identifier-length)
-            if constexpr (IS_ENCRYPT)
-            {
-                v ^= offset_key;
-                v ^= slot_key.Get();
-                v ^= v << 4;
-                v ^= file_key.Get();
-            }
-            else
-            {
-                v ^= file_key.Get();
-                v ^= v << 4;
-                v ^= slot_key.Get();
-                v ^= offset_key;
-            }
-            *it = v;
-
-            offset++;
-            slot_key.Next();
-            file_key.Next();
+            auto process_len = std::min(len, utils::PeriodicXorKey::kMinExpandedWindow);
+            const auto *key = key_->GetWindow(static_cast<size_t>(offset));
+            XorShiftWithOffsetKey<IS_ENCRYPT>(offset, buffer, key, process_len, 0);
+
+            offset += process_len;
+            buffer += process_len;
+            len -= process_len;
         }
     }
 
-    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<true>(offset, buffer, len);
     }
 
-    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<false>(offset, buffer, len);
     }
@@ -1,12 +1,16 @@
 #include "kgm/kgm_header.h"
 #include "kgm_crypto.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 #include "parakeet-crypto/transformer/kgm.h"
 #include "parakeet-crypto/utils/base64.h"
 #include "parakeet-crypto/utils/hash/md5.h"
 #include "parakeet-crypto/utils/hex.h"
-#include "utils/loop_iterator.h"
+#include "kgm_kernel.h"
+#include "utils/xor_helper.h"
+
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -14,130 +18,138 @@
 namespace parakeet_crypto::kgm
 {
 
-class KGMCryptoType4 final : public IKGMCrypto
+namespace
 {
-  private:
-    static constexpr size_t kKugouType4DigestSize = 31;
-    std::vector<uint8_t> slot_key_;
-    std::vector<uint8_t> file_key_;
 
-    static inline std::array<uint8_t, kKugouType4DigestSize> hash_type4(const uint8_t *data, size_t len)
+constexpr size_t kKugouType4DigestSize = 31;
+
+inline std::array<uint8_t, kKugouType4DigestSize> hash_type4(const uint8_t *data, size_t len)
+{
+    static constexpr std::array<size_t, kKugouType4DigestSize> kDigestIndexes = {
+        0x05, 0x0e, 0x0d, 0x02, 0x0c, 0x0a, 0x0f, 0x0b, 0x03, 0x08, 0x05, 0x06, 0x09, 0x04, 0x03, 0x07,
+        0x00, 0x0e, 0x0d, 0x06, 0x02, 0x0c, 0x0a, 0x0f, 0x01, 0x0b, 0x08, 0x07, 0x09, 0x04, 0x01,
+    };
+
+    auto digest = utils::hash::md5(data, len);
+    std::array<uint8_t, kKugouType4DigestSize> result{};
+    for (int i = 0; i < kKugouType4DigestSize; i++)
     {
-        static constexpr std::array<size_t, kKugouType4DigestSize> kDigestIndexes = {
-            0x05, 0x0e, 0x0d, 0x02, 0x0c, 0x0a, 0x0f, 0x0b, 0x03, 0x08, 0x05, 0x06, 0x09, 0x04, 0x03, 0x07,
-            0x00, 0x0e, 0x0d, 0x06, 0x02, 0x0c, 0x0a, 0x0f, 0x01, 0x0b, 0x08, 0x07, 0x09, 0x04, 0x01,
-        };
-
-        auto digest = utils::hash::md5(data, len);
-        std::array<uint8_t, kKugouType4DigestSize> result{};
-        for (int i = 0; i < kKugouType4DigestSize; i++)
-        {
-            result[i] = digest[kDigestIndexes[i]];
-        }
-        return result;
+        result[i] = digest[kDigestIndexes[i]];
     }
+    return result;
+}
+
+std::vector<uint8_t> key_expansion(const std::vector<uint8_t> &table, const uint8_t *key, size_t key_len)
+{
+    size_t table_len = table.size();
+    auto md5_final = hash_type4(key, key_len);
+    auto final_key_size = 4 * (kKugouType4DigestSize - 1) * (table_len - 1);
 
-    static std::vector<uint8_t> key_expansion(const std::vector<uint8_t> &table, //
-                                              const uint8_t *key, size_t key_len)
+    std::vector<uint8_t> expanded_key(final_key_size, 0);
+    auto *p_key = expanded_key.data();
+    for (uint32_t i = 1; i < kKugouType4DigestSize; i++)
     {
-        size_t table_len = table.size();
-        auto md5_final = hash_type4(key, key_len);
-        auto final_key_size = 4 * (kKugouType4DigestSize - 1) * (table_len - 1);
+        auto temp1 = i * static_cast<uint32_t>(md5_final[i]);
 
-        std::vector<uint8_t> expanded_key(final_key_size, 0);
-        auto *p_key = expanded_key.data();
-        for (uint32_t i = 1; i < kKugouType4DigestSize; i++)
+        for (uint32_t j = 1; j < static_cast<uint32_t>(table_len); j++)
         {
-            auto temp1 = i * static_cast<uint32_t>(md5_final[i]);
-
-            for (uint32_t j = 1; j < static_cast<uint32_t>(table_len); j++)
-            {
-                uint32_t temp = temp1 * j * static_cast<uint32_t>(table[j]);
-
-                // NOLINTBEGIN (*-magic-numbers)
-                *p_key++ = static_cast<uint8_t>(temp >> 0x00);
-                *p_key++ = static_cast<uint8_t>(temp >> 0x18);
-                *p_key++ = static_cast<uint8_t>(temp >> 0x10);
-                *p_key++ = static_cast<uint8_t>(temp >> 0x08);
-                // NOLINTEND (*-magic-numbers)
-            }
+            uint32_t temp = temp1 * j * static_cast<uint32_t>(table[j]);
+
+            // NOLINTBEGIN (*-magic-numbers)
+            *p_key++ = static_cast<uint8_t>(temp >> 0x00);
+            *p_key++ = static_cast<uint8_t>(temp >> 0x18);
+            *p_key++ = static_cast<uint8_t>(temp >> 0x10);
+            *p_key++ = static_cast<uint8_t>(temp >> 0x08);
+            // NOLINTEND (*-magic-numbers)
         }
+    }
 
-        assert((p_key - expanded_key.data()) == expanded_key.size()); // NOLINT
+    assert((p_key - expanded_key.data()) == expanded_key.size()); // NOLINT
 
-        return expanded_key;
-    }
+    return expanded_key;
+}
+
+} // namespace
 
-    inline void configure_slot_key(const transformer::KGMConfig &config, const std::vector<uint8_t> &slot_key)
+std::vector<uint8_t> DeriveType4SlotKey(const transformer::KGMConfig &config, const std::vector<uint8_t> &slot_key)
+{
+    const auto &table = config.v4.slot_key_table;
+    if (table.empty())
     {
-        using namespace parakeet_crypto::utils;
+        return {};
+    }
+
+    auto input = MakeKeyDerivationInput({{table.data(), table.size()}, {slot_key.data(), slot_key.size()}});
+    return DeriveKey(config.key_cache.get(), KeyDerivationKind::KGM_V4_SLOT_KEY, input, [&]() {
         auto slot_key_md5 = utils::hash::md5(slot_key.data(), slot_key.size());
         auto md5_hex = utils::Hex(slot_key_md5.data(), slot_key_md5.size(), false);
         auto md5_b64 = utils::Base64Encode(std::move(md5_hex));
-        slot_key_ = key_expansion(config.v4.slot_key_table, md5_b64.data(), md5_b64.size());
-    }
+        return key_expansion(table, md5_b64.data(), md5_b64.size());
+    });
+}
 
-    inline void configure_file_key(const transformer::KGMConfig &config, const FileHeader &header)
+std::vector<uint8_t> DeriveType4FileKey(const transformer::KGMConfig &config, const FileHeader &header)
+{
+    const auto &table = config.v4.file_key_table;
+    if (table.empty())
     {
-        file_key_ = key_expansion(config.v4.file_key_table, &header.file_key[0], sizeof(header.file_key));
+        return {};
     }
 
+    auto input = MakeKeyDerivationInput({
+        {table.data(), table.size()},
+        {&header.file_key[0], sizeof(header.file_key)},
+    });
+    return DeriveKey(config.key_cache.get(), KeyDerivationKind::KGM_V4_FILE_KEY, input, [&]() {
+        return key_expansion(table, &header.file_key[0], sizeof(header.file_key));
+    });
+}
+
+class KGMCryptoType4 final : public IKGMCrypto
+{
+  private:
+    std::shared_ptr<const utils::PeriodicXorKey> slot_key_{};
+
+    // One byte per period of the slot key: folded into the keystream as `M(file_key[row])`, see `kgm_kernel.h`.
+    std::vector<uint8_t> file_key_;
+
   public:
-    bool Configure(const transformer::KGMConfig &config, const std::vector<uint8_t> &slot_key,
-                   const FileHeader &header) override
+    bool Configure(const transformer::KGMConfig &config, const SlotKey &slot_key, const FileHeader &header) override
     {
-        if (config.v4.slot_key_table.empty() || config.v4.file_key_table.empty())
+        if (slot_key.type4_key == nullptr || config.v4.file_key_table.empty())
         {
             return false;
         }
 
-        configure_slot_key(config, slot_key);
-        configure_file_key(config, header);
-        return true;
+        slot_key_ = slot_key.type4_key;
+        file_key_ = DeriveType4FileKey(config, header);
+        return !file_key_.empty();
     }
 
-    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len)
+    template <bool IS_ENCRYPT> void EncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len) const
     {
-        utils::LoopIterator slot_key{slot_key_.data(), slot_key_.size(), static_cast<size_t>(offset)};
-        utils::LoopIterator file_key{file_key_.data(), file_key_.size(),
-                                     static_cast<size_t>(offset / slot_key_.size())};
-
-        auto *end = buffer + len;
-        for (auto *it = buffer; it < end; it++)
+        const auto slot_key_len = slot_key_->GetKeyLength();
+        while (len > 0)
         {
-            uint8_t offset_key = xor_u32_bytes(static_cast<uint32_t>(offset));
-
-            auto v = *it; // NOLINT(readability-identifier-length)
-            if constexpr (IS_ENCRYPT)
-            {
-                v ^= offset_key;
-                v ^= slot_key.Get();
-                v ^= v << 4;
-                v ^= file_key.Get();
-            }
-            else
-            {
-                v ^= file_key.Get();
-                v ^= v << 4;
-                v ^= slot_key.Get();
-                v ^= offset_key;
-            }
-            *it = v;
-
-            offset++;
-            if (slot_key.Next())
-            {
-                file_key.Next();
-            }
+            auto slot_key_offset = static_cast<size_t>(offset % slot_key_len);
+            auto process_len =
+                std::min({len, slot_key_len - slot_key_offset, utils::PeriodicXorKey::kMinExpandedWindow});
+            auto file_key = file_key_[static_cast<size_t>((offset / slot_key_len) % file_key_.size())];
+            XorShiftWithOffsetKey<IS_ENCRYPT>(offset, buffer, slot_key_->GetWindow(slot_key_offset), process_len,
+                                              ShiftXor(file_key));
+
+            offset += process_len;
+            buffer += process_len;
+            len -= process_len;
         }
     }
 
-    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Encrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<true>(offset, buffer, len);
     }
 
-    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) override
+    void Decrypt(uint64_t offset, uint8_t *buffer, size_t len) const override
     {
         EncryptDecrypt<false>(offset, buffer, len);
     }
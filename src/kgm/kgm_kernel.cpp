@@ -0,0 +1,149 @@
+#include "kgm_kernel.h"
+#include "utils/simd_target.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto::kgm
+{
+
+namespace
+{
+
+template <bool IS_ENCRYPT>
+void XorShiftScalar(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len, uint8_t ramp_base,
+                    uint8_t ramp_mask, uint8_t fill)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        auto ramp = static_cast<uint8_t>(ramp_base + i);
+        auto k = static_cast<uint8_t>(key[i] ^ (ramp & ramp_mask) ^ fill); // NOLINT(readability-identifier-length)
+        if constexpr (IS_ENCRYPT)
+        {
+            dst[i] = ShiftXor(static_cast<uint8_t>(src[i] ^ k));
+        }
+        else
+        {
+            dst[i] = static_cast<uint8_t>(ShiftXor(src[i]) ^ k);
+        }
+    }
+}
+
+#if PARAKEET_SIMD_X86
+
+// NOLINTBEGIN(*-reinterpret-cast,*-magic-numbers)
+
+template <bool IS_ENCRYPT>
+PARAKEET_TARGET("sse2")
+void XorShiftSSE2(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len, uint8_t ramp_base,
+                  uint8_t ramp_mask, uint8_t fill)
+{
+    constexpr size_t kLaneSize = sizeof(__m128i);
+    const auto high_nibbles = _mm_set1_epi8(static_cast<char>(0xF0));
+    const auto ramp_step = _mm_set1_epi8(static_cast<char>(kLaneSize));
+    const auto mask = _mm_set1_epi8(static_cast<char>(ramp_mask));
+    const auto fill_vec = _mm_set1_epi8(static_cast<char>(fill));
+    auto ramp = _mm_add_epi8(_mm_set1_epi8(static_cast<char>(ramp_base)),
+                             _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+    size_t i = 0;
+    for (; i + kLaneSize <= len; i += kLaneSize)
+    {
+        auto k = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&key[i])),
+                               _mm_xor_si128(_mm_and_si128(ramp, mask), fill_vec));
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[i]));
+        if constexpr (IS_ENCRYPT)
+        {
+            v = _mm_xor_si128(v, k);
+        }
+        // No 8-bit shift: shift the 16-bit lanes, and drop the bits carried into the next byte.
+        v = _mm_xor_si128(v, _mm_and_si128(_mm_slli_epi16(v, 4), high_nibbles));
+        if constexpr (!IS_ENCRYPT)
+        {
+            v = _mm_xor_si128(v, k);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&dst[i]), v);
+        ramp = _mm_add_epi8(ramp, ramp_step);
+    }
+
+    XorShiftScalar<IS_ENCRYPT>(&dst[i], &src[i], &key[i], len - i, static_cast<uint8_t>(ramp_base + i), ramp_mask,
+                               fill);
+}
+
+template <bool IS_ENCRYPT>
+PARAKEET_TARGET("avx2")
+void XorShiftAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len, uint8_t ramp_base,
+                  uint8_t ramp_mask, uint8_t fill)
+{
+    constexpr size_t kLaneSize = sizeof(__m256i);
+    const auto high_nibbles = _mm256_set1_epi8(static_cast<char>(0xF0));
+    const auto ramp_step = _mm256_set1_epi8(static_cast<char>(kLaneSize));
+    const auto mask = _mm256_set1_epi8(static_cast<char>(ramp_mask));
+    const auto fill_vec = _mm256_set1_epi8(static_cast<char>(fill));
+    auto ramp = _mm256_add_epi8(_mm256_set1_epi8(static_cast<char>(ramp_base)),
+                                _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, //
+                                                 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31));
+
+    size_t i = 0;
+    for (; i + kLaneSize <= len; i += kLaneSize)
+    {
+        auto k = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&key[i])),
+                                  _mm256_xor_si256(_mm256_and_si256(ramp, mask), fill_vec));
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&src[i]));
+        if constexpr (IS_ENCRYPT)
+        {
+            v = _mm256_xor_si256(v, k);
+        }
+        v = _mm256_xor_si256(v, _mm256_and_si256(_mm256_slli_epi16(v, 4), high_nibbles));
+        if constexpr (!IS_ENCRYPT)
+        {
+            v = _mm256_xor_si256(v, k);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&dst[i]), v);
+        ramp = _mm256_add_epi8(ramp, ramp_step);
+    }
+
+    XorShiftSSE2<IS_ENCRYPT>(&dst[i], &src[i], &key[i], len - i, static_cast<uint8_t>(ramp_base + i), ramp_mask,
+                             fill);
+}
+
+// NOLINTEND(*-reinterpret-cast,*-magic-numbers)
+
+#endif // PARAKEET_SIMD_X86
+
+template <bool IS_ENCRYPT>
+void XorShiftWithKernel(utils::XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len,
+                        uint8_t ramp_base, uint8_t ramp_mask, uint8_t fill)
+{
+    switch (kernel)
+    {
+#if PARAKEET_SIMD_X86
+    case utils::XorKernel::SSE2:
+        XorShiftSSE2<IS_ENCRYPT>(dst, src, key, len, ramp_base, ramp_mask, fill);
+        break;
+    case utils::XorKernel::AVX2:
+    case utils::XorKernel::AVX512: // Byte shifts need AVX-512BW; AVX2 is already memory bound.
+        XorShiftAVX2<IS_ENCRYPT>(dst, src, key, len, ramp_base, ramp_mask, fill);
+        break;
+#endif
+    default:
+        XorShiftScalar<IS_ENCRYPT>(dst, src, key, len, ramp_base, ramp_mask, fill);
+        break;
+    }
+}
+
+} // namespace
+
+void XorShiftDecrypt(utils::XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len,
+                     uint8_t ramp_base, uint8_t ramp_mask, uint8_t fill)
+{
+    XorShiftWithKernel<false>(kernel, dst, src, key, len, ramp_base, ramp_mask, fill);
+}
+
+void XorShiftEncrypt(utils::XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len,
+                     uint8_t ramp_base, uint8_t ramp_mask, uint8_t fill)
+{
+    XorShiftWithKernel<true>(kernel, dst, src, key, len, ramp_base, ramp_mask, fill);
+}
+
+} // namespace parakeet_crypto::kgm
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "utils/xor_helper.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto::kgm
+{
+
+// All KGM types share the same per-byte step around `v ^= v << 4`, written `M(v)` below. On a byte, `M` is linear
+//   and its own inverse: every key byte of a type can be folded into a single combined keystream `k`, so that
+//   decryption is `M(c) ^ k` and encryption is `M(p ^ k)`.
+//
+// Within a 256-byte block of the file, the offset byte (`xor_u32_bytes(offset)`) is the low byte of the offset
+//   (a ramp) XOR the other three bytes (a constant, folded into `fill`).
+
+/**
+ * @brief Decrypt: `dst[i] = M(src[i]) ^ k[i]`, with `k[i] = key[i] ^ ((ramp_base + i) & ramp_mask) ^ fill`.
+ *        The ramp wraps at 256. `dst` and `src` can point to the same buffer.
+ */
+void XorShiftDecrypt(utils::XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len,
+                     uint8_t ramp_base, uint8_t ramp_mask, uint8_t fill);
+
+/**
+ * @brief Encrypt: `dst[i] = M(src[i] ^ k[i])`, with `k[i]` as in `XorShiftDecrypt`.
+ */
+void XorShiftEncrypt(utils::XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len,
+                     uint8_t ramp_base, uint8_t ramp_mask, uint8_t fill);
+
+template <bool IS_ENCRYPT>
+inline void XorShift(uint8_t *buffer, const uint8_t *key, size_t len, uint8_t ramp_base, uint8_t ramp_mask,
+                     uint8_t fill)
+{
+    static const auto kKernel = utils::GetXorKernel();
+    if constexpr (IS_ENCRYPT)
+    {
+        XorShiftEncrypt(kKernel, buffer, buffer, key, len, ramp_base, ramp_mask, fill);
+    }
+    else
+    {
+        XorShiftDecrypt(kKernel, buffer, buffer, key, len, ramp_base, ramp_mask, fill);
+    }
+}
+
+/**
+ * @brief `M(v) = v ^ (v << 4)`.
+ */
+inline uint8_t ShiftXor(uint8_t value)
+{
+    return static_cast<uint8_t>(value ^ (value << 4)); // NOLINT(*-magic-numbers)
+}
+
+/**
+ * @brief Apply a run of combined keystream (`key`, without the offset byte) to `len` bytes at `offset`, with the
+ *        offset byte of types 3 and 4, one 256-byte block at a time.
+ */
+template <bool IS_ENCRYPT>
+inline void XorShiftWithOffsetKey(uint64_t offset, uint8_t *buffer, const uint8_t *key, size_t len, uint8_t fill)
+{
+    constexpr size_t kRampSize = 0x100;
+    constexpr uint8_t kRampMask = 0xFF;
+    while (len > 0)
+    {
+        auto ramp_base = static_cast<uint8_t>(offset);
+        auto process_len = std::min(len, kRampSize - ramp_base);
+
+        // NOLINTNEXTLINE(*-magic-numbers)
+        auto high_bytes = static_cast<uint8_t>((offset >> 24) ^ (offset >> 16) ^ (offset >> 8));
+        XorShift<IS_ENCRYPT>(buffer, key, process_len, ramp_base, kRampMask, static_cast<uint8_t>(fill ^ high_bytes));
+
+        offset += process_len;
+        buffer += process_len;
+        key += process_len;
+        len -= process_len;
+    }
+}
+
+} // namespace parakeet_crypto::kgm
@@ -0,0 +1,147 @@
+#include "kgm_crypto.h"
+#include "kgm_kernel.h"
+
+#include "test/make_sequence.test.hh"
+#include "test/read_fixture.test.hh"
+#include "utils/xor_helper.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+using namespace parakeet_crypto::kgm;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+// The original byte-at-a-time implementation of types 3 and 4.
+template <bool IS_ENCRYPT>
+void ReferenceEncryptDecrypt(uint64_t offset, uint8_t *buffer, size_t len, const uint8_t *slot_key,
+                             size_t slot_key_len, const uint8_t *file_key, size_t file_key_len, bool is_type4)
+{
+    for (size_t i = 0; i < len; i++, offset++)
+    {
+        uint8_t slot = slot_key[offset % slot_key_len];
+        uint8_t file = file_key[(is_type4 ? offset / slot_key_len : offset) % file_key_len];
+        uint8_t offset_key = xor_u32_bytes(static_cast<uint32_t>(offset));
+
+        auto v = buffer[i]; // NOLINT(readability-identifier-length)
+        if constexpr (IS_ENCRYPT)
+        {
+            v ^= offset_key;
+            v ^= slot;
+            v ^= v << 4;
+            v ^= file;
+        }
+        else
+        {
+            v ^= file;
+            v ^= v << 4;
+            v ^= slot;
+            v ^= offset_key;
+        }
+        buffer[i] = v;
+    }
+}
+
+} // namespace
+
+TEST(KGMKernel, AllKernelsMatchScalar)
+{
+    const auto src = test::make_sequence(1000, 1);
+    const auto key = test::make_sequence(1000, 2);
+    for (auto kernel : {utils::XorKernel::SSE2, utils::XorKernel::AVX2, utils::XorKernel::AVX512})
+    {
+        if (!utils::IsXorKernelSupported(kernel))
+        {
+            continue;
+        }
+
+        for (size_t len : {0, 1, 15, 16, 33, 255, 1000})
+        {
+            for (uint8_t ramp_base : {0, 7, 250})
+            {
+                for (uint8_t ramp_mask : {0x00, 0xFF})
+                {
+                    std::vector<uint8_t> expected(len);
+                    std::vector<uint8_t> actual(len);
+                    XorShiftDecrypt(utils::XorKernel::SCALAR, expected.data(), src.data(), key.data(), len, ramp_base,
+                                    ramp_mask, 0x5A);
+                    XorShiftDecrypt(kernel, actual.data(), src.data(), key.data(), len, ramp_base, ramp_mask, 0x5A);
+                    ASSERT_THAT(actual, ContainerEq(expected)) << utils::GetXorKernelName(kernel) << " len " << len;
+
+                    XorShiftEncrypt(utils::XorKernel::SCALAR, expected.data(), src.data(), key.data(), len, ramp_base,
+                                    ramp_mask, 0x5A);
+                    XorShiftEncrypt(kernel, actual.data(), src.data(), key.data(), len, ramp_base, ramp_mask, 0x5A);
+                    ASSERT_THAT(actual, ContainerEq(expected)) << utils::GetXorKernelName(kernel) << " len " << len;
+
+                    // Encryption undoes decryption.
+                    XorShiftDecrypt(kernel, actual.data(), actual.data(), key.data(), len, ramp_base, ramp_mask, 0x5A);
+                    ASSERT_THAT(actual, ContainerEq(std::vector<uint8_t>(src.begin(), src.begin() + len)));
+                }
+            }
+        }
+    }
+}
+
+TEST(KGMKernel, MatchesReferenceAtAnyOffset)
+{
+    transformer::KGMConfig config{};
+    config.slot_keys = {{1, {'0', '9', 'A', 'Z'}}};
+    config.v4.slot_key_table = test::read_fixture("test_kgm_v4_slotkey_table.bin");
+    config.v4.file_key_table = test::read_fixture("test_kgm_v4_filekey_table.bin");
+    const KeyStore key_store{config};
+    const auto *slot_key = key_store.FindSlotKey(1);
+    ASSERT_NE(slot_key, nullptr);
+
+    FileHeader header{};
+    auto header_file_key = test::make_sequence(sizeof(header.file_key), 3);
+    std::copy(header_file_key.begin(), header_file_key.end(), &header.file_key[0]);
+
+    const auto type3_file_key = DeriveType3FileKey(header);
+    const auto type4_slot_key = DeriveType4SlotKey(config, slot_key->key);
+    const auto type4_file_key = DeriveType4FileKey(config, header);
+    const auto src = test::make_sequence(20000, 4);
+
+    for (uint32_t version : {3U, 4U})
+    {
+        header.crypto_version = version;
+        header.key_slot = 1;
+        auto crypto = CreateKGMCrypto(header, key_store);
+        ASSERT_NE(crypto, nullptr);
+
+        // Across 256-byte blocks, 64KiB / 4GiB boundaries, and (type 4) periods of the slot key.
+        for (uint64_t offset : {uint64_t{0}, uint64_t{255}, uint64_t{0xFFFF} - 3000,
+                                uint64_t{type4_slot_key.size()} - 5000, uint64_t{0xFFFFFFFF} - 7000})
+        {
+            std::vector<uint8_t> expected = src;
+            std::vector<uint8_t> actual = src;
+            if (version == 3)
+            {
+                ReferenceEncryptDecrypt<false>(offset, expected.data(), expected.size(), slot_key->type3_key.data(),
+                                               kType3SlotKeySize, type3_file_key.data(), kType3FileKeySize, false);
+            }
+            else
+            {
+                ReferenceEncryptDecrypt<false>(offset, expected.data(), expected.size(), type4_slot_key.data(),
+                                               type4_slot_key.size(), type4_file_key.data(), type4_file_key.size(),
+                                               true);
+            }
+            crypto->Decrypt(offset, actual.data(), actual.size());
+            ASSERT_THAT(actual, ContainerEq(expected)) << "v" << version << " offset " << offset;
+
+            crypto->Encrypt(offset, actual.data(), actual.size());
+            ASSERT_THAT(actual, ContainerEq(src)) << "v" << version << " offset " << offset;
+        }
+    }
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -5,24 +5,81 @@
 #include "parakeet-crypto/transformer/kgm.h"
 #include "utils/endian_helper.h"
 #include "utils/paged_reader.h"
-#include "utils/xor_helper.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 
 #include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 namespace parakeet_crypto::transformer
 {
 
+class KGMRandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    std::unique_ptr<kgm::IKGMCrypto> crypto_{};
+
+  public:
+    KGMRandomAccessDecryptor(std::unique_ptr<kgm::IKGMCrypto> crypto, size_t data_offset, size_t data_size)
+        : RandomAccessDecryptor("KGM", data_offset, data_size), crypto_(std::move(crypto))
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        if (dst != src)
+        {
+            std::copy_n(src, len, dst);
+        }
+        crypto_->Decrypt(offset, dst, len);
+        return true;
+    }
+};
+
 class KGMDecryptionTransformer final : public ITransformer
 {
   private:
-    KGMConfig config_{};
+    std::shared_ptr<const kgm::KeyStore> key_store_{};
+
+    TransformResult CreateDecryptor(std::unique_ptr<KGMRandomAccessDecryptor> &decryptor, IReadSeekable *input)
+    {
+        const size_t header_offset = input->GetOffset();
+
+        kgm::FileHeader header{};
+        {
+            auto header_opt = kgm::FileHeaderFromStream(input);
+            if (!header_opt)
+            {
+                return TransformResult::ERROR_INSUFFICIENT_INPUT;
+            }
+            header = *header_opt;
+        }
+
+        auto crypto = kgm::CreateKGMDecryptionCrypto(header, *key_store_);
+        if (!crypto)
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        const size_t audio_offset = header_offset + header.offset_to_data;
+        const size_t file_size = input->GetSize();
+        if (audio_offset > file_size)
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+
+        decryptor = std::make_unique<KGMRandomAccessDecryptor>(std::move(crypto), audio_offset,
+                                                               file_size - audio_offset);
+        return TransformResult::OK;
+    }
 
   public:
-    KGMDecryptionTransformer(KGMConfig config) : config_(std::move(config))
+    KGMDecryptionTransformer(KGMConfig config) : key_store_(std::make_shared<const kgm::KeyStore>(std::move(config)))
     {
     }
 
@@ -42,32 +99,37 @@ class KGMDecryptionTransformer final : public ITransformer
      */
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        kgm::FileHeader header{};
+        std::unique_ptr<KGMRandomAccessDecryptor> decryptor{};
+        if (auto result = CreateDecryptor(decryptor, input); result != TransformResult::OK)
         {
-            auto header_opt = kgm::FileHeaderFromStream(input);
-            if (!header_opt)
-            {
-                return TransformResult::ERROR_INSUFFICIENT_INPUT;
-            }
-            header = *header_opt;
-        }
-
-        auto decryptor = kgm::CreateKGMDecryptionCrypto(header, config_);
-        if (!decryptor)
-        {
-            return TransformResult::ERROR_INVALID_FORMAT;
+            return result;
         }
 
-        const auto audio_offset = header.offset_to_data;
+        const auto audio_offset = decryptor->GetDataOffset();
         input->Seek(audio_offset, SeekDirection::SEEK_FILE_BEGIN);
 
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t offset, uint8_t *buffer, size_t n) {
-            decryptor->Decrypt(offset - audio_offset, buffer, n);
-            return output->Write(buffer, n);
-        });
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor->DecryptAt(offset - audio_offset, dst, src, n) && output->Write(dst, n);
+            });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_OTHER;
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::unique_ptr<KGMRandomAccessDecryptor> result{};
+        auto state = CreateDecryptor(result, input);
+        decryptor = std::move(result);
+        return state;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateKGMDecryptionTransformer(KGMConfig config)
@@ -43,4 +43,17 @@ TEST(Kuwo, DecryptSampleFile)
     test::should_decrypt_to_fixture("test_kuwo.kwm", transformer);
 }
 
+TEST(Kuwo, RandomAccess)
+{
+    auto transformer = transformer::CreateKuwoDecryptionTransformer(kwm_test_key.data());
+    test::should_random_access_decrypt_to_fixture("test_kuwo.kwm", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_kuwo.kwm", transformer);
+}
+
+TEST(Kuwo, StreamingDecryption)
+{
+    auto transformer = transformer::CreateKuwoDecryptionTransformer(kwm_test_key.data());
+    test::should_stream_decrypt_to_fixture("test_kuwo.kwm", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -10,6 +10,8 @@
 #include "utils/endian_helper.h"
 #include "utils/loop_iterator.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 #include "utils/xor_helper.h"
 
 #include <cinttypes>
@@ -24,12 +26,74 @@
 namespace parakeet_crypto::transformer
 {
 
+class KuwoV1RandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    utils::PeriodicXorKey key_;
+
+  public:
+    KuwoV1RandomAccessDecryptor(const std::array<uint8_t, kKuwoDecryptionKeySize> &key, size_t data_offset,
+                                size_t data_size)
+        : RandomAccessDecryptor("Kuwo (D)", data_offset, data_size), key_(key)
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        // The key is applied from the beginning of the file, including the header.
+        key_.Apply(dst, src, len, kFullKuwoHeaderLen + offset);
+        return true;
+    }
+};
+
 class KuwoDecryptionTransformer final : public ITransformer
 {
   private:
     std::array<uint8_t, kKuwoDecryptionKeySize> key_{};
     std::vector<uint8_t> v2_key_{};
 
+    std::unique_ptr<KuwoV1RandomAccessDecryptor> CreateV1Decryptor(uint32_t resource_id, size_t data_offset,
+                                                                   IReadSeekable *input)
+    {
+        std::array<uint8_t, kKuwoDecryptionKeySize> key{};
+        SetupKuwoDecryptionKey(key, key_, resource_id);
+        return std::make_unique<KuwoV1RandomAccessDecryptor>(key, data_offset, input->GetSize() - data_offset);
+    }
+
+    std::unique_ptr<ITransformer> CreateV2Transformer()
+    {
+        return qmc2::GetEncryptionType(v2_key_) == qmc2::QMC2EncryptionType::RC4
+                   ? CreateQMC2RC4DecryptionTransformer(v2_key_)
+                   : CreateQMC2MapDecryptionTransformer(v2_key_);
+    }
+
+    /**
+     * @brief Read and validate the file header.
+     *
+     * @param data_offset Where the payload starts, i.e. past the full header.
+     */
+    static TransformResult ReadHeader(KuwoHeaderUnion &file_header, size_t &data_offset, IReadSeekable *input)
+    {
+        data_offset = input->GetOffset() + kFullKuwoHeaderLen;
+        if (input->GetSize() < data_offset)
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        if (!input->ReadExact(&file_header.as_bytes[0], sizeof(file_header)))
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        if (!std::equal(kKnownKuwoHeader1.begin(), kKnownKuwoHeader1.end(), &file_header.as_header.header[0]) &&
+            !std::equal(kKnownKuwoHeader2.begin(), kKnownKuwoHeader2.end(), &file_header.as_header.header[0]))
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        return TransformResult::OK;
+    }
+
   public:
     KuwoDecryptionTransformer(const uint8_t *key) : KuwoDecryptionTransformer(key, std::vector<uint8_t>())
     {
@@ -45,61 +109,92 @@ class KuwoDecryptionTransformer final : public ITransformer
         return "Kuwo (D)";
     }
 
-    TransformResult TransformV1(uint32_t resource_id, IWriteable *output, IReadSeekable *input)
+    TransformResult TransformV1(uint32_t resource_id, size_t data_offset, IWriteable *output, IReadSeekable *input)
     {
-        std::array<uint8_t, kKuwoDecryptionKeySize> key{};
-        SetupKuwoDecryptionKey(key, key_, resource_id);
-
-        input->Seek(kFullKuwoHeaderLen, SeekDirection::SEEK_FILE_BEGIN);
+        auto decryptor = CreateV1Decryptor(resource_id, data_offset, input);
 
-        utils::LoopIterator key_iter{key.data(), key.size(), input->GetOffset()};
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            std::for_each_n(buffer, n, [&](auto &value) { value ^= key_iter.GetAndMove(); });
-            return output->Write(buffer, n);
-        });
+        input->Seek(data_offset, SeekDirection::SEEK_FILE_BEGIN);
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor->DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
+            });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_OTHER;
     }
 
-    TransformResult TransformV2(IWriteable *output, IReadSeekable *input)
+    TransformResult TransformV2(size_t data_offset, IWriteable *output, IReadSeekable *input)
     {
-        auto next_transformer = qmc2::GetEncryptionType(v2_key_) == qmc2::QMC2EncryptionType::RC4
-                                    ? CreateQMC2RC4DecryptionTransformer(v2_key_)
-                                    : CreateQMC2MapDecryptionTransformer(v2_key_);
+        auto next_transformer = CreateV2Transformer();
 
-        input->Seek(kFullKuwoHeaderLen, SeekDirection::SEEK_FILE_BEGIN);
-        SlicedReadableStream reader{*input, kFullKuwoHeaderLen, input->GetSize()};
+        input->Seek(data_offset, SeekDirection::SEEK_FILE_BEGIN);
+        SlicedReadableStream reader{*input, data_offset, input->GetSize()};
         return next_transformer->Transform(output, &reader);
     }
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
         KuwoHeaderUnion file_header{};
-        if (!input->ReadExact(&file_header.as_bytes[0], sizeof(file_header)))
-        {
-            return TransformResult::ERROR_INVALID_FORMAT;
-        }
-
-        if (!std::equal(kKnownKuwoHeader1.begin(), kKnownKuwoHeader1.end(), &file_header.as_header.header[0]) &&
-            !std::equal(kKnownKuwoHeader2.begin(), kKnownKuwoHeader2.end(), &file_header.as_header.header[0]))
+        size_t data_offset{};
+        if (auto result = ReadHeader(file_header, data_offset, input); result != TransformResult::OK)
         {
-            return TransformResult::ERROR_INVALID_FORMAT;
+            return result;
         }
 
         switch (file_header.as_header.encryption_version)
         {
         case 1: {
             auto resource_id = SwapLittleEndianToHost(file_header.as_header.resource_id);
-            return this->TransformV1(resource_id, output, input);
+            return this->TransformV1(resource_id, data_offset, output, input);
         }
 
         case 2:
-            return this->TransformV2(output, input);
+            return this->TransformV2(data_offset, output, input);
 
         default:
             return TransformResult::ERROR_NOT_IMPLEMENTED;
         }
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        KuwoHeaderUnion file_header{};
+        size_t data_offset{};
+        if (auto result = ReadHeader(file_header, data_offset, input); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        switch (file_header.as_header.encryption_version)
+        {
+        case 1:
+            decryptor =
+                CreateV1Decryptor(SwapLittleEndianToHost(file_header.as_header.resource_id), data_offset, input);
+            return TransformResult::OK;
+
+        case 2: {
+            std::unique_ptr<IRandomAccessDecryptor> qmc2_decryptor{};
+            input->Seek(data_offset, SeekDirection::SEEK_FILE_BEGIN);
+            SlicedReadableStream reader{*input, data_offset, input->GetSize()};
+            if (auto result = CreateV2Transformer()->CreateRandomAccessDecryptor(qmc2_decryptor, &reader);
+                result != TransformResult::OK)
+            {
+                return result;
+            }
+            decryptor = std::make_unique<utils::OffsetRandomAccessDecryptor>(std::move(qmc2_decryptor), data_offset);
+            return TransformResult::OK;
+        }
+
+        default:
+            return TransformResult::ERROR_NOT_IMPLEMENTED;
+        }
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateKuwoDecryptionTransformer(const uint8_t *key)
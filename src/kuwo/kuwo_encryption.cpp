@@ -24,13 +24,20 @@ class KuwoEncryptionTransformer final : public ITransformer
 {
   private:
     uint32_t resource_id_{};
-    std::array<uint8_t, kKuwoDecryptionKeySize> key_{};
+    utils::PeriodicXorKey key_;
+
+    static std::array<uint8_t, kKuwoDecryptionKeySize> SetupKey(const uint8_t *key, uint32_t resource_id)
+    {
+        std::array<uint8_t, kKuwoDecryptionKeySize> result{};
+        std::copy_n(key, kKuwoDecryptionKeySize, result.begin());
+        SetupKuwoDecryptionKey(result, result, resource_id);
+        return result;
+    }
 
   public:
-    KuwoEncryptionTransformer(const uint8_t *key, uint32_t resource_id) : ITransformer(), resource_id_(resource_id)
+    KuwoEncryptionTransformer(const uint8_t *key, uint32_t resource_id)
+        : ITransformer(), resource_id_(resource_id), key_(SetupKey(key, resource_id))
     {
-        std::copy_n(key, kKuwoDecryptionKeySize, key_.begin());
-        SetupKuwoDecryptionKey(key_, key_, resource_id);
     }
 
     const char *GetName() override
@@ -51,11 +58,11 @@ class KuwoEncryptionTransformer final : public ITransformer
             return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
         }
 
-        utils::LoopIterator key_iter{key_.data(), key_.size(), input->GetOffset()};
-        auto encrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            std::for_each_n(buffer, n, [&](auto &value) { value ^= key_iter.GetAndMove(); });
-            return output->Write(buffer, n);
-        });
+        auto encrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                key_.Apply(dst, src, n, offset);
+                return output->Write(dst, n);
+            });
 
         return encrypt_ok ? TransformResult::OK : TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
     }
@@ -3,14 +3,17 @@
 #include "migu3d/migu_decrypt.hpp"
 #include "parakeet-crypto/IStream.h"
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/KeyDerivationCache.h"
 #include "parakeet-crypto/utils/hex.h"
 #include "utils/logger.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
 
 #include <algorithm>
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "parakeet-crypto/utils/hash/md5.h"
@@ -18,6 +21,26 @@
 namespace parakeet_crypto::transformer
 {
 
+class Migu3DRandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    std::array<uint8_t, migu3d::kMiguFinalKeySize> key_{};
+
+  public:
+    Migu3DRandomAccessDecryptor(const std::array<uint8_t, migu3d::kMiguFinalKeySize> &key, size_t data_offset,
+                                size_t data_size)
+        : RandomAccessDecryptor("Migu3D", data_offset, data_size), key_(key)
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        migu3d::DecryptSegment(dst, src, len, offset, key_.data());
+        return true;
+    }
+};
+
 class Migu3DTransformer final : public ITransformer
 {
   private:
@@ -29,17 +52,21 @@ class Migu3DTransformer final : public ITransformer
 
   public:
     Migu3DTransformer() = default;
-    Migu3DTransformer(const uint8_t *salt, const uint8_t *file_key)
+    Migu3DTransformer(const uint8_t *salt, const uint8_t *file_key, KeyDerivationCache *key_cache)
     {
-        std::array<uint8_t, utils::hash::kMD5DigestSize> digest{};
-        utils::hash::md5_ctx md5_ctx{};
-        utils::hash::md5_init(&md5_ctx);
-        utils::hash::md5_update(&md5_ctx, salt, kSaltSize);
-        utils::hash::md5_update(&md5_ctx, file_key, kFileKeySize);
-        utils::hash::md5_final(&md5_ctx, digest.data());
-
-        auto key = utils::Hex(digest.data(), digest.size());
-        std::copy(key.cbegin(), key.cend(), key_.begin());
+        auto input = MakeKeyDerivationInput({{salt, kSaltSize}, {file_key, kFileKeySize}});
+        auto key = DeriveKey(key_cache, KeyDerivationKind::MIGU3D_FILE_KEY, input, [&]() {
+            std::array<uint8_t, utils::hash::kMD5DigestSize> digest{};
+            utils::hash::md5_ctx md5_ctx{};
+            utils::hash::md5_init(&md5_ctx);
+            utils::hash::md5_update(&md5_ctx, salt, kSaltSize);
+            utils::hash::md5_update(&md5_ctx, file_key, kFileKeySize);
+            utils::hash::md5_final(&md5_ctx, digest.data());
+
+            auto hex = utils::Hex(digest.data(), digest.size());
+            return std::vector<uint8_t>(hex.cbegin(), hex.cend());
+        });
+        std::copy_n(key.cbegin(), key_.size(), key_.begin());
 
         if (logger::DEBUG_Enabled)
         {
@@ -53,8 +80,9 @@ class Migu3DTransformer final : public ITransformer
         return "Migu3D";
     }
 
-    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    TransformResult CreateDecryptor(std::unique_ptr<Migu3DRandomAccessDecryptor> &decryptor, IReadSeekable *input)
     {
+        const auto data_offset = input->GetOffset();
         std::array<uint8_t, kFinalKeySize> key = key_;
         if (auto keyless = key[0] == 0; keyless)
         {
@@ -75,25 +103,49 @@ class Migu3DTransformer final : public ITransformer
                 std::string key_str(key.begin(), key.end());
                 logger::DEBUG() << "Migu3D key recovered by freq analysis: " << key_str;
             }
-            migu3d::DecryptSegment(segment.data(), segment.size(), 0, key.data());
-            if (!output->Write(segment.data(), segment.size()))
-            {
-                return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
-            }
         }
 
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t offset, uint8_t *buffer, size_t n) {
-            migu3d::DecryptSegment(buffer, n, offset, key.data());
-            return output->Write(buffer, n);
-        });
+        decryptor = std::make_unique<Migu3DRandomAccessDecryptor>(key, data_offset, input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+
+    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    {
+        std::unique_ptr<Migu3DRandomAccessDecryptor> decryptor{};
+        if (auto result = CreateDecryptor(decryptor, input); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        const auto data_offset = decryptor->GetDataOffset();
+        input->Seek(data_offset, SeekDirection::SEEK_FILE_BEGIN);
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor->DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
+            });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_INSUFFICIENT_OUTPUT;
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::unique_ptr<Migu3DRandomAccessDecryptor> result{};
+        auto state = CreateDecryptor(result, input);
+        decryptor = std::move(result);
+        return state;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateMiguTransformer(const uint8_t *salt, const uint8_t *file_key)
 {
-    return std::make_unique<Migu3DTransformer>(salt, file_key);
+    return std::make_unique<Migu3DTransformer>(salt, file_key, nullptr);
+}
+
+std::unique_ptr<ITransformer> CreateMiguTransformer(const uint8_t *salt, const uint8_t *file_key,
+                                                    std::shared_ptr<KeyDerivationCache> key_cache)
+{
+    return std::make_unique<Migu3DTransformer>(salt, file_key, key_cache.get());
 }
 
 /**
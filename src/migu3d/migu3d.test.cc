@@ -31,4 +31,11 @@ TEST(Migu3D, KeylessDecryptionTest)
     test::should_decrypt_to_fixture("test.mg3d", transformer);
 }
 
+TEST(Migu3D, RandomAccess)
+{
+    auto transformer = transformer::CreateKeylessMiguTransformer();
+    test::should_random_access_decrypt_to_fixture("test.mg3d", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test.mg3d", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -12,16 +12,21 @@
 namespace parakeet_crypto::migu3d
 {
 
-inline void DecryptSegment(uint8_t *buffer, size_t len, size_t offset, const uint8_t *key)
+inline void DecryptSegment(uint8_t *dst, const uint8_t *src, size_t len, size_t offset, const uint8_t *key)
 {
-    for (; len > 0; buffer++, len--)
+    for (; len > 0; dst++, src++, len--)
     {
         offset %= kMiguFinalKeySize;
 
-        *buffer -= key[offset];
+        *dst = *src - key[offset];
 
         offset++;
     }
 }
 
+inline void DecryptSegment(uint8_t *buffer, size_t len, size_t offset, const uint8_t *key)
+{
+    DecryptSegment(buffer, buffer, len, offset, key);
+}
+
 } // namespace parakeet_crypto::migu3d
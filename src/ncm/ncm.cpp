@@ -5,14 +5,16 @@
 #include "parakeet-crypto/transformer/ncm.h"
 #include "sized_block_reader.h"
 #include "utils/endian_helper.h"
-#include "utils/loop_iterator.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 #include "utils/xor_helper.h"
 
 #include <algorithm>
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::transformer
@@ -31,13 +33,32 @@ namespace parakeet_crypto::transformer
  *   - Audio Data (Encrypted with Content Key);
  */
 
+class NCMRandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    utils::PeriodicXorKey key_;
+
+  public:
+    NCMRandomAccessDecryptor(const std::array<uint8_t, kNCMFinalKeyLen> &key, size_t data_offset, size_t data_size)
+        : RandomAccessDecryptor("NCM", data_offset, data_size), key_(key)
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        key_.Apply(dst, src, len, offset);
+        return true;
+    }
+};
+
 class NCMTransformer final : public ITransformer
 {
   private:
     static constexpr size_t kHeaderPadding{2};
     static constexpr size_t kCoverPadding{9};
 
-    std::array<uint8_t, kNCMContentKeySize> content_key_{};
+    std::shared_ptr<const cipher::aes::AES128Dec> content_key_cipher_{};
 
     [[nodiscard]] std::optional<std::array<uint8_t, kNCMFinalKeyLen>> ReadContentKey(IReadSeekable *input)
     {
@@ -52,7 +73,7 @@ class NCMTransformer final : public ITransformer
         {
             return {};
         }
-        return DecryptNCMAudioKey(key_buffer, content_key_);
+        return DecryptNCMAudioKey(key_buffer, *content_key_cipher_);
     }
 
     [[nodiscard]] static bool SeekSizedBox(IReadSeekable *input)
@@ -66,18 +87,11 @@ class NCMTransformer final : public ITransformer
         return true;
     }
 
-  public:
-    NCMTransformer(const uint8_t *content_key) : ITransformer()
-    {
-        std::copy_n(content_key, content_key_.size(), content_key_.begin());
-    }
-
-    const char *GetName() override
-    {
-        return "NCM";
-    }
-
-    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    /**
+     * @brief Parse the file header, and create the decryptor for the audio data.
+     *        Leaves the input at the beginning of the audio data.
+     */
+    TransformResult CreateDecryptor(std::unique_ptr<NCMRandomAccessDecryptor> &decryptor, IReadSeekable *input)
     {
         constexpr static std::array<const uint8_t, 8> kHeader{'C', 'T', 'E', 'N', 'F', 'D', 'A', 'M'};
 
@@ -99,7 +113,6 @@ class NCMTransformer final : public ITransformer
         {
             return TransformResult::ERROR_INVALID_KEY;
         }
-        auto audio_content_key = *tmp_key;
 
         // skip metadata
         if (!SeekSizedBox(input))
@@ -113,14 +126,59 @@ class NCMTransformer final : public ITransformer
             return TransformResult::ERROR_INVALID_FORMAT;
         }
 
-        utils::LoopIterator key_iter{audio_content_key.data(), audio_content_key.size(), 0};
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            std::for_each_n(buffer, n, [&](auto &value) { value ^= key_iter.GetAndMove(); });
-            return output->Write(buffer, n);
-        });
+        const auto audio_offset = input->GetOffset();
+        const auto file_size = input->GetSize();
+        if (audio_offset > file_size)
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+
+        decryptor = std::make_unique<NCMRandomAccessDecryptor>(*tmp_key, audio_offset, file_size - audio_offset);
+        return TransformResult::OK;
+    }
+
+  public:
+    NCMTransformer(const uint8_t *content_key)
+        : ITransformer(), content_key_cipher_(std::make_shared<const cipher::aes::AES128Dec>(content_key))
+    {
+    }
+
+    const char *GetName() override
+    {
+        return "NCM";
+    }
+
+    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    {
+        std::unique_ptr<NCMRandomAccessDecryptor> decryptor{};
+        if (auto result = CreateDecryptor(decryptor, input); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        const auto audio_offset = decryptor->GetDataOffset();
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor->DecryptAt(offset - audio_offset, dst, src, n) && output->Write(dst, n);
+            });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_OTHER;
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::unique_ptr<NCMRandomAccessDecryptor> result{};
+        auto state = CreateDecryptor(result, input);
+        decryptor = std::move(result);
+        return state;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateNeteaseNCMDecryptionTransformer(const uint8_t *content_key)
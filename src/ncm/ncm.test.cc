@@ -30,4 +30,78 @@ TEST(NCM, TestDecryption)
     test::should_decrypt_to_fixture("test.ncm", transformer);
 }
 
+TEST(NCM, RandomAccess)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    test::should_random_access_decrypt_to_fixture("test.ncm", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test.ncm", transformer);
+}
+
+TEST(NCM, RandomAccessTruncatedHeader)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto fixture = test::read_fixture("test.ncm");
+    fixture.resize(4);
+    InputMemoryStream input{fixture};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateRandomAccessDecryptor(decryptor, &input), TransformResult::ERROR_INSUFFICIENT_INPUT);
+    ASSERT_EQ(decryptor, nullptr);
+}
+
+TEST(NCM, StreamingDecryption)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    test::should_stream_decrypt_to_fixture("test.ncm", transformer);
+}
+
+TEST(NCM, StreamingDecryptionTruncatedHeader)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    auto fixture = test::read_fixture("test.ncm");
+
+    std::unique_ptr<IStreamingDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateStreamingDecryptor(decryptor), TransformResult::OK);
+    OutputMemoryStream output{};
+    ASSERT_EQ(decryptor->Update(fixture.data(), 100, &output), TransformResult::OK);
+    ASSERT_NE(decryptor->Final(&output), TransformResult::OK);
+    ASSERT_TRUE(output.GetData().empty());
+}
+
+TEST(NCM, StreamingDecryptionInvalidHeader)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    std::array<uint8_t, 16> not_ncm{'N', 'O', 'T', ' ', 'N', 'C', 'M'};
+
+    std::unique_ptr<IStreamingDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateStreamingDecryptor(decryptor), TransformResult::OK);
+    OutputMemoryStream output{};
+    ASSERT_EQ(decryptor->Update(not_ncm.data(), not_ncm.size(), &output), TransformResult::ERROR_INVALID_FORMAT);
+    ASSERT_EQ(decryptor->Final(&output), TransformResult::ERROR_INVALID_FORMAT);
+}
+
+TEST(NCM, ReusedAcrossThreads)
+{
+    static constexpr std::array<const uint8_t, 16> ncm_key = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                              0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(ncm_key.data());
+    test::should_decrypt_concurrently_to_fixture("test.ncm", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -15,14 +15,13 @@ namespace parakeet_crypto::transformer
 
 static constexpr size_t kNCMFinalKeyLen = 0x100;
 inline std::optional<std::array<uint8_t, kNCMFinalKeyLen>> DecryptNCMAudioKey(
-    std::vector<uint8_t> &file_key, const std::array<uint8_t, kNCMContentKeySize> &aes_key)
+    std::vector<uint8_t> &file_key, const cipher::aes::AES128Dec &aes_decrypt)
 {
     constexpr uint8_t kFileKeyXorKey{0x64};
 
     std::vector<uint8_t> content_key(file_key.size());
     std::transform(file_key.cbegin(), file_key.cend(), content_key.begin(),
                    [&](auto key) { return key ^ kFileKeyXorKey; });
-    auto aes_decrypt = cipher::aes::AES128Dec(aes_key.data());
     if (aes_decrypt.TransformBlocks(content_key) != cipher::CipherError::kSuccess)
     {
         return {}; // invalid data size
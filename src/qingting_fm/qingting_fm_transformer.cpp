@@ -1,3 +1,4 @@
+#include "parakeet-crypto/KeyDerivationCache.h"
 #include "parakeet-crypto/cipher/cipher_error.h"
 #include "parakeet-crypto/transformer/qingting_fm.h"
 #include "qingting_fm.h"
@@ -6,37 +7,98 @@
 #include "parakeet-crypto/cipher/block_mode/ctr.h"
 
 #include "utils/paged_reader.h"
+#include "utils/parallel.h"
+#include "utils/parallel_decrypt.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 
 #include <memory>
-#include <optional>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace parakeet_crypto::transformer
 {
 
 using namespace parakeet_crypto::qtfm;
-using AES128CTR = cipher::block_mode::CTR_Stream<cipher::aes::AES128Enc>;
+using AES128CTR = cipher::block_mode::CTR_Stream<const cipher::aes::AES128Enc>;
+constexpr size_t kAESBlockSize = cipher::aes::AES128Enc::block_size_;
 
 namespace qtfm_impl_details
 {
 
+class QingTingFMRandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    std::shared_ptr<const cipher::aes::AES128Enc> cipher_;
+    CryptoNonce nonce_{};
+
+  public:
+    QingTingFMRandomAccessDecryptor(std::shared_ptr<const cipher::aes::AES128Enc> cipher, const CryptoNonce &nonce,
+                                    size_t data_offset, size_t data_size)
+        : RandomAccessDecryptor("QingTingFM (qingting.fm)", data_offset, data_size), cipher_(std::move(cipher)),
+          nonce_(nonce)
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        // The counter block is "nonce || offset / block_size": seek from the first counter of the file.
+        CryptoIV iv{}; // NOLINT(*-identifier-length)
+        std::copy(nonce_.cbegin(), nonce_.cend(), iv.begin());
+
+        AES128CTR ctr{cipher_, iv};
+        if (auto err = ctr.SeekTo(offset); err != cipher::CipherError::kSuccess)
+        {
+            return false;
+        }
+
+        size_t buffer_size = len;
+        return ctr.Update(dst, buffer_size, src, len) == cipher::CipherError::kSuccess;
+    }
+};
+
+inline std::vector<uint8_t> DeriveDeviceSecretKey(KeyDerivationCache *key_cache, std::string_view product,
+                                                  std::string_view device, std::string_view manufacturer,
+                                                  std::string_view brand, std::string_view board,
+                                                  std::string_view model)
+{
+    auto input = MakeKeyDerivationInput({
+        {product.data(), product.size()},
+        {device.data(), device.size()},
+        {manufacturer.data(), manufacturer.size()},
+        {brand.data(), brand.size()},
+        {board.data(), board.size()},
+        {model.data(), model.size()},
+    });
+    return DeriveKey(key_cache, KeyDerivationKind::QINGTING_FM_DEVICE, input, [&]() {
+        auto key = CreateDeviceSecretKey(product, device, manufacturer, brand, board, model);
+        return std::vector<uint8_t>(key.cbegin(), key.cend());
+    });
+}
+
+/**
+ * @brief The transformer only holds the expanded key and the nonce, both immutable: every `Transform` call starts
+ *        its own counter at the beginning of the file, so one transformer can serve several files or threads.
+ */
 class QingTingFMTransformer final : public ITransformer
 {
   public:
     QingTingFMTransformer(const char *filename, const char *product, const char *device, const char *manufacturer,
-                          const char *brand, const char *board, const char *model)
+                          const char *brand, const char *board, const char *model, KeyDerivationCache *key_cache,
+                          size_t thread_count)
+        : QingTingFMTransformer(filename,
+                                DeriveDeviceSecretKey(key_cache, product, device, manufacturer, brand, board, model)
+                                    .data(),
+                                thread_count)
     {
-        // NOLINTNEXTLINE(*-identifier-length)
-        auto iv = CreateCryptoIV(filename, 0);
-        auto secret_key = CreateDeviceSecretKey(product, device, manufacturer, brand, board, model);
-        ctr_ = AES128CTR(std::make_shared<cipher::aes::AES128Enc>(secret_key), iv);
-    };
-    QingTingFMTransformer(const char *filename, const uint8_t *secret_key)
+    }
+    QingTingFMTransformer(const char *filename, const uint8_t *secret_key, size_t thread_count)
+        : cipher_(std::make_shared<const cipher::aes::AES128Enc>(secret_key)), nonce_(CreateCryptoNonce(filename)),
+          thread_count_(thread_count)
     {
-        // NOLINTNEXTLINE(*-identifier-length)
-        auto iv = CreateCryptoIV(filename, 0);
-        ctr_ = AES128CTR(std::make_shared<cipher::aes::AES128Enc>(secret_key), iv);
-    };
+    }
 
     const char *GetName() override
     {
@@ -45,20 +107,61 @@ class QingTingFMTransformer final : public ITransformer
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        auto success = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            size_t buffer_size = n;
-            if (auto err = ctr_->Update(buffer, buffer_size, buffer, n); err != cipher::CipherError::kSuccess)
-            {
-                return false;
-            }
-
-            return output->Write(buffer, n);
-        });
+        const auto data_offset = input->GetOffset();
+        QingTingFMRandomAccessDecryptor decryptor{cipher_, nonce_, data_offset, input->GetSize() - data_offset};
+        if (thread_count_ > 1 && decryptor.GetDataSize() > utils::kParallelDecryptBatchSize)
+        {
+            // Each batch seeks its own CTR instance to its offset.
+            return utils::ParallelDecrypt(decryptor, output, input, data_offset, thread_count_)
+                       ? TransformResult::OK
+                       : TransformResult::ERROR_OTHER;
+        }
+
+        auto success = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor.DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
+            });
         return success ? TransformResult::OK : TransformResult::ERROR_OTHER;
     }
 
+    TransformResult Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len) override
+    {
+        if (thread_count_ <= 1 || input_len <= utils::kParallelDecryptBatchSize)
+        {
+            return ITransformer::Transform(output, output_len, input, input_len);
+        }
+
+        if (output == nullptr || output_len < input_len)
+        {
+            output_len = input_len;
+            return TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+        }
+
+        QingTingFMRandomAccessDecryptor decryptor{cipher_, nonce_, 0, input_len};
+        output_len = input_len;
+        return utils::ParallelDecrypt(decryptor, output, input, thread_count_) ? TransformResult::OK
+                                                                               : TransformResult::ERROR_OTHER;
+    }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        const auto data_offset = input->GetOffset();
+        decryptor = std::make_unique<QingTingFMRandomAccessDecryptor>(cipher_, nonce_, data_offset,
+                                                                      input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
+
   private:
-    std::optional<AES128CTR> ctr_;
+    std::shared_ptr<const cipher::aes::AES128Enc> cipher_;
+    CryptoNonce nonce_{};
+    size_t thread_count_{1};
 };
 }; // namespace qtfm_impl_details
 
@@ -67,13 +170,37 @@ std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
     const char *board, const char *model)
 {
     return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(filename, product, device, manufacturer, brand,
-                                                                      board, model);
+                                                                      board, model, nullptr, 1);
+}
+
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
+    const char *filename, const char *product, const char *device, const char *manufacturer, const char *brand,
+    const char *board, const char *model, std::shared_ptr<KeyDerivationCache> key_cache)
+{
+    return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(filename, product, device, manufacturer, brand,
+                                                                      board, model, key_cache.get(), 1);
+}
+
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer( //
+    const char *filename, const char *product, const char *device, const char *manufacturer, const char *brand,
+    const char *board, const char *model, std::shared_ptr<KeyDerivationCache> key_cache, size_t thread_count)
+{
+    return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(
+        filename, product, device, manufacturer, brand, board, model, key_cache.get(),
+        thread_count != 0 ? thread_count : utils::GetDefaultThreadCount());
 }
 
 std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer(const char *filename,
                                                                  const uint8_t *device_fingerprint)
 {
-    return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(filename, device_fingerprint);
+    return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(filename, device_fingerprint, 1);
+}
+
+std::unique_ptr<ITransformer> CreateAndroidQingTingFMTransformer(const char *filename,
+                                                                 const uint8_t *device_fingerprint, size_t thread_count)
+{
+    return std::make_unique<qtfm_impl_details::QingTingFMTransformer>(
+        filename, device_fingerprint, thread_count != 0 ? thread_count : utils::GetDefaultThreadCount());
 }
 
 } // namespace parakeet_crypto::transformer
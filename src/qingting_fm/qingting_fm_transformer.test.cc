@@ -24,4 +24,35 @@ TEST(QingTingFM, TestSampleFile)
     test::should_decrypt_to_fixture("test_qtfm_MTIzNDU2QEBA.qta", transformer);
 }
 
+TEST(QingTingFM, RandomAccess)
+{
+    auto transformer = transformer::CreateAndroidQingTingFMTransformer(
+        ".p~!MTIzNDU2QEBA.qta", "DEV_PRODUCT", "DEV_DEVICE", "DEV_MANUFACTURER", "DEV_BRAND", "DEV_BOARD", "DEV_MODEL");
+    test::should_random_access_decrypt_to_fixture("test_qtfm_MTIzNDU2QEBA.qta", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_qtfm_MTIzNDU2QEBA.qta", transformer);
+}
+
+TEST(QingTingFM, StreamingDecryption)
+{
+    auto transformer = transformer::CreateAndroidQingTingFMTransformer(
+        ".p~!MTIzNDU2QEBA.qta", "DEV_PRODUCT", "DEV_DEVICE", "DEV_MANUFACTURER", "DEV_BRAND", "DEV_BOARD", "DEV_MODEL");
+    test::should_stream_decrypt_to_fixture("test_qtfm_MTIzNDU2QEBA.qta", transformer);
+}
+
+TEST(QingTingFM, ReusedAcrossThreads)
+{
+    auto transformer = transformer::CreateAndroidQingTingFMTransformer(
+        ".p~!MTIzNDU2QEBA.qta", "DEV_PRODUCT", "DEV_DEVICE", "DEV_MANUFACTURER", "DEV_BRAND", "DEV_BOARD", "DEV_MODEL");
+    test::should_decrypt_concurrently_to_fixture("test_qtfm_MTIzNDU2QEBA.qta", transformer);
+}
+
+TEST(QingTingFM, MultiThreadedDecryption)
+{
+    const std::vector<uint8_t> fingerprint{0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+                                           0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10};
+    auto single_thread = transformer::CreateAndroidQingTingFMTransformer(".p~!MTIzNDU2QEBA.qta", fingerprint.data());
+    auto multi_thread = transformer::CreateAndroidQingTingFMTransformer(".p~!MTIzNDU2QEBA.qta", fingerprint.data(), 4);
+    test::should_decrypt_in_parallel_like(single_thread, multi_thread);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -1,29 +1,104 @@
+#pragma once
 
 #include "parakeet-crypto/ITransformer.h"
-#include "utils/loop_iterator.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 #include "utils/xor_helper.h"
 
 #include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <utility>
 
 namespace parakeet_crypto::transformer
 {
 
-class QMC1StaticDecryptionTransformer final : public ITransformer
+/**
+ * @brief The QMCv1 keystream of a whole page, computed once per key.
+ *
+ * The key restarts every 0x7fff bytes, except for the first page, which has an extra byte
+ *   (off-by-one in the original implementation): [0, 0x8000), [0x8000, 0xffff), ...
+ * Every other page is a prefix of the first one, so a single 0x8000 bytes keystream serves all pages.
+ */
+class QMC1PageKeystream
 {
-  private:
+  public:
     static constexpr size_t kQMC1KeySize = 128;
     static constexpr size_t kCipherPageSize = 0x7fff;
+    static constexpr size_t kFirstPageSize = kCipherPageSize + 1;
 
-    std::array<uint8_t, kQMC1KeySize> key_{};
+  private:
+    std::array<uint8_t, kFirstPageSize> keystream_{};
+
+  public:
+    QMC1PageKeystream(const uint8_t *key)
+    {
+        for (size_t i = 0; i < kFirstPageSize; i += kQMC1KeySize)
+        {
+            std::copy_n(key, kQMC1KeySize, &keystream_[i]);
+        }
+    }
+
+    void Apply(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const
+    {
+        while (len > 0)
+        {
+            size_t page_offset{};
+            size_t page_bytes_left{};
+            if (offset < kFirstPageSize)
+            {
+                page_offset = offset;
+                page_bytes_left = kFirstPageSize - offset;
+            }
+            else
+            {
+                page_offset = offset % kCipherPageSize;
+                page_bytes_left = kCipherPageSize - page_offset;
+            }
+
+            auto process_len = std::min(len, page_bytes_left);
+            utils::XorBytes(dst, src, &keystream_[page_offset], process_len);
+
+            dst += process_len;
+            src += process_len;
+            offset += process_len;
+            len -= process_len;
+        }
+    }
+};
+
+class QMC1StaticRandomAccessDecryptor final : public utils::RandomAccessDecryptor
+{
+  private:
+    std::shared_ptr<const QMC1PageKeystream> keystream_;
 
   public:
-    QMC1StaticDecryptionTransformer(const uint8_t *key) : ITransformer()
+    QMC1StaticRandomAccessDecryptor(std::shared_ptr<const QMC1PageKeystream> keystream, size_t data_offset,
+                                    size_t data_size)
+        : RandomAccessDecryptor("QMCv1", data_offset, data_size), keystream_(std::move(keystream))
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        keystream_->Apply(offset, dst, src, len);
+        return true;
+    }
+};
+
+class QMC1StaticDecryptionTransformer final : public ITransformer
+{
+  private:
+    std::shared_ptr<const QMC1PageKeystream> keystream_;
+
+  public:
+    QMC1StaticDecryptionTransformer(const uint8_t *key)
+        : ITransformer(), keystream_(std::make_shared<const QMC1PageKeystream>(key))
     {
-        std::copy_n(key, key_.size(), key_.begin());
     }
 
     const char *GetName() override
@@ -33,30 +108,29 @@ class QMC1StaticDecryptionTransformer final : public ITransformer
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        utils::LoopIterator key_iter{key_.data(), key_.size(), 0};
-        utils::LoopCounter counter{kCipherPageSize, 0};
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t offset, uint8_t *buffer, size_t n) {
-            std::for_each_n(buffer, n, [&](auto &value) {
-                value ^= key_iter.GetAndMove();
-
-                // Reaches page boundary
-                if (counter.Next())
-                {
-                    key_iter.Reset();
-                }
+        const auto data_offset = input->GetOffset();
+        QMC1StaticRandomAccessDecryptor decryptor{keystream_, data_offset, input->GetSize() - data_offset};
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor.DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
             });
 
-            // Off-by-1 fix at the first page.
-            if (offset < kCipherPageSize && kCipherPageSize < (offset + n))
-            {
-                auto boundary_index = kCipherPageSize - offset;
-                buffer[boundary_index] ^= key_[kCipherPageSize % key_.size()] ^ key_[0];
-            }
+        return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+    }
 
-            return output->Write(buffer, n);
-        });
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        const auto data_offset = input->GetOffset();
+        decryptor = std::make_unique<QMC1StaticRandomAccessDecryptor>(keystream_, data_offset,
+                                                                      input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
 
-        return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
     }
 };
 
@@ -1,4 +1,5 @@
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
 #include "parakeet-crypto/transformer/qmc.h"
 #include "test/read_fixture.test.hh"
 #include "test/test_decryption.test.hh"
@@ -10,6 +11,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 using ::testing::ContainerEq;
@@ -41,6 +43,40 @@ TEST(QMC1, DecryptionKey128)
 
     auto transformer = transformer::CreateQMC1StaticDecryptionTransformer(test_key128.data(), test_key128.size());
     test::should_decrypt_to_fixture("test_qmc1.qmcogg", transformer);
+    test::should_random_access_decrypt_to_fixture("test_qmc1.qmcogg", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_qmc1.qmcogg", transformer);
+}
+
+TEST(QMC1, PageKeystreamAcrossPages)
+{
+    std::array<uint8_t, 128> key128{};
+    for (size_t i = 0; i < key128.size(); i++)
+    {
+        key128[i] = static_cast<uint8_t>(i * 3 + 1);
+    }
+
+    // Reference: the key restarts at 0x8000, then every 0x7fff bytes.
+    constexpr size_t kDataSize = 0x7fff * 5 + 123;
+    std::vector<uint8_t> expected(kDataSize);
+    for (size_t i = 0; i < kDataSize; i++)
+    {
+        auto page_offset = i < 0x8000 ? i : i % 0x7fff;
+        expected[i] = key128[page_offset % key128.size()];
+    }
+
+    auto transformer = transformer::CreateQMC1StaticDecryptionTransformer(key128.data(), key128.size());
+    std::vector<uint8_t> encrypted(kDataSize, 0);
+    test::should_buffer_transform_to(encrypted, expected, transformer);
+
+    InputMemoryStream input{encrypted};
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateRandomAccessDecryptor(decryptor, &input), TransformResult::OK);
+    for (size_t offset : {0x7ffe, 0x7fff, 0x8000, 0xfffe, 0xffff, 0x7fff * 3 - 1})
+    {
+        std::vector<uint8_t> actual(300, 0);
+        ASSERT_TRUE(decryptor->DecryptAt(offset, actual.data(), actual.size()));
+        ASSERT_TRUE(std::equal(actual.begin(), actual.end(), &expected[offset])) << "offset=" << offset;
+    }
 }
 
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
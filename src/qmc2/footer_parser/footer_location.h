@@ -0,0 +1,37 @@
+#pragma once
+
+#include "parakeet-crypto/qmc2/footer_parser.h"
+#include "parakeet-crypto/qmc2/footer_scanner.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace parakeet_crypto::qmc2
+{
+
+/**
+ * @brief Footer found at the end of a buffer, before any decryption or copy.
+ */
+struct FooterLocation
+{
+    FooterParseState state{FooterParseState::UnknownContent};
+    FooterKind kind{FooterKind::UNKNOWN};
+
+    /**
+     * @brief Same as `FooterParseResult::footer_size`; bytes required when `state` is `NeedMoreBytes`.
+     */
+    size_t footer_size{0};
+
+    /**
+     * @brief Within the buffer: the ekey (ANDROID_QTAG, PC), or the musicex tag (PC_MUSICEX).
+     */
+    const uint8_t *payload{nullptr};
+    size_t payload_len{0};
+};
+
+/**
+ * @brief Locate the footer in the last `len` bytes of a file.
+ */
+FooterLocation LocateFooter(const uint8_t *file_footer, size_t len);
+
+} // namespace parakeet_crypto::qmc2
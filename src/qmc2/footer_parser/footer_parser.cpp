@@ -1,21 +1,61 @@
 #include "parakeet-crypto/qmc2/footer_parser.h"
+#include "footer_location.h"
 #include "footer_parser_android.h"
 #include "footer_parser_pc.h"
+#include "footer_parser_pc_v2.h"
 
-#include "qmc2/footer_parser/footer_parser_pc_v2.h"
 #include "utils/endian_helper.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 #include <utility>
 
 namespace parakeet_crypto::qmc2
 {
 
+FooterLocation LocateFooter(const uint8_t *file_footer, size_t len)
+{
+    constexpr size_t kMinimumFooterLen = sizeof(QQMusicTagMusicExTail);
+    if (len < kMinimumFooterLen)
+    {
+        return {FooterParseState::NeedMoreBytes, FooterKind::UNKNOWN, kMinimumFooterLen};
+    }
+
+    const auto *magic_u32 = &file_footer[len - sizeof(uint32_t)];
+    if (FooterParserAndroid::IsUnsupportedAndroidSTag(magic_u32))
+    {
+        auto footer_size = ReadBigEndian<uint32_t>(magic_u32 - sizeof(uint32_t)) + sizeof(uint32_t) * 2;
+        return {FooterParseState::UnsupportedAndroidClientSTag, FooterKind::ANDROID_STAG, footer_size};
+    }
+
+    if (FooterParserAndroid::IsAndroidQTag(magic_u32))
+    {
+        return FooterParserAndroid::Locate(file_footer, len);
+    }
+
+    if (FooterParserPC::IsPCFooter(magic_u32))
+    {
+        return FooterParserPC::Locate(file_footer, len);
+    }
+
+    const auto *tail_music_ex =
+        // NOLINTNEXTLINE(*-reinterpret-cast)
+        reinterpret_cast<const QQMusicTagMusicExTail *>(&file_footer[len - sizeof(QQMusicTagMusicExTail)]);
+    if (FooterParserPCMusicEx::IsPCMusicExFooter(tail_music_ex))
+    {
+        return FooterParserPCMusicEx::Locate(file_footer, len);
+    }
+
+    return {FooterParseState::UnknownContent};
+}
+
 class QMCFooterParserImpl : public QMCFooterParser
 {
   private:
     std::shared_ptr<IKeyCrypto> key_crypto_;
-    static constexpr size_t kMinimumFooterLen = sizeof(QQMusicTagMusicExTail);
 
   public:
     QMCFooterParserImpl(std::shared_ptr<IKeyCrypto> key_crypto) : QMCFooterParser(), key_crypto_(std::move(key_crypto))
@@ -24,37 +64,28 @@ class QMCFooterParserImpl : public QMCFooterParser
 
     std::unique_ptr<FooterParseResult> Parse(const uint8_t *file_footer, size_t len) override
     {
-        if (len < kMinimumFooterLen)
-        {
-            return std::make_unique<FooterParseResult>(FooterParseState::NeedMoreBytes, kMinimumFooterLen);
-        }
-
-        const auto *magic_u32 = &file_footer[len - sizeof(uint32_t)];
-        if (FooterParserAndroid::IsUnsupportedAndroidSTag(magic_u32))
-        {
-            auto footer_size = ReadBigEndian<uint32_t>(magic_u32 - sizeof(uint32_t)) + sizeof(uint32_t) * 2;
-            return std::make_unique<FooterParseResult>(FooterParseState::UnsupportedAndroidClientSTag, footer_size);
-        }
-
-        if (FooterParserAndroid::IsAndroidQTag(magic_u32))
+        auto location = LocateFooter(file_footer, len);
+        if (location.state != FooterParseState::OK)
         {
-            return FooterParserAndroid(key_crypto_).Parse(file_footer, len);
+            return std::make_unique<FooterParseResult>(location.state, location.footer_size);
         }
 
-        if (FooterParserPC::IsPCFooter(magic_u32))
+        if (location.kind == FooterKind::PC_MUSICEX)
         {
-            return FooterParserPC(key_crypto_).Parse(file_footer, len);
+            std::array<char, FooterParserPCMusicEx::kMaxMediaFileNameLen> name{};
+            auto name_len =
+                FooterParserPCMusicEx::ReadMediaFileName(location.payload, location.payload_len, name.data());
+            return std::make_unique<FooterParseResult>(FooterParseState::OK, location.footer_size,
+                                                       std::string_view{name.data(), name_len});
         }
 
-        const auto *tail_music_ex =
-            // NOLINTNEXTLINE(*-reinterpret-cast)
-            reinterpret_cast<const QQMusicTagMusicExTail *>(&file_footer[len - sizeof(QQMusicTagMusicExTail)]);
-        if (FooterParserPCMusicEx::IsPCMusicExFooter(tail_music_ex))
+        auto key = key_crypto_->Decrypt(location.payload, location.payload_len);
+        if (key.empty())
         {
-            return FooterParserPCMusicEx::Parse(file_footer, len);
+            return std::make_unique<FooterParseResult>(FooterParseState::KeyDecryptionFailure, location.footer_size);
         }
 
-        return std::make_unique<FooterParseResult>(FooterParseState::UnknownContent);
+        return std::make_unique<FooterParseResult>(FooterParseState::OK, location.footer_size, key);
     }
 };
 
@@ -1,15 +1,12 @@
 #pragma once
 
-#include "parakeet-crypto/qmc2/footer_parser.h"
-#include "parakeet-crypto/qmc2/key_crypto.h"
-#include "utils/endian_helper.h"
+#include "footer_location.h"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <iterator>
-#include <memory>
-#include <utility>
 
 namespace parakeet_crypto::qmc2
 {
@@ -44,7 +41,7 @@ constexpr std::array<uint8_t, 8> kMusicExTailMagic = {'m', 'u', 's', 'i', 'c', '
 class FooterParserPCMusicEx
 {
   public:
-    FooterParserPCMusicEx() = default;
+    static constexpr size_t kMaxMediaFileNameLen = sizeof(QQMusicTagMusicEx::mediafile) / sizeof(uint16_t) - 1;
 
     static inline bool IsPCMusicExFooter(const QQMusicTagMusicExTail *tail)
     {
@@ -61,7 +58,7 @@ class FooterParserPCMusicEx
         return true;
     }
 
-    static inline std::unique_ptr<FooterParseResult> Parse(const uint8_t *file_footer, size_t len)
+    static inline FooterLocation Locate(const uint8_t *file_footer, size_t len)
     {
         const auto *tail_music_magic =
             // NOLINTNEXTLINE(*-reinterpret-cast)
@@ -70,33 +67,38 @@ class FooterParserPCMusicEx
         // Check for overflow size
         if (tail_music_magic->sizeof_struct > sizeof(QQMusicTagMusicEx))
         {
-            return std::make_unique<FooterParseResult>(FooterParseState::MusicExBufferOverflow);
+            return {FooterParseState::MusicExBufferOverflow, FooterKind::PC_MUSICEX};
         }
 
         // Check for size required
         if (len < tail_music_magic->sizeof_struct)
         {
-            return std::make_unique<FooterParseResult>(FooterParseState::NeedMoreBytes,
-                                                       tail_music_magic->sizeof_struct);
+            return {FooterParseState::NeedMoreBytes, FooterKind::PC_MUSICEX, tail_music_magic->sizeof_struct};
         }
 
+        return {FooterParseState::OK, FooterKind::PC_MUSICEX, tail_music_magic->sizeof_struct,
+                &file_footer[len - tail_music_magic->sizeof_struct], tail_music_magic->sizeof_struct};
+    }
+
+    /**
+     * @brief Read the media file name from the musicex tag (`Locate`'s payload).
+     *
+     * @param media_file_name At least `kMaxMediaFileNameLen` chars.
+     * @return size_t Length of the name.
+     */
+    static inline size_t ReadMediaFileName(const uint8_t *tag_data, size_t tag_len, char *media_file_name)
+    {
         // Fetch the whole musicex tag
         QQMusicTagMusicEx tag{};
-        memcpy(&tag, &file_footer[len - tail_music_magic->sizeof_struct], tail_music_magic->sizeof_struct);
+        memcpy(&tag, tag_data, std::min(tag_len, sizeof(tag)));
 
         // Since media_file_name only uses ascii chars, we can convert them without issues.
-        constexpr size_t kMediaFileLen = sizeof(tag.mediafile) / sizeof(tag.mediafile[0]) - 1;
-
-        // make a copy of the name
-        std::string media_file_name{};
-        media_file_name.reserve(kMediaFileLen);
-        for (size_t i = 0; i < kMediaFileLen && tag.mediafile[i] != 0; i++)
+        size_t name_len = 0;
+        for (; name_len < kMaxMediaFileNameLen && tag.mediafile[name_len] != 0; name_len++)
         {
-            media_file_name.push_back(static_cast<char>(tag.mediafile[i]));
+            media_file_name[name_len] = static_cast<char>(tag.mediafile[name_len]);
         }
-
-        return std::make_unique<FooterParseResult>(FooterParseState::OK, tail_music_magic->sizeof_struct,
-                                                   media_file_name);
+        return name_len;
     }
 };
 
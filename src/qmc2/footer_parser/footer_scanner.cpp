@@ -0,0 +1,207 @@
+#include "parakeet-crypto/qmc2/footer_scanner.h"
+#include "footer_location.h"
+#include "footer_parser_pc_v2.h"
+
+#include "parakeet-crypto/StreamHelper.h"
+#include "utils/parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#if _WIN32
+#include <io.h>
+#endif
+
+namespace parakeet_crypto::qmc2
+{
+
+namespace
+{
+
+#if _WIN32
+inline int OpenFileForRead(const char *path)
+{
+    return _open(path, _O_RDONLY | _O_BINARY | _O_RANDOM);
+}
+#else
+inline int OpenFileForRead(const char *path)
+{
+    return open(path, O_RDONLY | O_CLOEXEC); // NOLINT(*-vararg)
+}
+#endif
+
+/**
+ * @brief Per-thread state: the tail buffer, and the keys and names of the files scanned by this thread.
+ */
+struct ScanWorker
+{
+    std::vector<uint8_t> buffer{};
+    std::vector<uint8_t> data{};
+};
+
+class QMCFooterScannerImpl : public QMCFooterScanner
+{
+  private:
+    std::shared_ptr<IKeyCrypto> key_crypto_;
+    FooterScanOptions options_;
+
+    void StoreData(FooterScanEntry &entry, ScanWorker &worker, const uint8_t *data, size_t len) const
+    {
+        entry.data_offset = worker.data.size();
+        entry.data_len = static_cast<uint32_t>(len);
+        worker.data.insert(worker.data.end(), data, data + len);
+    }
+
+    void ScanStream(FooterScanEntry &entry, ScanWorker &worker, InputFDStream &stream) const
+    {
+        const size_t file_size = stream.GetSize();
+        entry.file_size = file_size;
+
+        auto &buffer = worker.buffer;
+        size_t tail_len = std::min(options_.tail_size, file_size);
+        buffer.resize(std::max(buffer.size(), tail_len));
+        if (stream.ReadAt(file_size - tail_len, buffer.data(), tail_len) != tail_len)
+        {
+            entry.state = FooterParseState::IOReadFailure;
+            return;
+        }
+
+        auto location = LocateFooter(buffer.data(), tail_len);
+        if (location.state == FooterParseState::NeedMoreBytes && location.footer_size <= file_size)
+        {
+            // Read the missing bytes only, in front of those we have.
+            const size_t missing_len = location.footer_size - tail_len;
+            buffer.resize(std::max(buffer.size(), location.footer_size));
+            std::memmove(&buffer[missing_len], buffer.data(), tail_len);
+            if (stream.ReadAt(file_size - location.footer_size, buffer.data(), missing_len) != missing_len)
+            {
+                entry.state = FooterParseState::IOReadFailure;
+                return;
+            }
+
+            tail_len = location.footer_size;
+            location = LocateFooter(buffer.data(), tail_len);
+        }
+
+        entry.state = location.state;
+        entry.kind = location.kind;
+        entry.footer_size = static_cast<uint32_t>(location.footer_size);
+        if (location.state != FooterParseState::OK)
+        {
+            return;
+        }
+
+        if (location.kind == FooterKind::PC_MUSICEX)
+        {
+            std::array<char, FooterParserPCMusicEx::kMaxMediaFileNameLen> name{};
+            auto name_len =
+                FooterParserPCMusicEx::ReadMediaFileName(location.payload, location.payload_len, name.data());
+            // NOLINTNEXTLINE(*-reinterpret-cast)
+            StoreData(entry, worker, reinterpret_cast<const uint8_t *>(name.data()), name_len);
+        }
+        else if (key_crypto_ == nullptr)
+        {
+            StoreData(entry, worker, location.payload, location.payload_len);
+        }
+        else
+        {
+            auto key = key_crypto_->Decrypt(location.payload, location.payload_len);
+            if (key.empty())
+            {
+                entry.state = FooterParseState::KeyDecryptionFailure;
+                return;
+            }
+            StoreData(entry, worker, key.data(), key.size());
+        }
+    }
+
+    /**
+     * @param scan_file `scan_file(entry, worker, i)`
+     */
+    template <typename ScanFile> FooterScanResult Scan(size_t count, ScanFile scan_file) const
+    {
+        auto thread_count = options_.thread_count == 0 ? utils::GetDefaultThreadCount() : options_.thread_count;
+        thread_count = std::max(size_t{1}, std::min(thread_count, count));
+
+        FooterScanResult result{};
+        result.entries.resize(count);
+        std::vector<ScanWorker> workers(thread_count);
+        std::vector<uint32_t> entry_workers(count);
+        utils::RunOnThreads(count, thread_count, [&](size_t worker, size_t i) {
+            entry_workers[i] = static_cast<uint32_t>(worker);
+            scan_file(result.entries[i], workers[worker], i);
+        });
+
+        // Pack the data of every worker into a single buffer.
+        std::vector<uint64_t> worker_data_offsets(thread_count);
+        size_t data_size = 0;
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            worker_data_offsets[i] = data_size;
+            data_size += workers[i].data.size();
+        }
+        result.data.reserve(data_size);
+        for (const auto &worker : workers)
+        {
+            result.data.insert(result.data.end(), worker.data.begin(), worker.data.end());
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            result.entries[i].data_offset += worker_data_offsets[entry_workers[i]];
+        }
+
+        return result;
+    }
+
+  public:
+    QMCFooterScannerImpl(std::shared_ptr<IKeyCrypto> key_crypto, const FooterScanOptions &options)
+        : key_crypto_(std::move(key_crypto)), options_(options)
+    {
+    }
+
+    FooterScanResult ScanFiles(const std::vector<std::string> &paths) override
+    {
+        return Scan(paths.size(), [&](FooterScanEntry &entry, ScanWorker &worker, size_t i) {
+            int fd = OpenFileForRead(paths[i].c_str());
+            if (fd < 0)
+            {
+                entry.state = FooterParseState::IOReadFailure;
+                return;
+            }
+
+            InputFDStream stream{fd, true};
+            ScanStream(entry, worker, stream);
+        });
+    }
+
+    FooterScanResult ScanFDs(const std::vector<int> &fds) override
+    {
+        return Scan(fds.size(), [&](FooterScanEntry &entry, ScanWorker &worker, size_t i) {
+            InputFDStream stream{fds[i], false};
+            ScanStream(entry, worker, stream);
+        });
+    }
+};
+
+} // namespace
+
+std::unique_ptr<QMCFooterScanner> CreateQMC2FooterScanner(std::shared_ptr<IKeyCrypto> key_crypto,
+                                                          const FooterScanOptions &options)
+{
+    if (options.tail_size == 0)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<QMCFooterScannerImpl>(std::move(key_crypto), options);
+}
+
+} // namespace parakeet_crypto::qmc2
@@ -0,0 +1,178 @@
+#include "parakeet-crypto/qmc2/footer_scanner.h"
+#include "parakeet-crypto/qmc2/key_crypto.h"
+#include "qmc2/qmc2_keys.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+using namespace parakeet_crypto::qmc2;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+class QMCFooterScannerTest : public ::testing::Test
+{
+  protected:
+    std::filesystem::path dir_{};
+    std::shared_ptr<IKeyCrypto> key_crypto_{};
+
+    void SetUp() override
+    {
+        const auto *test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+        dir_ = std::filesystem::temp_directory_path() / ("parakeet_footer_scan_" + std::string(test_info->name()));
+        std::filesystem::create_directories(dir_);
+        key_crypto_ = CreateKeyCrypto(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::string WriteFile(const char *name, const std::vector<uint8_t> &audio, const std::vector<uint8_t> &footer)
+    {
+        auto path = (dir_ / name).string();
+        std::ofstream ofs(path, std::ios::binary);
+        ofs.write(reinterpret_cast<const char *>(audio.data()), static_cast<std::streamsize>(audio.size()));
+        ofs.write(reinterpret_cast<const char *>(footer.data()), static_cast<std::streamsize>(footer.size()));
+        return path;
+    }
+
+    std::vector<uint8_t> MakeKey(size_t len)
+    {
+        std::vector<uint8_t> key(len);
+        for (size_t i = 0; i < len; i++)
+        {
+            key[i] = static_cast<uint8_t>(i * 7 + 1);
+        }
+        return key;
+    }
+
+    static std::vector<uint8_t> MakePCFooter(const std::vector<uint8_t> &ekey)
+    {
+        auto footer = ekey;
+        auto len = static_cast<uint32_t>(ekey.size());
+        footer.insert(footer.end(), {static_cast<uint8_t>(len), static_cast<uint8_t>(len >> 8), 0, 0});
+        return footer;
+    }
+
+    static std::vector<uint8_t> MakeQTagFooter(const std::vector<uint8_t> &ekey)
+    {
+        auto footer = ekey;
+        footer.insert(footer.end(), {',', '1', '2', '3', ',', '2'});
+        auto len = static_cast<uint32_t>(footer.size());
+        footer.insert(footer.end(), {0, 0, static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len)});
+        footer.insert(footer.end(), {'Q', 'T', 'a', 'g'});
+        return footer;
+    }
+
+    static std::vector<uint8_t> MakeMusicExFooter(const char *media_file_name)
+    {
+        std::vector<uint8_t> footer(0xC0);
+        for (size_t i = 0; media_file_name[i] != 0; i++)
+        {
+            footer[72 + i * 2] = static_cast<uint8_t>(media_file_name[i]);
+        }
+        const std::vector<uint8_t> tail = {0xC0, 0, 0, 0, 1, 0, 0, 0, 'm', 'u', 's', 'i', 'c', 'e', 'x', 0};
+        std::copy(tail.begin(), tail.end(), footer.end() - 16);
+        return footer;
+    }
+};
+
+} // namespace
+
+TEST_F(QMCFooterScannerTest, ScanFiles)
+{
+    const std::vector<uint8_t> audio(4096, 0xAA);
+    auto pc_key = MakeKey(256);
+    auto qtag_key = MakeKey(300);
+    auto large_key = MakeKey(600); // ekey longer than the initial tail
+
+    auto pc_footer = MakePCFooter(key_crypto_->Encrypt(pc_key.data(), pc_key.size(), KeyVersion::VERSION_2));
+    auto large_footer = MakePCFooter(key_crypto_->Encrypt(large_key.data(), large_key.size(), KeyVersion::VERSION_2));
+    ASSERT_GT(large_footer.size(), FooterScanOptions::kDefaultTailSize);
+
+    std::vector<std::string> paths = {
+        WriteFile("pc.mflac", audio, pc_footer),
+        WriteFile("qtag.mflac", audio, MakeQTagFooter(key_crypto_->Encrypt(qtag_key.data(), qtag_key.size(),
+                                                                           KeyVersion::VERSION_1))),
+        WriteFile("large.mflac", audio, large_footer),
+        WriteFile("musicex.mflac", audio, MakeMusicExFooter("F0M000123456789ZZZ.mflac")),
+        WriteFile("stag.mflac", audio, {'1', '2', ',', '2', 0, 0, 0, 4, 'S', 'T', 'a', 'g'}),
+        WriteFile("tiny.mflac", {}, {1, 2, 3}),
+        (dir_ / "missing.mflac").string(),
+    };
+
+    auto scanner = CreateQMC2FooterScanner(key_crypto_, FooterScanOptions{FooterScanOptions::kDefaultTailSize, 3});
+    auto result = scanner->ScanFiles(paths);
+    ASSERT_EQ(result.entries.size(), paths.size());
+
+    const auto &pc = result.entries[0];
+    ASSERT_EQ(pc.state, FooterParseState::OK);
+    ASSERT_EQ(pc.kind, FooterKind::PC);
+    ASSERT_EQ(pc.footer_size, pc_footer.size());
+    ASSERT_EQ(pc.file_size, audio.size() + pc_footer.size());
+    ASSERT_THAT(std::vector<uint8_t>(result.GetData(pc), result.GetData(pc) + pc.data_len), ContainerEq(pc_key));
+
+    const auto &qtag = result.entries[1];
+    ASSERT_EQ(qtag.state, FooterParseState::OK);
+    ASSERT_EQ(qtag.kind, FooterKind::ANDROID_QTAG);
+    ASSERT_THAT(std::vector<uint8_t>(result.GetData(qtag), result.GetData(qtag) + qtag.data_len),
+                ContainerEq(qtag_key));
+
+    const auto &large = result.entries[2];
+    ASSERT_EQ(large.state, FooterParseState::OK);
+    ASSERT_EQ(large.footer_size, large_footer.size());
+    ASSERT_THAT(std::vector<uint8_t>(result.GetData(large), result.GetData(large) + large.data_len),
+                ContainerEq(large_key));
+
+    const auto &musicex = result.entries[3];
+    ASSERT_EQ(musicex.state, FooterParseState::OK);
+    ASSERT_EQ(musicex.kind, FooterKind::PC_MUSICEX);
+    ASSERT_EQ(musicex.footer_size, 0xC0);
+    ASSERT_EQ(result.GetMediaFileName(musicex), "F0M000123456789ZZZ.mflac");
+
+    ASSERT_EQ(result.entries[4].state, FooterParseState::UnsupportedAndroidClientSTag);
+    ASSERT_EQ(result.entries[4].footer_size, 12);
+    ASSERT_EQ(result.entries[5].state, FooterParseState::NeedMoreBytes);
+    ASSERT_EQ(result.entries[6].state, FooterParseState::IOReadFailure);
+}
+
+TEST_F(QMCFooterScannerTest, ScanWithoutKeyCrypto)
+{
+    auto ekey = key_crypto_->Encrypt(MakeKey(128).data(), 128, KeyVersion::VERSION_2);
+    auto path = WriteFile("pc.mflac", std::vector<uint8_t>(100, 0), MakePCFooter(ekey));
+
+    FooterScanOptions options{};
+    options.tail_size = 32; // force a second read
+    auto scanner = CreateQMC2FooterScanner(nullptr, options);
+    auto result = scanner->ScanFiles({path, path});
+    ASSERT_EQ(result.entries.size(), 2);
+    for (const auto &entry : result.entries)
+    {
+        ASSERT_EQ(entry.state, FooterParseState::OK);
+        ASSERT_THAT(std::vector<uint8_t>(result.GetData(entry), result.GetData(entry) + entry.data_len),
+                    ContainerEq(ekey));
+    }
+}
+
+TEST_F(QMCFooterScannerTest, InvalidOptions)
+{
+    FooterScanOptions options{};
+    options.tail_size = 0;
+    ASSERT_EQ(CreateQMC2FooterScanner(key_crypto_, options), nullptr);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
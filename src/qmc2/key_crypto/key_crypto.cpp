@@ -3,6 +3,7 @@
 #include "key_v1.h"
 #include "key_v2.h"
 
+#include "parakeet-crypto/KeyDerivationCache.h"
 #include "parakeet-crypto/utils/base64.h"
 
 #include <algorithm>
@@ -10,6 +11,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::qmc2
@@ -21,9 +23,33 @@ class KeyCryptoImpl : public IKeyCrypto
     uint8_t seed_{};
     std::array<uint8_t, kEncV2KeyLen> enc_v2_key_1_{};
     std::array<uint8_t, kEncV2KeyLen> enc_v2_key_2_{};
+    std::shared_ptr<KeyDerivationCache> key_cache_{};
+
+    std::vector<uint8_t> DecryptUncached(const uint8_t *key_cipher, size_t len) const
+    {
+        auto key = utils::Base64Decode(key_cipher, len);
+        if (KeyEncryptionV2::IsEncV2(key.data()))
+        {
+            auto decrypted_key = GetEncV2().Decrypt(key);
+            if (!decrypted_key.has_value())
+            {
+                return {};
+            }
+            key = decrypted_key.value();
+        }
+
+        if (auto decrypted_key = GetEncV1().Decrypt(key))
+        {
+            return decrypted_key.value();
+        }
+
+        return {};
+    }
 
   public:
-    KeyCryptoImpl(uint8_t initial_seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2) : seed_(initial_seed)
+    KeyCryptoImpl(uint8_t initial_seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2,
+                  std::shared_ptr<KeyDerivationCache> key_cache)
+        : seed_(initial_seed), key_cache_(std::move(key_cache))
     {
         std::copy_n(enc_v2_key_1, kEncV2KeyLen, enc_v2_key_1_.begin());
         std::copy_n(enc_v2_key_2, kEncV2KeyLen, enc_v2_key_2_.begin());
@@ -42,23 +68,19 @@ class KeyCryptoImpl : public IKeyCrypto
 
     std::vector<uint8_t> Decrypt(const uint8_t *key_cipher, size_t len) override
     {
-        auto key = utils::Base64Decode(key_cipher, len);
-        if (KeyEncryptionV2::IsEncV2(key.data()))
-        {
-            auto decrypted_key = GetEncV2().Decrypt(key);
-            if (!decrypted_key.has_value())
-            {
-                return {};
-            }
-            key = decrypted_key.value();
-        }
-
-        if (auto decrypted_key = GetEncV1().Decrypt(key))
+        if (!key_cache_)
         {
-            return decrypted_key.value();
+            return DecryptUncached(key_cipher, len);
         }
 
-        return {};
+        auto input = MakeKeyDerivationInput({
+            {&seed_, sizeof(seed_)},
+            {enc_v2_key_1_.data(), enc_v2_key_1_.size()},
+            {enc_v2_key_2_.data(), enc_v2_key_2_.size()},
+            {key_cipher, len},
+        });
+        return DeriveKey(key_cache_.get(), KeyDerivationKind::QMC2_EKEY, input,
+                         [&]() { return DecryptUncached(key_cipher, len); });
     }
 
     std::vector<uint8_t> Encrypt(const uint8_t *key, size_t len, KeyVersion version) override
@@ -76,7 +98,13 @@ class KeyCryptoImpl : public IKeyCrypto
 
 std::unique_ptr<IKeyCrypto> CreateKeyCrypto(uint8_t seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2)
 {
-    return std::make_unique<KeyCryptoImpl>(seed, enc_v2_key_1, enc_v2_key_2);
+    return std::make_unique<KeyCryptoImpl>(seed, enc_v2_key_1, enc_v2_key_2, nullptr);
+}
+
+std::unique_ptr<IKeyCrypto> CreateKeyCrypto(uint8_t seed, const uint8_t *enc_v2_key_1, const uint8_t *enc_v2_key_2,
+                                            std::shared_ptr<KeyDerivationCache> key_cache)
+{
+    return std::make_unique<KeyCryptoImpl>(seed, enc_v2_key_1, enc_v2_key_2, std::move(key_cache));
 }
 
 } // namespace parakeet_crypto::qmc2
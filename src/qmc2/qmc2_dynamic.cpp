@@ -1,13 +1,17 @@
+#include "parakeet-crypto/IStreamingDecryptor.h"
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/StreamHelper.h"
 #include "parakeet-crypto/qmc2/footer_parser.h"
 #include "parakeet-crypto/qmc2/key_util.h"
 #include "parakeet-crypto/transformer/qmc.h"
 
+#include "qmc2/footer_parser/footer_location.h"
 #include "qmc2/rc4_crypto/qmc2_rc4_impl.h"
 #include "qmc2/rc4_crypto/qmc2_segment.h"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -15,11 +19,129 @@
 namespace parakeet_crypto::transformer
 {
 
+namespace
+{
+
+constexpr size_t kTailWindowSize = 0x10000; // Much larger than any footer seen.
+
+/**
+ * @brief Size of the footer at the end of `tail`, when the key is already known: the ekey is not decrypted, so
+ *        footers that cannot be decrypted (e.g. other client versions) are still left out of the audio.
+ */
+size_t LocateFooterSize(const uint8_t *tail, size_t len)
+{
+    auto location = qmc2::LocateFooter(tail, len);
+    if (location.state == qmc2::FooterParseState::OK ||
+        location.state == qmc2::FooterParseState::UnsupportedAndroidClientSTag)
+    {
+        return location.footer_size;
+    }
+    return 0;
+}
+
+} // namespace
+
+/**
+ * @brief Decrypt a QMCv2 file with a known key, received in chunks.
+ *        The footer can only be told apart from the audio once the end of the file is reached, so the last
+ *        `kTailWindowSize` bytes received are held back, then looked up to find the footer size.
+ */
+class QMC2StreamingDecryptor final : public IStreamingDecryptor
+{
+  private:
+    std::shared_ptr<ITransformer> next_transformer_{};
+    std::unique_ptr<IStreamingDecryptor> next_decryptor_{};
+    std::vector<uint8_t> tail_{};
+    size_t tail_begin_{0}; // bytes of `tail_` before this offset were already forwarded
+
+    [[nodiscard]] size_t GetTailSize() const
+    {
+        return tail_.size() - tail_begin_;
+    }
+
+  public:
+    QMC2StreamingDecryptor(std::shared_ptr<ITransformer> next_transformer,
+                           std::unique_ptr<IStreamingDecryptor> next_decryptor)
+        : next_transformer_(std::move(next_transformer)), next_decryptor_(std::move(next_decryptor))
+    {
+        tail_.reserve(kTailWindowSize + kTailWindowSize / 2);
+    }
+
+    [[nodiscard]] const char *GetName() const override
+    {
+        return next_decryptor_->GetName();
+    }
+
+    TransformResult Update(const uint8_t *input, size_t len, IWriteable *output) override
+    {
+        // Forward what no longer fits in the tail window, oldest bytes first.
+        if (GetTailSize() + len > kTailWindowSize)
+        {
+            auto release_len = GetTailSize() + len - kTailWindowSize;
+            auto release_from_tail = std::min(release_len, GetTailSize());
+            if (release_from_tail > 0)
+            {
+                if (auto result = next_decryptor_->Update(&tail_[tail_begin_], release_from_tail, output);
+                    result != TransformResult::OK)
+                {
+                    return result;
+                }
+                tail_begin_ += release_from_tail;
+            }
+
+            auto release_from_input = release_len - release_from_tail;
+            if (auto result = next_decryptor_->Update(input, release_from_input, output);
+                result != TransformResult::OK)
+            {
+                return result;
+            }
+            input += release_from_input;
+            len -= release_from_input;
+        }
+
+        // Move the held bytes back to the front once the forwarded ones take half the window.
+        if (tail_begin_ >= kTailWindowSize / 2)
+        {
+            tail_.erase(tail_.begin(), tail_.begin() + static_cast<std::ptrdiff_t>(tail_begin_));
+            tail_begin_ = 0;
+        }
+        tail_.insert(tail_.end(), input, input + len);
+        return TransformResult::OK;
+    }
+
+    TransformResult Final(IWriteable *output) override
+    {
+        const uint8_t *tail = tail_.data() + tail_begin_;
+        const auto tail_size = GetTailSize();
+
+        const auto trim_size = LocateFooterSize(tail, tail_size);
+        if (trim_size > tail_size)
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        if (auto result = next_decryptor_->Update(tail, tail_size - trim_size, output); result != TransformResult::OK)
+        {
+            return result;
+        }
+        tail_ = std::vector<uint8_t>{};
+        tail_begin_ = 0;
+        return next_decryptor_->Final(output);
+    }
+};
+
 class QMC2DecryptionTransformer final : public ITransformer
 {
   private:
     std::shared_ptr<qmc2::QMCFooterParser> footer_parser_{};
-    std::vector<uint8_t> key_{};
+    std::shared_ptr<ITransformer> key_transformer_{}; // Built once when the key is supplied.
+
+    static std::unique_ptr<ITransformer> CreateKeyTransformer(const std::vector<uint8_t> &key)
+    {
+        return (qmc2::GetEncryptionType(key) == qmc2::QMC2EncryptionType::RC4)
+                   ? CreateQMC2RC4DecryptionTransformer(key)
+                   : CreateQMC2MapDecryptionTransformer(key);
+    }
 
   public:
     QMC2DecryptionTransformer(std::shared_ptr<qmc2::QMCFooterParser> footer_parser)
@@ -32,7 +154,7 @@ class QMC2DecryptionTransformer final : public ITransformer
     {
         if (key != nullptr && key_len > 0)
         {
-            key_.assign(key, key + key_len);
+            key_transformer_ = CreateKeyTransformer(std::vector<uint8_t>(key, key + key_len));
         }
     }
 
@@ -41,32 +163,93 @@ class QMC2DecryptionTransformer final : public ITransformer
         return "QMCv2 (MAP/RC4)";
     }
 
-    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    /**
+     * @brief Find the footer, and create the transformer for the key supplied, or else the key in the footer.
+     *
+     * @param next_transformer Transformer to decrypt the payload.
+     * @param data_size Size of the payload, excluding the footer.
+     */
+    TransformResult CreateNextTransformer(std::shared_ptr<ITransformer> &next_transformer, size_t &data_size,
+                                          IReadSeekable *input)
     {
-        std::vector<uint8_t> key;
-        size_t trim_size{0};
-        auto parse_result = footer_parser_->Parse(*input);
-        if (parse_result->state != qmc2::FooterParseState::OK)
+        if (key_transformer_)
         {
-            // no key found, and no fallback key provided:
-            if (key_.empty())
+            // Look for the footer in the same window as the streaming decryptor, so both trim the same bytes.
+            std::vector<uint8_t> tail(std::min(kTailWindowSize, input->GetSize()));
+            if (input->ReadAt(input->GetSize() - tail.size(), tail.data(), tail.size()) != tail.size())
+            {
+                return TransformResult::ERROR_INSUFFICIENT_INPUT;
+            }
+
+            const auto trim_size = LocateFooterSize(tail.data(), tail.size());
+            if (trim_size > tail.size())
             {
                 return TransformResult::ERROR_INVALID_FORMAT;
             }
+
+            next_transformer = key_transformer_;
+            data_size = input->GetSize() - trim_size;
+            return TransformResult::OK;
         }
-        if (parse_result->state == qmc2::FooterParseState::UnsupportedAndroidClientSTag ||
-            parse_result->state == qmc2::FooterParseState::OK)
+
+        // no key found, and no fallback key provided:
+        auto parse_result = footer_parser_->Parse(*input);
+        if (parse_result->state != qmc2::FooterParseState::OK || parse_result->footer_size > input->GetSize())
         {
-            trim_size = parse_result->footer_size;
+            return TransformResult::ERROR_INVALID_FORMAT;
         }
-        key = key_.empty() ? parse_result->key : key_;
 
-        auto next_transformer = (qmc2::GetEncryptionType(key) == qmc2::QMC2EncryptionType::RC4)
-                                    ? CreateQMC2RC4DecryptionTransformer(key)
-                                    : CreateQMC2MapDecryptionTransformer(key);
-        SlicedReadableStream reader{*input, 0, input->GetSize() - trim_size};
+        next_transformer = CreateKeyTransformer(parse_result->key);
+        data_size = input->GetSize() - parse_result->footer_size;
+        return TransformResult::OK;
+    }
+
+    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    {
+        std::shared_ptr<ITransformer> next_transformer{};
+        size_t data_size{};
+        if (auto result = CreateNextTransformer(next_transformer, data_size, input); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        SlicedReadableStream reader{*input, 0, data_size};
         return next_transformer->Transform(output, &reader);
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::shared_ptr<ITransformer> next_transformer{};
+        size_t data_size{};
+        if (auto result = CreateNextTransformer(next_transformer, data_size, input); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        SlicedReadableStream reader{*input, 0, data_size};
+        return next_transformer->CreateRandomAccessDecryptor(decryptor, &reader);
+    }
+
+    /**
+     * @brief Only supported when the key was supplied: the footer is not received until the end of the file.
+     */
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        if (!key_transformer_)
+        {
+            return TransformResult::ERROR_NOT_IMPLEMENTED;
+        }
+
+        std::unique_ptr<IStreamingDecryptor> next_decryptor{};
+        if (auto result = key_transformer_->CreateStreamingDecryptor(next_decryptor); result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        decryptor = std::make_unique<QMC2StreamingDecryptor>(key_transformer_, std::move(next_decryptor));
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateQMC2DecryptionTransformer(std::shared_ptr<qmc2::QMCFooterParser> footer_parser)
@@ -32,11 +32,16 @@ namespace parakeet_crypto::test
 
 // NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 
-inline void DecryptQMC2Stream(std::vector<uint8_t> &vec_result, std::vector<uint8_t> &vec_encrypted)
+inline std::unique_ptr<ITransformer> CreateQMC2TestTransformer()
 {
     auto key_crypto = qmc2::CreateKeyCrypto(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
     auto footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
-    std::unique_ptr<ITransformer> transformer = transformer::CreateQMC2DecryptionTransformer(std::move(footer_parser));
+    return transformer::CreateQMC2DecryptionTransformer(std::move(footer_parser));
+}
+
+inline void DecryptQMC2Stream(std::vector<uint8_t> &vec_result, std::vector<uint8_t> &vec_encrypted)
+{
+    std::unique_ptr<ITransformer> transformer = CreateQMC2TestTransformer();
     OutputMemoryStream writer{};
     InputMemoryStream reader{vec_encrypted};
     ASSERT_EQ(transformer->Transform(&writer, &reader), TransformResult::OK);
@@ -5,6 +5,7 @@
 #include "qmc2_keys.test.hh"
 
 #include "test/read_fixture.test.hh"
+#include "test/test_decryption.test.hh"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -30,4 +31,27 @@ TEST(QMC2_Map, DecryptionKey256)
     ASSERT_THAT(decrypted, ContainerEq(plain_file));
 }
 
+TEST(QMC2_Map, RandomAccess)
+{
+    auto transformer = test::CreateQMC2TestTransformer();
+    test::should_random_access_decrypt_to_fixture("test_qmc2_map.mgg", transformer);
+}
+
+TEST(QMC2_Map, StreamingDecryptionWithKey)
+{
+    auto plain_file = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto fixture_encrypted = test::read_fixture("test_qmc2_map.mgg");
+
+    // Key is supplied out of band: take it from the footer, and only stream the audio data.
+    auto key_crypto = qmc2::CreateKeyCrypto(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
+    auto footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
+    InputMemoryStream reader{fixture_encrypted};
+    auto footer = footer_parser->Parse(reader);
+    ASSERT_EQ(footer->state, qmc2::FooterParseState::OK);
+    fixture_encrypted.resize(fixture_encrypted.size() - footer->footer_size);
+
+    auto transformer = transformer::CreateQMC2MapDecryptionTransformer(footer->key);
+    test::should_stream_decrypt_to(fixture_encrypted, plain_file, transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -1,61 +1,78 @@
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/transformer/qmc.h"
-#include "qmc2/rc4_crypto/qmc2_rc4_impl.h"
-#include "qmc2/rc4_crypto/qmc2_segment.h"
-
-#include <array>
+#include "qmc2/rc4_crypto/qmc2_rc4_key_schedule.h"
+#include "utils/paged_reader.h"
+#include "utils/parallel.h"
+#include "utils/parallel_decrypt.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
+#include "utils/xor_helper.h"
+
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::transformer
 {
 
-constexpr size_t kFirstSegmentSize{0x0080};
-constexpr size_t kOtherSegmentSize{0x1400};
-constexpr size_t kSegmentSize{kOtherSegmentSize}; // Pick the largest one
-
-static_assert(kSegmentSize >= kFirstSegmentSize);
-static_assert(kSegmentSize >= kOtherSegmentSize);
+using qmc2_rc4::kFirstSegmentSize;
+using qmc2_rc4::kOtherSegmentSize;
 
-class QMC2RC4DecryptionTransformer final : public ITransformer
+class QMC2RC4RandomAccessDecryptor final : public utils::RandomAccessDecryptor
 {
   private:
-    std::vector<uint8_t> key_{};
-    std::vector<uint8_t> rc4_state_{};
-    qmc2_rc4::SegmentKeyImpl segment_key_;
+    std::shared_ptr<const qmc2_rc4::KeySchedule> schedule_{};
 
-    inline void ProcessFirstSegment(uint8_t *buffer, size_t buffer_len)
+  public:
+    QMC2RC4RandomAccessDecryptor(std::shared_ptr<const qmc2_rc4::KeySchedule> schedule, size_t data_offset,
+                                 size_t data_size)
+        : RandomAccessDecryptor("QMCv2 (RC4)", data_offset, data_size), schedule_(std::move(schedule))
     {
-        auto key_len = key_.size();
-        for (size_t i = 0; i < buffer_len; i++)
-        {
-            auto seed = key_[i % key_len];
-            auto next_index = segment_key_.GetKey(i, seed) % key_len;
-            buffer[i] ^= key_[next_index];
-        }
     }
 
-    inline void ProcessOtherSegment(size_t offset, uint32_t segment_id, uint8_t *buffer, size_t buffer_len)
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
     {
-        // 511: equivalent to "% 512". QM had this value hardcoded.
-        constexpr size_t kKeyIndexMask = 0x1FF;
+        if (offset < kFirstSegmentSize)
+        {
+            auto process_len = std::min(len, kFirstSegmentSize - offset);
+            utils::XorBytes(dst, src, schedule_->GetFirstSegmentMask() + offset, process_len);
 
-        auto seed = key_[segment_id & kKeyIndexMask];
-        auto inital_discard = segment_key_.GetKey(segment_id, seed) & kKeyIndexMask;
-        auto discard_count = static_cast<uint32_t>(offset + inital_discard);
+            dst += process_len;
+            src += process_len;
+            offset += process_len;
+            len -= process_len;
+        }
 
-        qmc2_rc4::RC4 rc4{rc4_state_, discard_count};
-        for (size_t i = 0; i < buffer_len; i++)
+        // The rest of the first segment (up to kOtherSegmentSize) uses the RC4 keystream of segment 0.
+        while (len > 0)
         {
-            buffer[i] ^= rc4.Next();
+            auto segment_id = static_cast<uint32_t>(offset / kOtherSegmentSize);
+            auto segment_offset = offset % kOtherSegmentSize;
+            auto process_len = std::min(len, kOtherSegmentSize - segment_offset);
+            utils::XorBytes(dst, src, schedule_->GetSegmentKeystream(segment_id) + segment_offset, process_len);
+
+            dst += process_len;
+            src += process_len;
+            offset += process_len;
+            len -= process_len;
         }
+
+        return true;
     }
+};
+
+class QMC2RC4DecryptionTransformer final : public ITransformer
+{
+  private:
+    std::shared_ptr<const qmc2_rc4::KeySchedule> schedule_{};
+    size_t thread_count_{1};
 
   public:
-    QMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len)
-        : segment_key_(qmc2_rc4::SegmentKeyImpl{key, key_len}), key_{key, key + key_len},
-          rc4_state_(qmc2_rc4::RC4::CreateStateFromKey(key, key_len))
+    QMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len, size_t thread_count)
+        : schedule_(std::make_shared<const qmc2_rc4::KeySchedule>(key, key_len)), thread_count_(thread_count)
     {
     }
 
@@ -66,58 +83,74 @@ class QMC2RC4DecryptionTransformer final : public ITransformer
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        std::array<uint8_t, kSegmentSize> buffer{};
-
-        { // Process first segment
-            size_t bytes_read = input->Read(buffer.data(), kFirstSegmentSize);
-            if (bytes_read == 0)
-            {
-                return TransformResult::OK;
-            }
-
-            ProcessFirstSegment(buffer.data(), bytes_read);
-            if (!output->Write(buffer.data(), bytes_read))
-            {
-                return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
-            }
+        const auto data_offset = input->GetOffset();
+        QMC2RC4RandomAccessDecryptor decryptor{schedule_, data_offset, input->GetSize() - data_offset};
+        if (thread_count_ > 1 && decryptor.GetDataSize() > utils::kParallelDecryptBatchSize)
+        {
+            // Segments are independent: decrypt batches of them on several threads.
+            return utils::ParallelDecrypt(decryptor, output, input, data_offset, thread_count_)
+                       ? TransformResult::OK
+                       : TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
         }
 
-        { // Finish first segment.
-            size_t bytes_read = input->Read(buffer.data(), kOtherSegmentSize - kFirstSegmentSize);
-            if (bytes_read == 0)
-            {
-                return TransformResult::OK;
-            }
-
-            ProcessOtherSegment(kFirstSegmentSize, 0, buffer.data(), bytes_read);
-            if (!output->Write(buffer.data(), bytes_read))
-            {
-                return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
-            }
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor.DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
+            });
+
+        return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+    }
+
+    TransformResult Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len) override
+    {
+        if (thread_count_ <= 1 || input_len <= utils::kParallelDecryptBatchSize)
+        {
+            return ITransformer::Transform(output, output_len, input, input_len);
         }
 
-        for (uint32_t segment_id = 1; true; segment_id++)
+        if (output == nullptr || output_len < input_len)
         {
-            size_t bytes_read = input->Read(buffer.data(), kOtherSegmentSize);
-            if (bytes_read == 0)
-            {
-                return TransformResult::OK;
-            }
-
-            ProcessOtherSegment(0, segment_id, buffer.data(), bytes_read);
-            if (!output->Write(buffer.data(), bytes_read))
-            {
-                return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
-            }
+            output_len = input_len;
+            return TransformResult::ERROR_INSUFFICIENT_OUTPUT;
         }
 
+        QMC2RC4RandomAccessDecryptor decryptor{schedule_, 0, input_len};
+        output_len = input_len;
+        return utils::ParallelDecrypt(decryptor, output, input, thread_count_) ? TransformResult::OK
+                                                                               : TransformResult::ERROR_INVALID_KEY;
+    }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        const auto data_offset = input->GetOffset();
+        decryptor =
+            std::make_unique<QMC2RC4RandomAccessDecryptor>(schedule_, data_offset, input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
         return TransformResult::OK;
     }
 };
 
 std::unique_ptr<ITransformer> CreateQMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len)
 {
-    return std::make_unique<QMC2RC4DecryptionTransformer>(key, key_len);
+    return CreateQMC2RC4DecryptionTransformer(key, key_len, 1);
+}
+
+std::unique_ptr<ITransformer> CreateQMC2RC4DecryptionTransformer(const uint8_t *key, size_t key_len,
+                                                                 size_t thread_count)
+{
+    if (key_len == 0)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<QMC2RC4DecryptionTransformer>(
+        key, key_len, thread_count != 0 ? thread_count : utils::GetDefaultThreadCount());
 }
 
 } // namespace parakeet_crypto::transformer
@@ -1,10 +1,13 @@
 #include "parakeet-crypto/IStream.h"
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
 #include "parakeet-crypto/transformer/qmc.h"
 
 #include "qmc2_keys.test.hh"
 
+#include "test/make_sequence.test.hh"
 #include "test/read_fixture.test.hh"
+#include "test/test_decryption.test.hh"
 
 #include <cstdio>
 #include <fstream>
@@ -43,4 +46,97 @@ TEST(QMC2_RC4, BasicKeyEncV2Decryption)
     ASSERT_THAT(decrypted, ContainerEq(plain_file));
 }
 
+TEST(QMC2_RC4, RejectsEmptyKey)
+{
+    ASSERT_EQ(transformer::CreateQMC2RC4DecryptionTransformer(nullptr, 0), nullptr);
+    ASSERT_EQ(transformer::CreateQMC2RC4DecryptionTransformer(nullptr, 0, 4), nullptr);
+}
+
+TEST(QMC2_RC4, RandomAccess)
+{
+    auto transformer = test::CreateQMC2TestTransformer();
+    test::should_random_access_decrypt_to_fixture("test_qmc2_rc4.mgg", transformer);
+    test::should_random_access_decrypt_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+}
+
+TEST(QMC2_RC4, BufferTransform)
+{
+    auto transformer = test::CreateQMC2TestTransformer();
+    test::should_buffer_transform_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+}
+
+TEST(QMC2_RC4, StreamingDecryptionWithKey)
+{
+    auto plain_file = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto fixture_encrypted = test::read_fixture("test_qmc2_rc4.mgg");
+
+    // Key is supplied out of band: take it from the footer, and only stream the audio data.
+    auto key_crypto = qmc2::CreateKeyCrypto(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
+    auto footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
+    InputMemoryStream reader{fixture_encrypted};
+    auto footer = footer_parser->Parse(reader);
+    ASSERT_EQ(footer->state, qmc2::FooterParseState::OK);
+    fixture_encrypted.resize(fixture_encrypted.size() - footer->footer_size);
+
+    auto transformer = transformer::CreateQMC2RC4DecryptionTransformer(footer->key);
+    test::should_stream_decrypt_to(fixture_encrypted, plain_file, transformer);
+}
+
+TEST(QMC2_RC4, StreamingDecryptionDetectsFooter)
+{
+    auto plain_file = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto fixture_encrypted = test::read_fixture("test_qmc2_rc4.mgg");
+
+    auto key_crypto = qmc2::CreateKeyCrypto(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
+    std::shared_ptr<qmc2::QMCFooterParser> footer_parser = qmc2::CreateQMC2FooterParser(std::move(key_crypto));
+    InputMemoryStream reader{fixture_encrypted};
+    auto footer = footer_parser->Parse(reader);
+    ASSERT_EQ(footer->state, qmc2::FooterParseState::OK);
+
+    // Without a key, the whole file would be needed before decrypting.
+    std::unique_ptr<IStreamingDecryptor> decryptor{};
+    ASSERT_EQ(transformer::CreateQMC2DecryptionTransformer(footer_parser)->CreateStreamingDecryptor(decryptor),
+              TransformResult::ERROR_NOT_IMPLEMENTED);
+
+    // With the key supplied, the footer is held back and trimmed at the end of the stream.
+    auto transformer =
+        transformer::CreateQMC2DecryptionTransformer(footer_parser, footer->key.data(), footer->key.size());
+    test::should_stream_decrypt_to(fixture_encrypted, plain_file, transformer);
+}
+
+TEST(QMC2_RC4, KeySuppliedTrimsFooterWithoutDecryptingIt)
+{
+    auto fixture_encrypted = test::read_fixture("test_qmc2_rc4_EncV2.mgg");
+    auto footer_parser = qmc2::CreateQMC2FooterParser(kTestSeed, kTestEncV2Key1.data(), kTestEncV2Key2.data());
+    InputMemoryStream reader{fixture_encrypted};
+    auto footer = footer_parser->Parse(reader);
+    ASSERT_EQ(footer->state, qmc2::FooterParseState::OK);
+
+    // The footer cannot be decrypted with these keys, but it is still found and left out.
+    constexpr std::array<uint8_t, 16> kWrongEncV2Key{};
+    std::shared_ptr<qmc2::QMCFooterParser> wrong_footer_parser =
+        qmc2::CreateQMC2FooterParser(kTestSeed, kWrongEncV2Key.data(), kWrongEncV2Key.data());
+    ASSERT_NE(wrong_footer_parser->Parse(reader)->state, qmc2::FooterParseState::OK);
+
+    auto transformer =
+        transformer::CreateQMC2DecryptionTransformer(wrong_footer_parser, footer->key.data(), footer->key.size());
+    test::should_decrypt_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+    test::should_stream_decrypt_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+}
+
+TEST(QMC2_RC4, MultiThreadedDecryption)
+{
+    const auto key = test::make_sequence(512, 11);
+    auto single_thread = transformer::CreateQMC2RC4DecryptionTransformer(key);
+    auto multi_thread = transformer::CreateQMC2RC4DecryptionTransformer(key.data(), key.size(), 4);
+    test::should_decrypt_in_parallel_like(single_thread, multi_thread);
+}
+
+TEST(QMC2_RC4, ReusedAcrossThreads)
+{
+    auto transformer = test::CreateQMC2TestTransformer();
+    test::should_decrypt_concurrently_to_fixture("test_qmc2_rc4_EncV2.mgg", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
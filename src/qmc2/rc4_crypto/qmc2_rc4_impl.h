@@ -1,70 +1,152 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::qmc2_rc4
 {
 
-class RC4
+// Key length unknown at compile time.
+constexpr size_t kDynamicStateSize = 0;
+
+// Keys decrypted from an ekey are at most ~1KiB: longer keys keep their state on the heap.
+constexpr size_t kInlineStateCapacity = 0x400;
+
+/**
+ * @brief RC4 as used by QMC2: the state is as long as the key (not 256 bytes), and holds `uint8_t` values.
+ *
+ * The state lives in a fixed-capacity inline buffer. Indices wrap without a division: every sum is below twice
+ * the state size, so a single conditional subtraction (or a mask, for a power of two) is enough.
+ *
+ * @tparam kStateSize Key length, when known at compile time (see `GenerateKeystream`);
+ *                    `kDynamicStateSize` for any key length.
+ */
+template <size_t kStateSize = kDynamicStateSize> class RC4
 {
+  private:
+    static constexpr bool kIsDynamic = kStateSize == kDynamicStateSize;
+    static constexpr size_t kInlineCapacity = kIsDynamic ? kInlineStateCapacity : kStateSize;
+
+    std::array<uint8_t, kInlineCapacity> inline_state_{};
+    std::vector<uint8_t> heap_state_{}; // only for dynamic keys longer than `kInlineStateCapacity`
+    uint8_t *s_{inline_state_.data()};
+    size_t len_{kStateSize};
+    size_t i_{0};
+    size_t j_{0};
+
+    [[nodiscard]] inline size_t GetLength() const
+    {
+        if constexpr (kIsDynamic)
+        {
+            return len_;
+        }
+        else
+        {
+            return kStateSize;
+        }
+    }
+
+    // `value` must be below `2 * GetLength()`.
+    [[nodiscard]] inline size_t Wrap(size_t value) const
+    {
+        if constexpr (!kIsDynamic && (kStateSize & (kStateSize - 1)) == 0)
+        {
+            return value & (kStateSize - 1);
+        }
+        else
+        {
+            return value >= GetLength() ? value - GetLength() : value;
+        }
+    }
+
+    inline void MoveStateForward()
+    {
+        i_ = Wrap(i_ + 1);
+        j_ = Wrap(j_ + s_[i_]);
+        std::swap(s_[i_], s_[j_]);
+    }
+
   public:
     /**
-     * @brief Create RC4 State from key
-     *
-     * @param key
-     * @param key_len
-     * @return std::vector<uint8_t> Initialized RC4 state.
+     * @param key_len Must equal `kStateSize` unless dynamic.
      */
-    static std::vector<uint8_t> CreateStateFromKey(const uint8_t *key, size_t key_len)
+    RC4(const uint8_t *key, size_t key_len) : len_(key_len)
     {
-        std::vector<uint8_t> s(key_len, 0); // NOLINT(readability-identifier-length)
+        if constexpr (kIsDynamic)
+        {
+            if (key_len > kInlineCapacity)
+            {
+                heap_state_.resize(key_len);
+                s_ = heap_state_.data();
+            }
+        }
 
-        for (size_t i = 0; i < key_len; i++)
+        const auto len = GetLength();
+        for (size_t i = 0; i < len; i++)
         {
-            s[i] = static_cast<uint8_t>(i);
+            s_[i] = static_cast<uint8_t>(i);
         }
 
+        // `j + s[i] + key[i]` can exceed twice a short key length: subtract until it wraps.
         size_t j = 0; // NOLINT(readability-identifier-length)
-        for (size_t i = 0; i < key_len; i++)
+        for (size_t i = 0; i < len; i++)
         {
-            j = (size_t{j} + size_t{s[i]} + size_t{key[i % key_len]}) % key_len;
-            std::swap(s[i], s[j]);
+            j = j + size_t{s_[i]} + size_t{key[i]};
+            while (j >= len)
+            {
+                j -= len;
+            }
+            std::swap(s_[i], s_[j]);
         }
-
-        return s;
     }
 
-  private:
-    // probably with a size of 512
-    std::vector<uint8_t> s_{};
-    uint16_t i_{0};
-    uint16_t j_{0};
+    RC4(const RC4 &) = delete;
+    RC4(RC4 &&) = delete;
+    RC4 &operator=(const RC4 &) = delete;
+    RC4 &operator=(RC4 &&) = delete;
+    ~RC4() = default;
 
-    inline void MoveStateForward()
+    inline uint8_t Next()
     {
-        auto len = s_.size();
-        i_ = (i_ + 1) % len;
-        j_ = (j_ + s_[i_]) % len;
-        std::swap(s_[i_], s_[j_]);
+        MoveStateForward();
+        return s_[Wrap(size_t{s_[i_]} + size_t{s_[j_]})];
     }
 
-  public:
-    RC4(std::vector<uint8_t> state, uint32_t discard) : s_(std::move(state))
+    inline void Discard(size_t len)
     {
-        for (uint32_t i = 0; i < discard; i++)
+        for (size_t i = 0; i < len; i++)
         {
             MoveStateForward();
         }
     }
 
-    uint8_t Next()
+    inline void Generate(uint8_t *output, size_t len)
     {
-        MoveStateForward();
-        auto index = (s_[i_] + s_[j_]) % s_.size();
-        return s_[index];
+        for (size_t i = 0; i < len; i++)
+        {
+            output[i] = Next();
+        }
     }
 };
 
+/**
+ * @brief Generate the first `len` bytes of keystream, with an engine specialized for the key length when it is a
+ *        common one (512 bytes, e.g. most QQ Music and Kuwo keys).
+ */
+inline void GenerateKeystream(const uint8_t *key, size_t key_len, uint8_t *output, size_t len)
+{
+    constexpr size_t kCommonKeyLen = 512;
+    if (key_len == kCommonKeyLen)
+    {
+        RC4<kCommonKeyLen>{key, key_len}.Generate(output, len);
+    }
+    else
+    {
+        RC4<>{key, key_len}.Generate(output, len);
+    }
+}
+
 } // namespace parakeet_crypto::qmc2_rc4
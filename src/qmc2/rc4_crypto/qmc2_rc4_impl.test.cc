@@ -0,0 +1,65 @@
+#include "qmc2_rc4_impl.h"
+#include "qmc2_rc4_reference.test.hh"
+
+#include "test/make_sequence.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto::qmc2_rc4;
+using parakeet_crypto::test::make_sequence;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+std::vector<uint8_t> ReferenceKeystream(const std::vector<uint8_t> &key, size_t len)
+{
+    test::ReferenceRC4 rc4{test::ReferenceRC4::CreateStateFromKey(key.data(), key.size()), 0};
+    std::vector<uint8_t> result(len);
+    for (auto &value : result)
+    {
+        value = rc4.Next();
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(QMC2_RC4, MatchesReference)
+{
+    constexpr size_t kKeystreamLen = 0x2000;
+    for (size_t key_len : {1, 7, 128, 255, 256, 300, 384, 511, 512, 513, 704, 1024, 1025, 3000})
+    {
+        auto key = make_sequence(key_len, 11);
+        auto expected = ReferenceKeystream(key, kKeystreamLen);
+
+        std::vector<uint8_t> actual(kKeystreamLen);
+        GenerateKeystream(key.data(), key.size(), actual.data(), actual.size());
+        ASSERT_THAT(actual, ContainerEq(expected)) << "key_len " << key_len;
+
+        RC4<> generic{key.data(), key.size()};
+        generic.Generate(actual.data(), actual.size());
+        ASSERT_THAT(actual, ContainerEq(expected)) << "key_len " << key_len << " (generic)";
+    }
+}
+
+TEST(QMC2_RC4, Discard)
+{
+    auto key = make_sequence(512, 11);
+    auto expected = ReferenceKeystream(key, 1000);
+
+    RC4<512> rc4{key.data(), key.size()};
+    rc4.Discard(300);
+    std::vector<uint8_t> actual(700);
+    rc4.Generate(actual.data(), actual.size());
+    ASSERT_THAT(actual, ContainerEq(std::vector<uint8_t>(expected.begin() + 300, expected.end())));
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
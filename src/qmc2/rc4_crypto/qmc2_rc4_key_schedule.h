@@ -0,0 +1,104 @@
+#pragma once
+
+#include "qmc2_rc4_impl.h"
+#include "qmc2_segment.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parakeet_crypto::qmc2_rc4
+{
+
+constexpr size_t kFirstSegmentSize{0x0080};
+constexpr size_t kOtherSegmentSize{0x1400};
+static_assert(kOtherSegmentSize >= kFirstSegmentSize);
+
+// 511: equivalent to "% 512". QM had this value hardcoded.
+constexpr size_t kKeyIndexMask = 0x1FF;
+
+// Segments with a precomputed initial discard: the first 5MiB, enough for previews.
+constexpr size_t kPrecomputedSegmentCount = 0x400;
+
+/**
+ * @brief Everything derived from a QMC2 RC4 key, computed once per key and immutable afterwards.
+ *
+ * Every segment restarts RC4 from the same initial state, and only skips a different number of bytes
+ * (at most `kKeyIndexMask`): the keystream of each segment is a window of a single base keystream.
+ * The first `kFirstSegmentSize` bytes use a key mask instead, also precomputed.
+ */
+class KeySchedule
+{
+  private:
+    std::vector<uint8_t> key_{};
+    // Seeds of the segments, `key_` zero-padded to `kKeyIndexMask + 1` bytes: keys shorter than that are not read
+    //   past their end.
+    std::array<uint8_t, kKeyIndexMask + 1> segment_seeds_{};
+    SegmentKeyImpl segment_key_;
+    std::vector<uint8_t> keystream_{};
+    std::array<uint8_t, kFirstSegmentSize> first_segment_mask_{};
+    std::array<uint16_t, kPrecomputedSegmentCount> segment_discards_{};
+
+    [[nodiscard]] size_t ComputeSegmentDiscard(uint32_t segment_id) const
+    {
+        auto seed = segment_seeds_[segment_id & kKeyIndexMask];
+        return segment_key_.GetKey(segment_id, seed) & kKeyIndexMask;
+    }
+
+  public:
+    /**
+     * @param key_len Must not be `0`.
+     */
+    KeySchedule(const uint8_t *key, size_t key_len) : key_(key, key + key_len), segment_key_(key, key_len)
+    {
+        std::copy_n(key, std::min(key_len, segment_seeds_.size()), segment_seeds_.begin());
+        keystream_.resize(kKeyIndexMask + kOtherSegmentSize);
+        GenerateKeystream(key, key_len, keystream_.data(), keystream_.size());
+
+        // Same float math as before, done once: the truncation of `GetKey` is kept as is.
+        for (size_t i = 0; i < kFirstSegmentSize; i++)
+        {
+            auto seed = key_[i % key_len];
+            first_segment_mask_[i] = key_[segment_key_.GetKey(i, seed) % key_len];
+        }
+        for (size_t i = 0; i < kPrecomputedSegmentCount; i++)
+        {
+            segment_discards_[i] = static_cast<uint16_t>(ComputeSegmentDiscard(static_cast<uint32_t>(i)));
+        }
+    }
+
+    [[nodiscard]] const std::vector<uint8_t> &GetKey() const
+    {
+        return key_;
+    }
+
+    [[nodiscard]] const SegmentKeyImpl &GetSegmentKey() const
+    {
+        return segment_key_;
+    }
+
+    /**
+     * @brief Keystream of a segment (other than the first `kFirstSegmentSize` bytes of the file).
+     *
+     * @param segment_id Index of the segment, `offset / kOtherSegmentSize`.
+     * @return const uint8_t* Keystream for the `kOtherSegmentSize` bytes of the segment.
+     */
+    [[nodiscard]] const uint8_t *GetSegmentKeystream(uint32_t segment_id) const
+    {
+        auto initial_discard = segment_id < kPrecomputedSegmentCount ? size_t{segment_discards_[segment_id]}
+                                                                     : ComputeSegmentDiscard(segment_id);
+        return &keystream_[initial_discard];
+    }
+
+    /**
+     * @brief Key mask of the first `kFirstSegmentSize` bytes of the file.
+     */
+    [[nodiscard]] const uint8_t *GetFirstSegmentMask() const
+    {
+        return first_segment_mask_.data();
+    }
+};
+
+} // namespace parakeet_crypto::qmc2_rc4
@@ -0,0 +1,83 @@
+#include "qmc2_rc4_key_schedule.h"
+#include "qmc2_rc4_reference.test.hh"
+#include "qmc2_segment.h"
+
+#include "test/make_sequence.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto::qmc2_rc4;
+using parakeet_crypto::test::make_sequence;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+TEST(QMC2_RC4_KeySchedule, SegmentKeystreamMatchesRC4)
+{
+    const auto key = make_sequence(512, 11);
+
+    KeySchedule schedule{key.data(), key.size()};
+    SegmentKeyImpl segment_key{key.data(), key.size()};
+    auto rc4_state = test::ReferenceRC4::CreateStateFromKey(key.data(), key.size());
+    for (uint32_t segment_id : {0U, 1U, 2U, 99U, 511U, 512U, 1023U, 1024U, 40000U})
+    {
+        auto seed = key[segment_id & kKeyIndexMask];
+        auto discard = static_cast<uint32_t>(segment_key.GetKey(segment_id, seed) & kKeyIndexMask);
+        test::ReferenceRC4 rc4{rc4_state, discard};
+        std::vector<uint8_t> expected(kOtherSegmentSize);
+        for (auto &value : expected)
+        {
+            value = rc4.Next();
+        }
+
+        const auto *keystream = schedule.GetSegmentKeystream(segment_id);
+        ASSERT_THAT(std::vector<uint8_t>(keystream, keystream + kOtherSegmentSize), ContainerEq(expected))
+            << "segment " << segment_id;
+    }
+}
+
+TEST(QMC2_RC4_KeySchedule, ShortKeySegmentKeystream)
+{
+    const auto key = make_sequence(300, 1);
+
+    // Seeds past the end of the key are zero.
+    KeySchedule schedule{key.data(), key.size()};
+    SegmentKeyImpl segment_key{key.data(), key.size()};
+    auto rc4_state = test::ReferenceRC4::CreateStateFromKey(key.data(), key.size());
+    for (uint32_t segment_id : {1U, 299U, 300U, 511U, 1023U, 1024U, 40000U})
+    {
+        auto index = segment_id & kKeyIndexMask;
+        uint8_t seed = index < key.size() ? key[index] : 0;
+        auto discard = static_cast<uint32_t>(segment_key.GetKey(segment_id, seed) & kKeyIndexMask);
+        test::ReferenceRC4 rc4{rc4_state, discard};
+        std::vector<uint8_t> expected(kOtherSegmentSize);
+        for (auto &value : expected)
+        {
+            value = rc4.Next();
+        }
+
+        const auto *keystream = schedule.GetSegmentKeystream(segment_id);
+        ASSERT_THAT(std::vector<uint8_t>(keystream, keystream + kOtherSegmentSize), ContainerEq(expected))
+            << "segment " << segment_id;
+    }
+}
+
+TEST(QMC2_RC4_KeySchedule, FirstSegmentMask)
+{
+    const auto key = make_sequence(300, 1);
+
+    KeySchedule schedule{key.data(), key.size()};
+    SegmentKeyImpl segment_key{key.data(), key.size()};
+    for (size_t i = 0; i < kFirstSegmentSize; i++)
+    {
+        auto seed = key[i % key.size()];
+        ASSERT_EQ(schedule.GetFirstSegmentMask()[i], key[segment_key.GetKey(i, seed) % key.size()]) << "offset " << i;
+    }
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -81,6 +81,49 @@ template <size_t N> inline uint64_t constexpr map_u64(uint64_t src_value, const
     return make_u64(hi32, lo32);
 }
 
+using U64PermutationTable = std::array<std::array<uint64_t, 256>, 8>;
+
+/**
+ * @brief Byte-wise lookup table of `map_u64(value, table)`: every output bit comes from a single input bit, so the
+ *        result is the OR of the mapped bytes of `value`.
+ */
+template <size_t N> inline constexpr U64PermutationTable make_u64_permutation(const std::array<uint8_t, N> &table)
+{
+    static_assert(N % 2 == 0, "N should be even");
+    constexpr size_t N_MID = N / 2;
+
+    U64PermutationTable result{};
+    for (size_t i = 0; i < N; i++)
+    {
+        // Same bit positions as `map_bit`, without its shift by a negative amount for the high word.
+        const uint64_t src_mask = data::kU64ShiftTable[table[i]];
+        const uint64_t dst_mask = data::kU64ShiftTable[i < N_MID ? i : 32 + i - N_MID];
+
+        size_t byte_idx = 0;
+        while ((src_mask >> (8 * byte_idx)) > 0xFF)
+        {
+            byte_idx++;
+        }
+
+        const uint64_t byte_mask = src_mask >> (8 * byte_idx);
+        for (size_t value = 0; value < 256; value++)
+        {
+            if ((value & byte_mask) != 0)
+            {
+                result[byte_idx][value] |= dst_mask;
+            }
+        }
+    }
+    return result;
+}
+
+inline uint64_t map_u64(uint64_t src_value, const U64PermutationTable &table)
+{
+    return table[0][src_value & 0xFF] | table[1][(src_value >> 8) & 0xFF] | table[2][(src_value >> 16) & 0xFF] |
+           table[3][(src_value >> 24) & 0xFF] | table[4][(src_value >> 32) & 0xFF] |
+           table[5][(src_value >> 40) & 0xFF] | table[6][(src_value >> 48) & 0xFF] | table[7][src_value >> 56];
+}
+
 // NOLINTEND (*-magic-numbers)
 
 } // namespace parakeet_crypto::qrc::int_helper
@@ -25,12 +25,16 @@
  */
 
 #include "parakeet-crypto/transformer/qrc.h"
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
 #include "parakeet-crypto/IStream.h"
 #include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
 #include "qrc_des.h"
 #include "utils/buffered_transform.h"
 #include "utils/endian_helper.h"
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -44,29 +48,31 @@ class RawDESTransformer final : public IWriteable
 {
   private:
     static constexpr size_t kDESBlockSize = 8;
-    const qrc::QRC_DES &des1_;
-    const qrc::QRC_DES &des2_;
-    const qrc::QRC_DES &des3_;
+    static constexpr size_t kChunkSize = 4096;
+    const qrc::QRC_TripleDES &des_;
     IWriteable *dest_;
 
     BufferedTransform<kDESBlockSize> buffer_{};
 
   public:
-    RawDESTransformer(IWriteable *dest, const qrc::QRC_DES &des1, const qrc::QRC_DES &des2, const qrc::QRC_DES &des3)
-        : dest_(dest), des1_(des1), des2_(des2), des3_(des3)
+    RawDESTransformer(IWriteable *dest, const qrc::QRC_TripleDES &des) : des_(des), dest_(dest)
     {
     }
 
     [[nodiscard]] bool Write(const uint8_t *buffer, size_t len) override
     {
         bool write_ok{true};
-        std::array<uint8_t, kDESBlockSize> block{};
-        buffer_.ProcessBuffer(buffer, len, [&](const uint8_t *buffer) {
-            std::copy_n(buffer, block.size(), block.begin());
-            des1_.decrypt_block(block.data());
-            des2_.encrypt_block(block.data());
-            des3_.decrypt_block(block.data());
-            write_ok = dest_->Write(block.data(), block.size());
+        std::array<uint8_t, kChunkSize> chunk{};
+        buffer_.ProcessBlocks(buffer, len, [&](const uint8_t *blocks, size_t blocks_len) {
+            while (write_ok && blocks_len > 0)
+            {
+                auto n = std::min(chunk.size(), blocks_len);
+                std::copy_n(blocks, n, chunk.begin());
+                des_.decrypt_blocks(chunk.data(), n / kDESBlockSize);
+                write_ok = dest_->Write(chunk.data(), n);
+                blocks += n;
+                blocks_len -= n;
+            }
             return write_ok;
         });
         return write_ok;
@@ -166,10 +172,14 @@ class ZLibInflate final : public IWriteable
 class QRCTransformer final : public ITransformer
 {
   private:
+    static constexpr size_t kDESBlockSize = 8;
+    static constexpr size_t kBufferTransformChunkSize = 4096;
+    static constexpr std::array<uint8_t, 11> kMagicEncryptedHeader = {
+        0x98, 0x25, 0xB0, 0xAC, 0xE3, 0x02, 0x83, 0x68, 0xE8, 0xFC, 0x6C,
+    };
+
     std::shared_ptr<ITransformer> qmc1_static_transformer_;
-    qrc::QRC_DES des1_;
-    qrc::QRC_DES des2_;
-    qrc::QRC_DES des3_;
+    qrc::QRC_TripleDES des_;
 
   public:
     const char *GetName() override
@@ -179,19 +189,13 @@ class QRCTransformer final : public ITransformer
 
     QRCTransformer(std::shared_ptr<ITransformer> qmc1_static_transformer, const uint8_t *key1, const uint8_t *key2,
                    const uint8_t *key3)
-        : qmc1_static_transformer_(std::move(qmc1_static_transformer))
+        : qmc1_static_transformer_(std::move(qmc1_static_transformer)), des_(key1, key2, key3)
     {
-        des1_.setup_key(key1);
-        des2_.setup_key(key2);
-        des3_.setup_key(key3);
     }
 
     TransformResult Transform(IWriteable *output, IReadSeekable *input) override
     {
-        constexpr std::array<uint8_t, 11> kMagicEncryptedHeader = {
-            0x98, 0x25, 0xB0, 0xAC, 0xE3, 0x02, 0x83, 0x68, 0xE8, 0xFC, 0x6C,
-        };
-
+        const auto header_offset = input->GetOffset();
         std::array<uint8_t, kMagicEncryptedHeader.size()> header{};
         if (!input->ReadExact(header.data(), header.size()))
         {
@@ -203,10 +207,10 @@ class QRCTransformer final : public ITransformer
             return TransformResult::ERROR_INVALID_FORMAT;
         }
 
-        input->Seek(0, SeekDirection::SEEK_FILE_BEGIN);
+        input->Seek(header_offset, SeekDirection::SEEK_FILE_BEGIN);
 
         ZLibInflate zlib(output);
-        RawDESTransformer qrc_des(&zlib, des1_, des2_, des3_);
+        RawDESTransformer qrc_des(&zlib, des_);
         DropHeader<kMagicEncryptedHeader.size()> header_removal(&qrc_des);
 
         auto result = qmc1_static_transformer_->Transform(&header_removal, input);
@@ -219,6 +223,108 @@ class QRCTransformer final : public ITransformer
         }
         return result;
     }
+
+    TransformResult Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len) override
+    {
+        if (input_len < kMagicEncryptedHeader.size())
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        if (!std::equal(kMagicEncryptedHeader.begin(), kMagicEncryptedHeader.end(), input))
+        {
+            return TransformResult::ERROR_INVALID_FORMAT;
+        }
+
+        InputMemoryViewStream input_stream{input, input_len};
+        std::unique_ptr<IRandomAccessDecryptor> qmc1_decryptor{};
+        if (auto result = qmc1_static_transformer_->CreateRandomAccessDecryptor(qmc1_decryptor, &input_stream);
+            result != TransformResult::OK)
+        {
+            return result;
+        }
+
+        z_stream strm{};
+        if (inflateInit(&strm) != Z_OK)
+        {
+            return TransformResult::ERROR_OTHER; // zlib init failed
+        }
+        auto result = InflateToBuffer(strm, output, output_len, input, input_len, *qmc1_decryptor);
+        inflateEnd(&strm);
+        return result;
+    }
+
+  private:
+    /**
+     * @brief Inflate the decrypted payload straight into `output`; once it is full, keep inflating into a scratch
+     *        buffer to count the required size.
+     */
+    TransformResult InflateToBuffer(z_stream &strm, uint8_t *output, size_t &output_len, const uint8_t *input,
+                                    size_t input_len, const IRandomAccessDecryptor &qmc1_decryptor) const
+    {
+        const size_t capacity = output == nullptr ? 0 : output_len;
+        std::array<uint8_t, kBufferTransformChunkSize> chunk{};
+        std::array<uint8_t, kBufferTransformChunkSize> scratch{};
+        size_t total_out{0};
+
+        auto inflate_chunk = [&](size_t len, int flush) {
+            strm.next_in = chunk.data();
+            strm.avail_in = static_cast<uInt>(len);
+
+            int err{};
+            do // NOLINT(*-avoid-do-while)
+            {
+                uint8_t *next_out = scratch.data();
+                size_t avail_out = scratch.size();
+                if (total_out < capacity)
+                {
+                    next_out = &output[total_out];
+                    avail_out = std::min(capacity - total_out, size_t{UINT32_MAX});
+                }
+
+                strm.next_out = next_out;
+                strm.avail_out = static_cast<uInt>(avail_out);
+                err = inflate(&strm, flush);
+                total_out += avail_out - strm.avail_out;
+            } while (err == Z_OK && strm.avail_out == 0);
+
+            return err;
+        };
+
+        // QMC1, drop the header, then 3-DES; trailing bytes not filling a DES block are ignored.
+        constexpr size_t kHeaderSize = kMagicEncryptedHeader.size();
+        const size_t payload_end = kHeaderSize + (input_len - kHeaderSize) / kDESBlockSize * kDESBlockSize;
+        int err{Z_OK};
+        for (size_t offset = kHeaderSize; offset < payload_end && err == Z_OK;)
+        {
+            auto len = std::min(chunk.size(), payload_end - offset);
+            std::copy_n(&input[offset], len, chunk.begin());
+            if (!qmc1_decryptor.DecryptAt(offset, chunk.data(), len))
+            {
+                return TransformResult::ERROR_INVALID_KEY;
+            }
+            des_.decrypt_blocks(chunk.data(), len / kDESBlockSize);
+
+            err = inflate_chunk(len, Z_NO_FLUSH);
+            if (err == Z_BUF_ERROR)
+            {
+                err = Z_OK; // no progress possible with this chunk, e.g. empty.
+            }
+            offset += len;
+        }
+
+        if (err == Z_OK)
+        {
+            err = inflate_chunk(0, Z_FINISH);
+        }
+        if (err != Z_STREAM_END)
+        {
+            return TransformResult::ERROR_IO_OUTPUT_UNKNOWN; // zlib inflate error?
+        }
+
+        auto result = total_out > capacity ? TransformResult::ERROR_INSUFFICIENT_OUTPUT : TransformResult::OK;
+        output_len = total_out;
+        return result;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateQRCLyricsDecryptionTransformer(
@@ -0,0 +1,149 @@
+#include "parakeet-crypto/transformer/qrc.h"
+#include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/transformer/qmc.h"
+#include "qrc_des.h"
+
+#include "test/test_decryption.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+constexpr std::array<uint8_t, 8> kTestKey1{'T', 'E', 'S', 'T', '!', 'K', 'Y', '1'};
+constexpr std::array<uint8_t, 8> kTestKey2{'T', 'E', 'S', 'T', '!', 'K', 'Y', '2'};
+constexpr std::array<uint8_t, 8> kTestKey3{'T', 'E', 'S', 'T', '!', 'K', 'Y', '3'};
+
+constexpr std::array<uint8_t, 11> kMagicEncryptedHeader{0x98, 0x25, 0xB0, 0xAC, 0xE3, 0x02,
+                                                        0x83, 0x68, 0xE8, 0xFC, 0x6C};
+constexpr std::array<uint8_t, 11> kMagicDecryptedHeader{'[', 'o', 'f', 'f', 's', 'e', 't', ':', '0', ']', '\n'};
+
+// QMC1 key that turns the decrypted header back into the magic header.
+std::vector<uint8_t> GetTestQMC1Key()
+{
+    std::vector<uint8_t> key(128);
+    for (size_t i = 0; i < key.size(); i++)
+    {
+        key[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    for (size_t i = 0; i < kMagicEncryptedHeader.size(); i++)
+    {
+        key[i] = kMagicEncryptedHeader[i] ^ kMagicDecryptedHeader[i];
+    }
+    return key;
+}
+
+std::unique_ptr<ITransformer> CreateTestQRCTransformer()
+{
+    return transformer::CreateQRCLyricsDecryptionTransformer(
+        transformer::CreateQMC1StaticDecryptionTransformer(GetTestQMC1Key()), kTestKey1.data(), kTestKey2.data(),
+        kTestKey3.data());
+}
+
+// zlib stream made of "stored" (uncompressed) deflate blocks.
+std::vector<uint8_t> ZLibStore(const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> result{0x78, 0x01};
+    const auto len = static_cast<uint16_t>(data.size());
+    const auto nlen = static_cast<uint16_t>(~len);
+    result.insert(result.end(), {0x01, static_cast<uint8_t>(len), static_cast<uint8_t>(len >> 8),
+                                 static_cast<uint8_t>(nlen), static_cast<uint8_t>(nlen >> 8)});
+    result.insert(result.end(), data.begin(), data.end());
+
+    uint32_t adler_a{1};
+    uint32_t adler_b{0};
+    for (auto value : data)
+    {
+        adler_a = (adler_a + value) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    auto adler = (adler_b << 16) | adler_a;
+    result.insert(result.end(), {static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+                                 static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)});
+    return result;
+}
+
+// Reverse of the QRC decryption: zlib, 3-DES, then QMC1 over the header and payload.
+std::vector<uint8_t> EncryptTestQRC(const std::vector<uint8_t> &plain)
+{
+    auto payload = ZLibStore(plain);
+    payload.resize((payload.size() + 7) / 8 * 8, 0);
+
+    qrc::QRC_DES des1(reinterpret_cast<const char *>(kTestKey1.data())); // NOLINT(*-reinterpret-cast)
+    qrc::QRC_DES des2(reinterpret_cast<const char *>(kTestKey2.data())); // NOLINT(*-reinterpret-cast)
+    qrc::QRC_DES des3(reinterpret_cast<const char *>(kTestKey3.data())); // NOLINT(*-reinterpret-cast)
+    for (size_t i = 0; i < payload.size(); i += 8)
+    {
+        des3.encrypt_block(&payload[i]);
+        des2.decrypt_block(&payload[i]);
+        des1.encrypt_block(&payload[i]);
+    }
+
+    std::vector<uint8_t> encrypted(kMagicDecryptedHeader.begin(), kMagicDecryptedHeader.end());
+    encrypted.insert(encrypted.end(), payload.begin(), payload.end());
+
+    auto qmc1 = transformer::CreateQMC1StaticDecryptionTransformer(GetTestQMC1Key());
+    auto [state, result] = test::transform_vector(encrypted, qmc1);
+    EXPECT_EQ(state, TransformResult::OK);
+    return result;
+}
+
+std::vector<uint8_t> GetTestLyrics()
+{
+    std::string lyrics{};
+    for (int i = 0; i < 200; i++)
+    {
+        lyrics += "[" + std::to_string(i * 1000) + ",1000]line " + std::to_string(i) + "\n";
+    }
+    return {lyrics.begin(), lyrics.end()};
+}
+
+} // namespace
+
+TEST(QRC, StreamTransform)
+{
+    auto lyrics = GetTestLyrics();
+    auto encrypted = EncryptTestQRC(lyrics);
+    ASSERT_TRUE(std::equal(kMagicEncryptedHeader.begin(), kMagicEncryptedHeader.end(), encrypted.begin()));
+
+    auto transformer = CreateTestQRCTransformer();
+    auto [state, decrypted] = test::transform_vector(encrypted, transformer);
+    ASSERT_EQ(state, TransformResult::OK);
+    ASSERT_THAT(decrypted, ContainerEq(lyrics));
+}
+
+TEST(QRC, BufferTransform)
+{
+    auto lyrics = GetTestLyrics();
+    auto encrypted = EncryptTestQRC(lyrics);
+
+    auto transformer = CreateTestQRCTransformer();
+    test::should_buffer_transform_to(encrypted, lyrics, transformer);
+}
+
+TEST(QRC, BufferTransformInvalidHeader)
+{
+    auto encrypted = EncryptTestQRC(GetTestLyrics());
+    encrypted[0] ^= 0xff;
+
+    auto transformer = CreateTestQRCTransformer();
+    size_t output_len{0};
+    ASSERT_EQ(transformer->Transform(nullptr, output_len, encrypted.data(), encrypted.size()),
+              TransformResult::ERROR_INVALID_FORMAT);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -5,55 +5,132 @@
 
 #include "utils/endian_helper.h"
 #include <algorithm>
-#include <cassert>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <numeric>
+#include <utility>
 
 namespace parakeet_crypto::qrc
 {
 
-inline uint64_t sbox_transform(uint64_t state)
+namespace
 {
-    constexpr std::array<uint8_t, 8> kLargeStateShifts = {26, 20, 14, 8, 58, 52, 46, 40};
-    constexpr uint8_t kMaskSelectLast6Bit = 0b111111;
-
-    auto large_state_it = kLargeStateShifts.cbegin(); // NOLINT(readability-qualified-auto)
-    return std::accumulate(data::kSBoxes.cbegin(), data::kSBoxes.cend(), uint32_t{0},
-                           [&](const auto &next, const auto &sbox) {
-                               auto sbox_idx = (state >> *large_state_it++) & kMaskSelectLast6Bit;
-                               return (next << 4) | sbox[sbox_idx];
-                           });
+
+// NOLINTBEGIN(*-magic-numbers)
+
+constexpr std::array<uint8_t, 8> kLargeStateShifts = {26, 20, 14, 8, 58, 52, 46, 40};
+constexpr uint8_t kMaskSelectLast6Bit = 0b111111;
+
+constexpr auto kIpPermutation = int_helper::make_u64_permutation(data::kIpTable);
+constexpr auto kIpInvPermutation = int_helper::make_u64_permutation(data::kIpInvTable);
+
+using SPBoxes = std::array<std::array<uint32_t, 64>, 8>;
+
+// `kSPBoxes[k][x]`: output of S-box `k` for the input `x`, moved to its nibble, then through the P-box.
+constexpr SPBoxes kSPBoxes = ([] {
+    SPBoxes result{};
+    for (size_t k = 0; k < result.size(); k++)
+    {
+        for (size_t x = 0; x < result[k].size(); x++)
+        {
+            const uint32_t nibbles = uint32_t{data::kSBoxes[k][x]} << (28 - 4 * k);
+            for (size_t i = 0; i < data::kPBox.size(); i++)
+            {
+                if ((nibbles & (uint32_t{1} << (31 - data::kPBox[i]))) != 0)
+                {
+                    result[k][x] |= uint32_t{1} << (31 - i);
+                }
+            }
+        }
+    }
+    return result;
+})();
+
+inline uint32_t rotate_left(uint32_t value, uint32_t n)
+{
+    return (value << n) | (value >> ((32 - n) & 31));
 }
 
-inline uint64_t des_crypt_proc(uint64_t state, uint64_t key)
+inline uint64_t des_crypt_proc(uint64_t state, const QRC_DES_RoundKey &key)
 {
-    // Expansion Permutation
     auto state_hi32 = int_helper::u64_get_hi32(state);
     auto state_lo32 = int_helper::u64_get_lo32(state);
 
-    state = int_helper::map_u64(int_helper::make_u64(state_hi32, state_hi32), data::kKeyExpansionTable);
-    state ^= key;
-
-    auto next_lo32 = sbox_transform(state);
-    next_lo32 = int_helper::map_u32_bits(next_lo32, data::kPBox);
+    // Expansion Permutation: S-box `k` reads 6 bits, starting from the one before its nibble. Rotated right by one,
+    //   the inputs of the even S-boxes sit at bits 31..26, 23..18, 15..10 and 7..2; rotated left by 4 more, the ones
+    //   of the odd S-boxes.
+    auto even = rotate_left(state_hi32, 31) ^ key[0];
+    auto odd = rotate_left(state_hi32, 3) ^ key[1];
+    auto next_lo32 = kSPBoxes[0][even >> 26] ^ kSPBoxes[2][(even >> 18) & 0x3F] ^ kSPBoxes[4][(even >> 10) & 0x3F] ^
+                     kSPBoxes[6][(even >> 2) & 0x3F] ^ kSPBoxes[1][odd >> 26] ^ kSPBoxes[3][(odd >> 18) & 0x3F] ^
+                     kSPBoxes[5][(odd >> 10) & 0x3F] ^ kSPBoxes[7][(odd >> 2) & 0x3F];
     next_lo32 ^= state_lo32;
 
     // make u64, then swap
     //   => make reverted u64
-    // return swap_u64_side(int_helper::make_u64(state_hi32, next_lo32));
     return int_helper::make_u64(next_lo32, state_hi32); // NOLINT(readability-suspicious-call-argument)
 }
 
-inline constexpr uint64_t IP(uint64_t data)
+inline uint64_t IP(uint64_t data)
 {
-    return int_helper::map_u64(data, data::kIpTable);
+    return int_helper::map_u64(data, kIpPermutation);
 }
 
-inline constexpr uint64_t IPInv(uint64_t state)
+inline uint64_t IPInv(uint64_t state)
 {
-    return int_helper::map_u64(state, data::kIpInvTable);
+    return int_helper::map_u64(state, kIpInvPermutation);
 }
 
+struct DESPass
+{
+    const QRC_DES_Subkeys *subkeys;
+    bool is_decrypt;
+};
+
+// Several blocks are encrypted together, round by round: each DES round waits on the S-box lookups of the previous
+//   round of the same block, so interleaving the Feistel rounds of independent blocks hides that load latency.
+//   `kLane` indexes the blocks; each state is a separate 64-bit value the compiler can keep in a register.
+template <size_t kPasses, size_t... kLane>
+inline void des_crypt_lanes(uint8_t *blocks, const std::array<DESPass, kPasses> &passes, std::index_sequence<kLane...>)
+{
+    std::array<uint64_t, sizeof...(kLane)> state{IP(ReadLittleEndian<uint64_t>(&blocks[kLane * 8]))...};
+
+    for (const auto &pass : passes)
+    {
+        const auto &subkeys = *pass.subkeys;
+        const size_t rounds = subkeys.size();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            const auto &key = subkeys[pass.is_decrypt ? rounds - 1 - round : round];
+            ((state[kLane] = des_crypt_proc(state[kLane], key)), ...);
+        }
+
+        // Swap data hi32/lo32; the final permutation would cancel the initial one of the next pass.
+        ((state[kLane] = int_helper::swap_u64_side(state[kLane])), ...);
+    }
+
+    (WriteLittleEndian(&blocks[kLane * 8], IPInv(state[kLane])), ...);
+}
+
+template <size_t kPasses>
+inline void crypt_blocks(uint8_t *blocks, size_t n_blocks, const std::array<DESPass, kPasses> &passes)
+{
+    constexpr size_t kLanes = 4;
+    for (; n_blocks >= kLanes; n_blocks -= kLanes, blocks += kLanes * 8)
+    {
+        des_crypt_lanes(blocks, passes, std::make_index_sequence<kLanes>{});
+    }
+    for (; n_blocks > 0; n_blocks--, blocks += 8)
+    {
+        des_crypt_lanes(blocks, passes, std::index_sequence<0>{});
+    }
+}
+
+// NOLINTEND(*-magic-numbers)
+
+} // namespace
+
 void QRC_DES::setup_key(const char *key_str)
 {
     auto key = parakeet_crypto::ReadLittleEndian<uint64_t>(key_str);
@@ -75,7 +152,16 @@ void QRC_DES::setup_key(const char *key_str)
         update_param(param_d, shift_left);
 
         auto key = int_helper::make_u64(param_d, param_c);
-        *subkey_it++ = int_helper::map_u64(key, data::kKeyCompressionTable);
+        auto subkey = int_helper::map_u64(key, data::kKeyCompressionTable);
+
+        // Split into the inputs of each S-box.
+        auto &round_key = *subkey_it++;
+        round_key = {};
+        for (size_t i = 0; i < kLargeStateShifts.size(); i++)
+        {
+            auto sbox_input = static_cast<uint32_t>((subkey >> kLargeStateShifts[i]) & kMaskSelectLast6Bit);
+            round_key[i % 2] |= sbox_input << (26 - 8 * (i / 2)); // NOLINT(*-magic-numbers)
+        }
     });
 }
 
@@ -102,4 +188,19 @@ uint64_t QRC_DES::des_crypt_block(uint64_t data, bool is_decrypt) const
     return state;
 }
 
+void QRC_DES::des_crypt_blocks(uint8_t *data, size_t n_blocks, bool is_decrypt) const
+{
+    crypt_blocks(data, n_blocks, std::array<DESPass, 1>{{{&subkeys, is_decrypt}}});
+}
+
+void QRC_TripleDES::decrypt_blocks(uint8_t *data, size_t n_blocks) const
+{
+    crypt_blocks(data, n_blocks,
+                 std::array<DESPass, 3>{{
+                     {&des1_.get_subkeys(), true},
+                     {&des2_.get_subkeys(), false},
+                     {&des3_.get_subkeys(), true},
+                 }});
+}
+
 } // namespace parakeet_crypto::qrc
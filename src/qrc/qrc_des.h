@@ -8,13 +8,17 @@ namespace parakeet_crypto::qrc
 {
 
 // NOLINTBEGIN(*-magic-numbers)
-using QRC_DES_Subkeys = std::array<uint64_t, 16>;
+
+// The 48-bit subkey of a round: the 6-bit inputs of the even and the odd S-boxes, one byte apart, lined up with the
+//   expanded state (see `des_crypt_proc`).
+using QRC_DES_RoundKey = std::array<uint32_t, 2>;
+using QRC_DES_Subkeys = std::array<QRC_DES_RoundKey, 16>;
 
 class QRC_DES
 {
   private:
     // 8*16 = 128 byte
-    QRC_DES_Subkeys subkeys{0};
+    QRC_DES_Subkeys subkeys{};
 
   public:
     QRC_DES() = default;
@@ -22,6 +26,10 @@ class QRC_DES
     {
         setup_key(key);
     }
+    QRC_DES(const uint8_t *key)
+    {
+        setup_key(key);
+    }
 
     void setup_key(const char *key_str);
     void setup_key(const uint8_t *key)
@@ -29,6 +37,11 @@ class QRC_DES
         setup_key(reinterpret_cast<const char *>(key)); // NOLINT(*reinterpret-cast)
     }
 
+    [[nodiscard]] const QRC_DES_Subkeys &get_subkeys() const
+    {
+        return subkeys;
+    }
+
     [[nodiscard]] uint64_t des_crypt_block(uint64_t data, bool is_decrypt) const;
     void des_crypt_block(uint8_t *p_block, bool is_decrypt) const
     {
@@ -45,6 +58,12 @@ class QRC_DES
     {
         des_crypt_block(data, true);
     }
+
+    /**
+     * @brief Transform `n_blocks` consecutive 8-byte blocks in place (ECB), several blocks at a time.
+     */
+    void des_crypt_blocks(uint8_t *data, size_t n_blocks, bool is_decrypt) const;
+
     bool des_crypt(uint8_t *data, size_t n, bool is_decrypt) const
     {
         if (n % 8 != 0)
@@ -52,12 +71,7 @@ class QRC_DES
             return false;
         }
 
-        while (n > 0)
-        {
-            des_crypt_block(data, is_decrypt);
-            data += 8;
-            n -= 8;
-        }
+        des_crypt_blocks(data, n / 8, is_decrypt);
         return true;
     }
 
@@ -71,6 +85,33 @@ class QRC_DES
         return des_crypt(data, n, true);
     }
 };
+
+/**
+ * @brief The 3-DES of QRC lyrics: decrypt with `key1`, encrypt with `key2`, then decrypt with `key3`.
+ *        The final permutation of a pass cancels the initial permutation of the next one, so that both are only
+ *        applied once per block.
+ */
+class QRC_TripleDES
+{
+  private:
+    QRC_DES des1_;
+    QRC_DES des2_;
+    QRC_DES des3_;
+
+  public:
+    QRC_TripleDES(const uint8_t *key1, const uint8_t *key2, const uint8_t *key3)
+    {
+        des1_.setup_key(key1);
+        des2_.setup_key(key2);
+        des3_.setup_key(key3);
+    }
+
+    /**
+     * @brief Decrypt `n_blocks` consecutive 8-byte blocks in place.
+     */
+    void decrypt_blocks(uint8_t *data, size_t n_blocks) const;
+};
+
 // NOLINTEND(*-magic-numbers)
 
 } // namespace parakeet_crypto::qrc
@@ -1,23 +1,94 @@
 #include "qrc_des.h"
+#include "qrc/int_helper.h"
+#include "qrc/qrc_des_data.h"
 
 #include "parakeet-crypto/IStream.h"
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/transformer/qmc.h"
 
+#include "test/make_sequence.test.hh"
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 using ::testing::ContainerEq;
 
+using namespace parakeet_crypto;
 using namespace parakeet_crypto::qrc;
 
 // NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 
+namespace
+{
+
+// The original bit-by-bit implementation.
+class ReferenceDES
+{
+  private:
+    std::array<uint64_t, 16> subkeys_{};
+
+    static uint64_t Round(uint64_t state, uint64_t key)
+    {
+        constexpr std::array<uint8_t, 8> kLargeStateShifts = {26, 20, 14, 8, 58, 52, 46, 40};
+
+        auto state_hi32 = int_helper::u64_get_hi32(state);
+        auto state_lo32 = int_helper::u64_get_lo32(state);
+        state = int_helper::map_u64(int_helper::make_u64(state_hi32, state_hi32), data::kKeyExpansionTable);
+        state ^= key;
+
+        uint32_t next_lo32{0};
+        for (size_t i = 0; i < data::kSBoxes.size(); i++)
+        {
+            next_lo32 = (next_lo32 << 4) | data::kSBoxes[i][(state >> kLargeStateShifts[i]) & 0b111111];
+        }
+        next_lo32 = int_helper::map_u32_bits(next_lo32, data::kPBox);
+        next_lo32 ^= state_lo32;
+        return int_helper::make_u64(next_lo32, state_hi32); // NOLINT(readability-suspicious-call-argument)
+    }
+
+  public:
+    explicit ReferenceDES(const uint8_t *key_bytes)
+    {
+        auto param = int_helper::map_u64(ReadLittleEndian<uint64_t>(key_bytes), data::kKeyPermutationTable);
+        auto param_c = int_helper::u64_get_lo32(param);
+        auto param_d = int_helper::u64_get_hi32(param);
+        for (size_t i = 0; i < subkeys_.size(); i++)
+        {
+            // Each 28-bit half sits in bits 31..4: rotate it, then drop what the right shift moved below bit 4.
+            auto shift_left = data::key_rnd_shift[i];
+            param_c = (param_c << shift_left) | ((param_c >> (28 - shift_left)) & 0xFFFFFFF0);
+            param_d = (param_d << shift_left) | ((param_d >> (28 - shift_left)) & 0xFFFFFFF0);
+            subkeys_[i] = int_helper::map_u64(int_helper::make_u64(param_d, param_c), data::kKeyCompressionTable);
+        }
+    }
+
+    [[nodiscard]] uint64_t Transform(uint64_t block, bool is_decrypt) const
+    {
+        auto state = int_helper::map_u64(block, data::kIpTable);
+        for (size_t i = 0; i < subkeys_.size(); i++)
+        {
+            state = Round(state, subkeys_[is_decrypt ? subkeys_.size() - 1 - i : i]);
+        }
+        return int_helper::map_u64(int_helper::swap_u64_side(state), data::kIpInvTable);
+    }
+
+    void Transform(uint8_t *block, bool is_decrypt) const
+    {
+        WriteLittleEndian(block, Transform(ReadLittleEndian<uint64_t>(block), is_decrypt));
+    }
+};
+
+} // namespace
+
 TEST(QRC_LRC, DecryptSomeData)
 {
     std::array<uint8_t, 16> input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6};
@@ -40,4 +111,62 @@ TEST(QRC_LRC, EncryptSomeData)
     ASSERT_THAT(input, ContainerEq(expected_data));
 }
 
+TEST(QRC_LRC, MatchesBitwiseReference)
+{
+    for (uint32_t seed = 1; seed <= 16; seed++)
+    {
+        const auto key = test::make_sequence(8, seed);
+        const ReferenceDES reference(key.data());
+        const QRC_DES des(key.data());
+
+        for (bool is_decrypt : {false, true})
+        {
+            // Odd block counts go through both the 4-lane and the single block paths.
+            for (size_t n_blocks : {1, 3, 4, 9})
+            {
+                const auto src = test::make_sequence(n_blocks * 8, seed + 100);
+                auto expected = src;
+                auto actual = src;
+                for (size_t i = 0; i < expected.size(); i += 8)
+                {
+                    reference.Transform(&expected[i], is_decrypt);
+                }
+                des.des_crypt_blocks(actual.data(), n_blocks, is_decrypt);
+                ASSERT_THAT(actual, ContainerEq(expected)) << "seed " << seed << " blocks " << n_blocks;
+
+                actual = src;
+                for (size_t i = 0; i < actual.size(); i += 8)
+                {
+                    des.des_crypt_block(&actual[i], is_decrypt);
+                }
+                ASSERT_THAT(actual, ContainerEq(expected)) << "seed " << seed << " blocks " << n_blocks;
+            }
+        }
+    }
+}
+
+TEST(QRC_LRC, TripleDESMatchesThreePasses)
+{
+    const auto key1 = test::make_sequence(8, 1);
+    const auto key2 = test::make_sequence(8, 2);
+    const auto key3 = test::make_sequence(8, 3);
+    const QRC_DES des1(key1.data());
+    const QRC_DES des2(key2.data());
+    const QRC_DES des3(key3.data());
+    const QRC_TripleDES triple_des(key1.data(), key2.data(), key3.data());
+
+    const auto src = test::make_sequence(11 * 8, 4);
+    auto expected = src;
+    for (size_t i = 0; i < expected.size(); i += 8)
+    {
+        des1.decrypt_block(&expected[i]);
+        des2.encrypt_block(&expected[i]);
+        des3.decrypt_block(&expected[i]);
+    }
+
+    auto actual = src;
+    triple_des.decrypt_blocks(actual.data(), actual.size() / 8);
+    ASSERT_THAT(actual, ContainerEq(expected));
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
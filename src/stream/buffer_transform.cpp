@@ -0,0 +1,59 @@
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+#include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace parakeet_crypto
+{
+
+TransformResult ITransformer::Transform(uint8_t *output, size_t &output_len, const uint8_t *input, size_t input_len)
+{
+    InputMemoryViewStream input_stream{input, input_len};
+
+    // Formats with a random access decryptor: the output size is known from the header alone,
+    // and the payload is decrypted straight into the output buffer.
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    auto result = CreateRandomAccessDecryptor(decryptor, &input_stream);
+    if (result == TransformResult::OK)
+    {
+        const auto data_offset = decryptor->GetDataOffset();
+        const auto data_size = decryptor->GetDataSize();
+        if (data_offset > input_len || data_size > input_len - data_offset)
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        if (output == nullptr || output_len < data_size)
+        {
+            output_len = data_size;
+            return TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+        }
+
+        std::copy_n(input + data_offset, data_size, output);
+        output_len = data_size;
+        return decryptor->DecryptAt(0, output, data_size) ? TransformResult::OK : TransformResult::ERROR_INVALID_KEY;
+    }
+    if (result != TransformResult::ERROR_NOT_IMPLEMENTED)
+    {
+        return result;
+    }
+
+    // Sequential formats: a single pass fills the output, and counts what did not fit.
+    input_stream.Seek(0, SeekDirection::SEEK_FILE_BEGIN);
+    OutputBufferStream output_stream{output, output == nullptr ? 0 : output_len};
+    result = Transform(&output_stream, &input_stream);
+    if (result == TransformResult::OK && output_stream.IsOverflow())
+    {
+        result = TransformResult::ERROR_INSUFFICIENT_OUTPUT;
+    }
+    if (result == TransformResult::OK || result == TransformResult::ERROR_INSUFFICIENT_OUTPUT)
+    {
+        output_len = output_stream.GetBytesWritten();
+    }
+    return result;
+}
+
+} // namespace parakeet_crypto
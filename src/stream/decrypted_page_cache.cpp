@@ -0,0 +1,156 @@
+#include "parakeet-crypto/DecryptedPageCache.h"
+#include "utils/paged_reader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace parakeet_crypto
+{
+
+DecryptedPageCache::DecryptedPageCache(size_t capacity_bytes, size_t shard_count)
+{
+    // Every shard must hold at least a full page, or small caches would never keep anything.
+    shard_count = std::max(std::min(shard_count, capacity_bytes / GetPageSize()), size_t{1});
+    shard_capacity_ = capacity_bytes / shard_count;
+
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; i++)
+    {
+        shards_.emplace_back(std::make_unique<Shard>());
+    }
+}
+
+DecryptedPageCache::~DecryptedPageCache() = default;
+
+size_t DecryptedPageCache::GetPageSize()
+{
+    return utils::kDecryptionPageSize;
+}
+
+size_t DecryptedPageCache::PageKeyHash::operator()(const PageKey &key) const
+{
+    // splitmix64 finalizer; consecutive pages of a file end up in different shards.
+    // NOLINTBEGIN(*-magic-numbers)
+    uint64_t hash = key.file_id ^ (static_cast<uint64_t>(key.page_index) * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    // NOLINTEND(*-magic-numbers)
+    return static_cast<size_t>(hash);
+}
+
+DecryptedPageCache::Shard &DecryptedPageCache::GetShard(const PageKey &key)
+{
+    return *shards_[PageKeyHash{}(key) % shards_.size()];
+}
+
+DecryptedPageCache::Page DecryptedPageCache::Get(uint64_t file_id, size_t page_index)
+{
+    PageKey key{file_id, page_index};
+    auto &shard = GetShard(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+    {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->second;
+}
+
+void DecryptedPageCache::Put(uint64_t file_id, size_t page_index, Page page)
+{
+    if (!page || page->size() > shard_capacity_)
+    {
+        return;
+    }
+
+    PageKey key{file_id, page_index};
+    auto &shard = GetShard(key);
+    auto page_size = page->size();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(key); it != shard.index.end())
+    {
+        shard.bytes_used -= it->second->second->size();
+        it->second->second = std::move(page);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    }
+    else
+    {
+        shard.lru.emplace_front(key, std::move(page));
+        shard.index.emplace(key, shard.lru.begin());
+    }
+    shard.bytes_used += page_size;
+
+    EvictLocked(shard);
+}
+
+void DecryptedPageCache::EvictLocked(Shard &shard)
+{
+    while (shard.bytes_used > shard_capacity_ && !shard.lru.empty())
+    {
+        auto &[key, page] = shard.lru.back();
+        shard.bytes_used -= page->size();
+        shard.index.erase(key);
+        shard.lru.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void DecryptedPageCache::Erase(uint64_t file_id)
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->lru.begin(); it != shard->lru.end();)
+        {
+            if (it->first.file_id == file_id)
+            {
+                shard->bytes_used -= it->second->size();
+                shard->index.erase(it->first);
+                it = shard->lru.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+void DecryptedPageCache::Clear()
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->bytes_used = 0;
+    }
+}
+
+DecryptedPageCacheStats DecryptedPageCache::GetStats() const
+{
+    DecryptedPageCacheStats stats{};
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    for (const auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.bytes_used += shard->bytes_used;
+        stats.page_count += shard->lru.size();
+    }
+    return stats;
+}
+
+} // namespace parakeet_crypto
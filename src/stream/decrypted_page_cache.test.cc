@@ -0,0 +1,144 @@
+#include "parakeet-crypto/DecryptedPageCache.h"
+#include "parakeet-crypto/DecryptingReadStream.h"
+#include "parakeet-crypto/StreamHelper.h"
+#include "parakeet-crypto/transformer/ncm.h"
+
+#include "test/read_fixture.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+DecryptedPageCache::Page MakePage(size_t len, uint8_t value)
+{
+    return std::make_shared<std::vector<uint8_t>>(len, value);
+}
+
+constexpr std::array<const uint8_t, 16> kNCMTestKey = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                       0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+} // namespace
+
+TEST(DecryptedPageCache, LeastRecentlyUsedEviction)
+{
+    // Single shard, room for 3 pages of 10 bytes.
+    DecryptedPageCache cache{30, 1};
+    cache.Put(1, 0, MakePage(10, 0));
+    cache.Put(1, 1, MakePage(10, 1));
+    cache.Put(2, 0, MakePage(10, 2));
+
+    ASSERT_NE(cache.Get(1, 0), nullptr); // (1, 1) is now the least recently used
+    cache.Put(2, 1, MakePage(10, 3));
+
+    ASSERT_EQ(cache.Get(1, 1), nullptr);
+    ASSERT_EQ(cache.Get(1, 0)->at(0), 0);
+    ASSERT_EQ(cache.Get(2, 0)->at(0), 2);
+    ASSERT_EQ(cache.Get(2, 1)->at(0), 3);
+
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.hits, 4);
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_EQ(stats.bytes_used, 30);
+    ASSERT_EQ(stats.page_count, 3);
+
+    cache.Erase(2);
+    ASSERT_EQ(cache.GetStats().page_count, 1);
+    cache.Clear();
+    ASSERT_EQ(cache.GetStats().bytes_used, 0);
+}
+
+TEST(DecryptedPageCache, OversizedPageIsNotCached)
+{
+    DecryptedPageCache cache{16, 1};
+    cache.Put(1, 0, MakePage(17, 0));
+    ASSERT_EQ(cache.Get(1, 0), nullptr);
+    ASSERT_EQ(cache.GetStats().bytes_used, 0);
+}
+
+TEST(DecryptedPageCache, SmallCapacityStillCaches)
+{
+    // Room for 8 pages only: fewer shards than requested, each one still holding full pages.
+    const auto page_size = DecryptedPageCache::GetPageSize();
+    DecryptedPageCache cache{page_size * 8};
+    for (size_t i = 0; i < 8; i++)
+    {
+        cache.Put(1, i, MakePage(page_size, static_cast<uint8_t>(i)));
+    }
+
+    size_t hits{0};
+    for (size_t i = 0; i < 8; i++)
+    {
+        hits += cache.Get(1, i) != nullptr ? 1 : 0;
+    }
+    ASSERT_GT(hits, 0);
+    ASSERT_GT(cache.GetStats().page_count, 0);
+    ASSERT_LE(cache.GetStats().bytes_used, page_size * 8);
+}
+
+TEST(DecryptedPageCache, SharedByConcurrentReaders)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto fixture = test::read_fixture("test.ncm");
+    InputMemoryStream input{fixture};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(kNCMTestKey.data());
+    std::unique_ptr<IRandomAccessDecryptor> decryptor_owner{};
+    ASSERT_EQ(transformer->CreateRandomAccessDecryptor(decryptor_owner, &input), TransformResult::OK);
+    std::shared_ptr<const IRandomAccessDecryptor> decryptor = std::move(decryptor_owner);
+
+    auto cache = std::make_shared<DecryptedPageCache>(size_t{16} * 1024 * 1024);
+    constexpr size_t kReaderCount = 4;
+    std::vector<std::vector<uint8_t>> results(kReaderCount);
+    std::vector<std::thread> readers{};
+    for (size_t i = 0; i < kReaderCount; i++)
+    {
+        readers.emplace_back([&, i]() {
+            DecryptingReadStream stream{input, decryptor};
+            stream.SetPageCache(cache, 1);
+
+            auto &result = results[i];
+            result.resize(plain.size());
+            (void)stream.ReadAt(0, result.data(), result.size());
+        });
+    }
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+
+    for (auto &result : results)
+    {
+        ASSERT_THAT(result, ContainerEq(plain));
+    }
+
+    auto page_count = (plain.size() + DecryptedPageCache::GetPageSize() - 1) / DecryptedPageCache::GetPageSize();
+    auto stats = cache->GetStats();
+    ASSERT_EQ(stats.hits + stats.misses, page_count * kReaderCount);
+    ASSERT_EQ(stats.page_count, page_count);
+    ASSERT_EQ(stats.bytes_used, plain.size());
+
+    // A second pass is served from the cache.
+    DecryptingReadStream stream{input, decryptor};
+    stream.SetPageCache(cache, 1);
+    std::vector<uint8_t> result(plain.size());
+    ASSERT_EQ(stream.ReadAt(0, result.data(), result.size()), plain.size());
+    ASSERT_THAT(result, ContainerEq(plain));
+    ASSERT_EQ(cache->GetStats().hits, stats.hits + page_count);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
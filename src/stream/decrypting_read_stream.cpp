@@ -0,0 +1,96 @@
+#include "parakeet-crypto/DecryptingReadStream.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+TransformResult DecryptingReadStream::Create(std::unique_ptr<DecryptingReadStream> &stream, ITransformer *transformer,
+                                             IReadSeekable *input)
+{
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    if (auto result = transformer->CreateRandomAccessDecryptor(decryptor, input); result != TransformResult::OK)
+    {
+        return result;
+    }
+
+    stream = std::make_unique<DecryptingReadStream>(*input, std::move(decryptor));
+    return TransformResult::OK;
+}
+
+size_t DecryptingReadStream::ReadAt(size_t offset, uint8_t *buffer, size_t len)
+{
+    const auto data_size = decryptor_->GetDataSize();
+    if (offset >= data_size)
+    {
+        return 0;
+    }
+    len = std::min(len, data_size - offset);
+
+    if (page_cache_)
+    {
+        return ReadAtCached(offset, buffer, len);
+    }
+
+    // Read the encrypted bytes straight into the caller's buffer, then decrypt in place.
+    auto bytes_read = input_.ReadAt(decryptor_->GetDataOffset() + offset, buffer, len);
+    if (bytes_read == 0 || !decryptor_->DecryptAt(offset, buffer, bytes_read))
+    {
+        return 0;
+    }
+
+    return bytes_read;
+}
+
+size_t DecryptingReadStream::ReadAtCached(size_t offset, uint8_t *buffer, size_t len)
+{
+    const auto page_size = DecryptedPageCache::GetPageSize();
+    const auto data_size = decryptor_->GetDataSize();
+    const auto data_offset = decryptor_->GetDataOffset();
+
+    size_t total_read{0};
+    while (len > 0)
+    {
+        auto page_index = offset / page_size;
+        auto page_offset = offset % page_size;
+
+        auto page = page_cache_->Get(file_id_, page_index);
+        if (!page)
+        {
+            // Decrypt the whole page, so the next reader can use it.
+            auto page_start = page_index * page_size;
+            auto page_len = std::min(page_size, data_size - page_start);
+
+            auto page_data = std::make_shared<std::vector<uint8_t>>(page_len);
+            if (!input_.ReadExactAt(data_offset + page_start, page_data->data(), page_len) ||
+                !decryptor_->DecryptAt(page_start, page_data->data(), page_len))
+            {
+                break;
+            }
+
+            page = page_data;
+            page_cache_->Put(file_id_, page_index, page);
+        }
+
+        if (page_offset >= page->size())
+        {
+            break; // stale page, from a file id reused for a different file.
+        }
+
+        auto copy_len = std::min(len, page->size() - page_offset);
+        std::copy_n(page->data() + page_offset, copy_len, buffer);
+
+        buffer += copy_len;
+        offset += copy_len;
+        len -= copy_len;
+        total_read += copy_len;
+    }
+
+    return total_read;
+}
+
+} // namespace parakeet_crypto
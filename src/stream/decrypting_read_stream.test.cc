@@ -0,0 +1,101 @@
+#include "parakeet-crypto/DecryptingReadStream.h"
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
+#include "parakeet-crypto/transformer/joox.h"
+#include "parakeet-crypto/transformer/kuwo.h"
+#include "parakeet-crypto/transformer/ncm.h"
+
+#include "test/read_fixture.test.hh"
+#include "test/test_env.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+constexpr std::array<const uint8_t, 16> kNCMTestKey = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                       0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+constexpr std::array<const uint8_t, 0x20> kKuwoTestKey = {
+    0x7C, 0x31, 0x33, 0xF1, 0x37, 0x74, 0x70, 0x3E, 0x25, 0x39, 0x28, 0x2D, 0xE9, 0xC8, 0xB3, 0xC3,
+    0xDF, 0x6D, 0x29, 0xB3, 0xB2, 0xA4, 0x0B, 0xFF, 0x3E, 0x0F, 0x60, 0x7A, 0xE6, 0x78, 0xEE, 0x33};
+
+} // namespace
+
+TEST(DecryptingReadStream, ReadAndSeek)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto fixture = test::read_fixture("test.ncm");
+    InputMemoryStream input{fixture};
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(kNCMTestKey.data());
+    std::unique_ptr<DecryptingReadStream> stream{};
+    ASSERT_EQ(DecryptingReadStream::Create(stream, transformer.get(), &input), TransformResult::OK);
+    ASSERT_EQ(stream->GetSize(), plain.size());
+    ASSERT_EQ(stream->GetOffset(), 0);
+
+    IReadSeekable &reader = *stream;
+
+    // Jump to the tail first, as a tag reader would.
+    std::vector<uint8_t> buffer(100);
+    reader.Seek(-100, SeekDirection::SEEK_FILE_END);
+    ASSERT_TRUE(reader.ReadExact(buffer.data(), buffer.size()));
+    ASSERT_THAT(buffer, ContainerEq(std::vector<uint8_t>(plain.end() - 100, plain.end())));
+    ASSERT_EQ(reader.Read(buffer.data(), buffer.size()), 0);
+
+    // Then read everything from the start, in odd-sized chunks.
+    reader.Seek(0, SeekDirection::SEEK_FILE_BEGIN);
+    std::vector<uint8_t> result{};
+    std::array<uint8_t, 999> chunk{};
+    while (auto n = reader.Read(chunk.data(), chunk.size()))
+    {
+        result.insert(result.end(), chunk.begin(), chunk.begin() + n);
+    }
+    ASSERT_THAT(result, ContainerEq(plain));
+}
+
+TEST(DecryptingReadStream, KuwoFileStream)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto input = InputFDStream::Open((std::string(test::get_fixture_directory()) + "test_kuwo.kwm").c_str());
+    ASSERT_NE(input, nullptr);
+
+    auto transformer = transformer::CreateKuwoDecryptionTransformer(kKuwoTestKey.data());
+    std::unique_ptr<DecryptingReadStream> stream{};
+    ASSERT_EQ(DecryptingReadStream::Create(stream, transformer.get(), input.get()), TransformResult::OK);
+    ASSERT_EQ(stream->GetDecryptor().GetDataOffset(), 0x400);
+    ASSERT_TRUE(stream->IsConcurrentReadAtSupported());
+
+    std::vector<uint8_t> result(plain.size());
+    ASSERT_TRUE(stream->ReadExactAt(0, result.data(), result.size()));
+    ASSERT_THAT(result, ContainerEq(plain));
+}
+
+TEST(DecryptingReadStream, UnsupportedFormat)
+{
+    auto fixture = test::read_fixture("joox_[E!04].ofl_en");
+    InputMemoryStream input{fixture};
+
+    transformer::JooxConfig config{};
+    config.install_uuid = "ffffffffffffffffffffffffffffffff";
+    auto transformer = transformer::CreateJooxDecryptionV4Transformer(config);
+    std::unique_ptr<DecryptingReadStream> stream{};
+    ASSERT_EQ(DecryptingReadStream::Create(stream, transformer.get(), &input), TransformResult::ERROR_NOT_IMPLEMENTED);
+    ASSERT_EQ(stream, nullptr);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
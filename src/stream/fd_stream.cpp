@@ -0,0 +1,332 @@
+#include "parakeet-crypto/StreamHelper.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace parakeet_crypto
+{
+
+#if _WIN32
+
+namespace
+{
+
+// `_O_SEQUENTIAL` is the hint for a sequential scan on Windows.
+inline int OpenFileForRead(const char *path)
+{
+    return _open(path, _O_RDONLY | _O_BINARY | _O_SEQUENTIAL);
+}
+
+inline void AdviseSequentialRead(int /*fd*/)
+{
+}
+
+inline int OpenFileForWrite(const char *path)
+{
+    return _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+inline void CloseFile(int fd)
+{
+    _close(fd);
+}
+
+inline size_t GetFileSize(int fd)
+{
+    struct _stat64 file_stat
+    {
+    };
+    if (_fstat64(fd, &file_stat) != 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(file_stat.st_size);
+}
+
+// ReadFile with an explicit offset does not depend on the shared file pointer.
+inline int64_t PositionalRead(int fd, uint8_t *buffer, size_t len, size_t offset)
+{
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd)); // NOLINT(*-reinterpret-cast, *-no-int-to-ptr)
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(uint64_t{offset});
+    overlapped.OffsetHigh = static_cast<DWORD>(uint64_t{offset} >> 32); // NOLINT(*-magic-numbers)
+
+    DWORD bytes_read{0};
+    auto chunk_len = static_cast<DWORD>(std::min(len, size_t{0x40000000}));
+    if (!ReadFile(handle, buffer, chunk_len, &bytes_read, &overlapped))
+    {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return bytes_read;
+}
+
+inline int64_t PositionalWrite(int fd, const uint8_t *buffer, size_t len, size_t offset)
+{
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd)); // NOLINT(*-reinterpret-cast, *-no-int-to-ptr)
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(uint64_t{offset});
+    overlapped.OffsetHigh = static_cast<DWORD>(uint64_t{offset} >> 32); // NOLINT(*-magic-numbers)
+
+    DWORD bytes_written{0};
+    auto chunk_len = static_cast<DWORD>(std::min(len, size_t{0x40000000}));
+    if (!WriteFile(handle, buffer, chunk_len, &bytes_written, &overlapped))
+    {
+        return -1;
+    }
+    return bytes_written;
+}
+
+// Reserves the clusters, without moving the end of file.
+inline bool PreallocateFile(int fd, size_t size)
+{
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd)); // NOLINT(*-reinterpret-cast, *-no-int-to-ptr)
+    FILE_ALLOCATION_INFO info{};
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+    return SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info)) != 0;
+}
+
+} // namespace
+
+#else
+
+namespace
+{
+
+inline int OpenFileForRead(const char *path)
+{
+    return open(path, O_RDONLY | O_CLOEXEC); // NOLINT(*-vararg)
+}
+
+inline void AdviseSequentialRead(int fd)
+{
+#if defined(POSIX_FADV_SEQUENTIAL)
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    (void)fd;
+#endif
+}
+
+inline int OpenFileForWrite(const char *path)
+{
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); // NOLINT(*-vararg, *-magic-numbers)
+}
+
+inline void CloseFile(int fd)
+{
+    close(fd);
+}
+
+inline size_t GetFileSize(int fd)
+{
+    struct stat file_stat
+    {
+    };
+    if (fstat(fd, &file_stat) != 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(file_stat.st_size);
+}
+
+inline int64_t PositionalRead(int fd, uint8_t *buffer, size_t len, size_t offset)
+{
+    ssize_t bytes_read{};
+    do // NOLINT(*-avoid-do-while)
+    {
+        bytes_read = pread(fd, buffer, len, static_cast<off_t>(offset));
+    } while (bytes_read < 0 && errno == EINTR);
+    return bytes_read;
+}
+
+inline int64_t PositionalWrite(int fd, const uint8_t *buffer, size_t len, size_t offset)
+{
+    ssize_t bytes_written{};
+    do // NOLINT(*-avoid-do-while)
+    {
+        bytes_written = pwrite(fd, buffer, len, static_cast<off_t>(offset));
+    } while (bytes_written < 0 && errno == EINTR);
+    return bytes_written;
+}
+
+// Reserves the blocks, without moving the end of file. Only Linux can do so (`FALLOC_FL_KEEP_SIZE`);
+// `posix_fallocate` would extend the file, and leave zeros behind if the output turns out shorter.
+inline bool PreallocateFile(int fd, size_t size)
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    int result{};
+    do // NOLINT(*-avoid-do-while)
+    {
+        result = fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+    } while (result != 0 && errno == EINTR);
+    return result == 0;
+#else
+    (void)fd;
+    (void)size;
+    return false;
+#endif
+}
+
+} // namespace
+
+#endif
+
+std::unique_ptr<InputFDStream> InputFDStream::Open(const char *path)
+{
+    int fd = OpenFileForRead(path);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    AdviseSequentialRead(fd);
+    return std::make_unique<InputFDStream>(fd, true);
+}
+
+InputFDStream::InputFDStream(int fd, bool owns_fd) : fd_(fd), owns_fd_(owns_fd), size_(GetFileSize(fd))
+{
+}
+
+InputFDStream::~InputFDStream()
+{
+    if (owns_fd_ && fd_ >= 0)
+    {
+        CloseFile(fd_);
+    }
+}
+
+size_t InputFDStream::ReadAt(size_t offset, uint8_t *buffer, size_t len)
+{
+    size_t total_read{0};
+    while (total_read < len)
+    {
+        auto bytes_read = PositionalRead(fd_, buffer + total_read, len - total_read, offset + total_read);
+        if (bytes_read <= 0)
+        {
+            break; // EOF or error
+        }
+        total_read += static_cast<size_t>(bytes_read);
+    }
+    return total_read;
+}
+
+std::unique_ptr<OutputFDStream> OutputFDStream::Open(const char *path)
+{
+    int fd = OpenFileForWrite(path);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<OutputFDStream>(fd, true);
+}
+
+OutputFDStream::~OutputFDStream()
+{
+    (void)Flush();
+    if (owns_fd_ && fd_ >= 0)
+    {
+        CloseFile(fd_);
+    }
+}
+
+bool OutputFDStream::WriteAt(size_t offset, const uint8_t *buffer, size_t len)
+{
+    size_t total_written{0};
+    while (total_written < len)
+    {
+        auto bytes_written =
+            PositionalWrite(fd_, buffer + total_written, len - total_written, offset + total_written);
+        if (bytes_written <= 0)
+        {
+            return false;
+        }
+        total_written += static_cast<size_t>(bytes_written);
+    }
+    return true;
+}
+
+bool OutputFDStream::Flush()
+{
+    if (buffered_len_ == 0)
+    {
+        return true;
+    }
+
+    if (!WriteAt(offset_, buffer_.data(), buffered_len_))
+    {
+        return false;
+    }
+    offset_ += buffered_len_;
+    buffered_len_ = 0;
+    return true;
+}
+
+bool OutputFDStream::ReserveForWriteAt(size_t len, size_t &offset)
+{
+    if (!Flush())
+    {
+        return false;
+    }
+
+    offset = offset_;
+    offset_ += len;
+    return true;
+}
+
+bool OutputFDStream::Write(const uint8_t *buffer, size_t len)
+{
+    // Large writes skip the buffer.
+    if (buffered_len_ == 0 && len >= kWriteBufferSize)
+    {
+        if (!WriteAt(offset_, buffer, len))
+        {
+            return false;
+        }
+        offset_ += len;
+        return true;
+    }
+
+    if (buffer_.empty())
+    {
+        buffer_.resize(kWriteBufferSize);
+    }
+
+    while (len > 0)
+    {
+        auto copy_len = std::min(len, buffer_.size() - buffered_len_);
+        std::copy_n(buffer, copy_len, buffer_.data() + buffered_len_);
+        buffered_len_ += copy_len;
+        buffer += copy_len;
+        len -= copy_len;
+
+        if (buffered_len_ == buffer_.size() && !Flush())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OutputFDStream::Preallocate(size_t size)
+{
+    return PreallocateFile(fd_, size);
+}
+
+} // namespace parakeet_crypto
@@ -0,0 +1,233 @@
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/StreamHelper.h"
+
+#include "test/make_sequence.test.hh"
+#include "test/read_fixture.test.hh"
+#include "test/test_env.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+std::string GetFixturePath(const char *name)
+{
+    return std::string(test::get_fixture_directory()) + name;
+}
+
+} // namespace
+
+TEST(InputFDStream, ReadAtKeepsCursor)
+{
+    auto expected = test::read_fixture("test.ncm");
+    auto stream = InputFDStream::Open(GetFixturePath("test.ncm").c_str());
+    ASSERT_NE(stream, nullptr);
+    ASSERT_EQ(stream->GetSize(), expected.size());
+
+    stream->Seek(10, SeekDirection::SEEK_FILE_BEGIN);
+
+    std::vector<uint8_t> buffer(64);
+    ASSERT_TRUE(stream->ReadExactAt(1000, buffer.data(), buffer.size()));
+    ASSERT_THAT(buffer, ContainerEq(std::vector<uint8_t>(expected.begin() + 1000, expected.begin() + 1064)));
+    ASSERT_EQ(stream->GetOffset(), 10);
+
+    ASSERT_EQ(stream->ReadAt(expected.size() - 4, buffer.data(), buffer.size()), 4);
+    ASSERT_EQ(stream->ReadAt(expected.size() + 4, buffer.data(), buffer.size()), 0);
+}
+
+TEST(InputFDStream, ConcurrentReadAt)
+{
+    auto expected = test::read_fixture("test.ncm");
+    auto stream = InputFDStream::Open(GetFixturePath("test.ncm").c_str());
+    ASSERT_NE(stream, nullptr);
+    ASSERT_TRUE(stream->IsConcurrentReadAtSupported());
+
+    constexpr size_t kThreadCount = 4;
+    std::vector<uint8_t> result(expected.size());
+    std::vector<std::thread> workers{};
+    size_t chunk_size = (expected.size() + kThreadCount - 1) / kThreadCount;
+    for (size_t i = 0; i < kThreadCount; i++)
+    {
+        workers.emplace_back([&, i]() {
+            auto offset = std::min(i * chunk_size, expected.size());
+            auto len = std::min(chunk_size, expected.size() - offset);
+            (void)stream->ReadAt(offset, &result[offset], len);
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    ASSERT_THAT(result, ContainerEq(expected));
+}
+
+TEST(OutputFDStream, BufferedWrite)
+{
+    const auto expected = test::make_sequence(OutputFDStream::kWriteBufferSize * 3 + 10000, 31);
+
+    FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        OutputFDStream stream{fileno(file)};
+
+        // Small writes, one straddling the buffer boundary, then one larger than the buffer.
+        size_t offset{0};
+        for (size_t len : {size_t{1}, size_t{4095}, OutputFDStream::kWriteBufferSize - 10, size_t{4096},
+                           OutputFDStream::kWriteBufferSize * 2})
+        {
+            ASSERT_TRUE(stream.Write(&expected[offset], len));
+            offset += len;
+        }
+        ASSERT_TRUE(stream.Write(&expected[offset], expected.size() - offset));
+        ASSERT_EQ(stream.GetOffset(), expected.size());
+        ASSERT_TRUE(stream.Flush());
+    }
+
+    InputFDStream reader{fileno(file)};
+    ASSERT_EQ(reader.GetSize(), expected.size());
+    std::vector<uint8_t> result(expected.size());
+    ASSERT_TRUE(reader.ReadExactAt(0, result.data(), result.size()));
+    ASSERT_THAT(result, ContainerEq(expected));
+    fclose(file);
+}
+
+TEST(OutputFDStream, FailedWriteKeepsOffset)
+{
+    // Opened for reading only: every write to the file descriptor fails.
+    FILE *file = std::fopen(GetFixturePath("test.ncm").c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    {
+        OutputFDStream stream{fileno(file)};
+        std::vector<uint8_t> data(OutputFDStream::kWriteBufferSize);
+        ASSERT_FALSE(stream.Write(data.data(), data.size()));
+        ASSERT_EQ(stream.GetOffset(), 0);
+
+        ASSERT_TRUE(stream.Write(data.data(), 4)); // still buffered
+        ASSERT_FALSE(stream.Flush());
+        ASSERT_EQ(stream.GetOffset(), 4);
+    }
+    fclose(file);
+}
+
+TEST(OutputFDStream, ReserveForWriteAt)
+{
+    const std::vector<uint8_t> expected{'h', 'e', 'a', 'd', '1', '2', '3', 't', 'a', 'i', 'l'};
+
+    FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        OutputFDStream stream{fileno(file)};
+        ASSERT_TRUE(stream.Write(&expected[0], 4)); // still buffered
+
+        size_t offset{0};
+        ASSERT_TRUE(stream.ReserveForWriteAt(3, offset));
+        ASSERT_EQ(offset, 4);
+        ASSERT_EQ(stream.GetOffset(), 7);
+
+        ASSERT_TRUE(stream.Write(&expected[7], 4));
+        ASSERT_TRUE(stream.WriteAt(offset, &expected[4], 3));
+        ASSERT_TRUE(stream.Flush());
+    }
+
+    InputFDStream reader{fileno(file)};
+    std::vector<uint8_t> result(reader.GetSize());
+    ASSERT_TRUE(reader.ReadExactAt(0, result.data(), result.size()));
+    ASSERT_THAT(result, ContainerEq(expected));
+    fclose(file);
+}
+
+TEST(OutputFDStream, ConcurrentWriteAtIntoPreallocatedFile)
+{
+    auto expected = test::read_fixture("test.ncm");
+
+    FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        OutputFDStream stream{fileno(file)};
+        ASSERT_TRUE(stream.IsConcurrentWriteAtSupported());
+        (void)stream.Preallocate(expected.size()); // best-effort, depends on the file system
+
+        // Workers finish in any order; the last chunk is likely written first.
+        constexpr size_t kThreadCount = 4;
+        std::vector<std::thread> workers{};
+        size_t chunk_size = (expected.size() + kThreadCount - 1) / kThreadCount;
+        for (size_t i = kThreadCount; i-- > 0;)
+        {
+            workers.emplace_back([&, i]() {
+                auto offset = std::min(i * chunk_size, expected.size());
+                auto len = std::min(chunk_size, expected.size() - offset);
+                EXPECT_TRUE(stream.WriteAt(offset, &expected[offset], len));
+            });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    InputFDStream reader{fileno(file)};
+    ASSERT_EQ(reader.GetSize(), expected.size());
+    std::vector<uint8_t> result(expected.size());
+    ASSERT_TRUE(reader.ReadExactAt(0, result.data(), result.size()));
+    ASSERT_THAT(result, ContainerEq(expected));
+    fclose(file);
+}
+
+TEST(InputMemoryStream, ReadAt)
+{
+    std::vector<uint8_t> data{1, 2, 3, 4, 5, 6, 7, 8};
+    InputMemoryStream stream{data};
+
+    std::vector<uint8_t> buffer(4);
+    ASSERT_EQ(stream.ReadAt(6, buffer.data(), buffer.size()), 2);
+    ASSERT_EQ(buffer[0], 7);
+    ASSERT_EQ(buffer[1], 8);
+    ASSERT_EQ(stream.GetOffset(), 0);
+}
+
+TEST(SlicedReadableStream, RelativeOffsets)
+{
+    std::vector<uint8_t> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    InputMemoryStream parent{data};
+    SlicedReadableStream slice{parent, 2, 8};
+    ASSERT_EQ(slice.GetSize(), 6);
+    ASSERT_EQ(slice.GetOffset(), 0);
+
+    std::vector<uint8_t> buffer(16);
+    ASSERT_EQ(slice.Read(buffer.data(), 3), 3);
+    ASSERT_THAT(std::vector<uint8_t>(buffer.begin(), buffer.begin() + 3), ContainerEq(std::vector<uint8_t>{2, 3, 4}));
+    ASSERT_EQ(slice.GetOffset(), 3);
+
+    ASSERT_EQ(slice.Read(buffer.data(), buffer.size()), 3);
+    ASSERT_EQ(buffer[2], 7);
+    ASSERT_EQ(slice.GetOffset(), 6);
+
+    slice.Seek(-2, SeekDirection::SEEK_FILE_END);
+    ASSERT_EQ(slice.GetOffset(), 4);
+    ASSERT_EQ(parent.GetOffset(), 6);
+
+    ASSERT_EQ(slice.ReadAt(5, buffer.data(), buffer.size()), 1);
+    ASSERT_EQ(buffer[0], 7);
+    ASSERT_EQ(slice.GetOffset(), 4);
+
+    const auto *view = slice.GetContiguousView(1, 2);
+    ASSERT_NE(view, nullptr);
+    ASSERT_EQ(view[0], 3);
+    ASSERT_EQ(slice.GetContiguousView(5, 2), nullptr);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -0,0 +1,131 @@
+#include "parakeet-crypto/StreamHelper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace parakeet_crypto
+{
+
+#if _WIN32
+
+std::unique_ptr<MappedFileStream> MappedFileStream::Open(const char *path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFileStream> stream(new MappedFileStream());
+    stream->file_handle_ = file;
+    stream->size_ = static_cast<size_t>(file_size.QuadPart);
+    if (stream->size_ == 0)
+    {
+        return stream; // Empty files can't be mapped.
+    }
+
+    stream->mapping_handle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (stream->mapping_handle_ == nullptr)
+    {
+        return nullptr;
+    }
+
+    stream->data_ = static_cast<const uint8_t *>(MapViewOfFile(stream->mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+    if (stream->data_ == nullptr)
+    {
+        return nullptr;
+    }
+
+    return stream;
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_ != nullptr)
+    {
+        CloseHandle(mapping_handle_);
+    }
+    if (file_handle_ != nullptr)
+    {
+        CloseHandle(file_handle_);
+    }
+}
+
+#else
+
+std::unique_ptr<MappedFileStream> MappedFileStream::Open(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC); // NOLINT(*-vararg)
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat file_stat
+    {
+    };
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFileStream> stream(new MappedFileStream());
+    stream->size_ = static_cast<size_t>(file_stat.st_size);
+    if (stream->size_ == 0)
+    {
+        close(fd);
+        return stream; // Empty files can't be mapped.
+    }
+
+    void *data = mmap(nullptr, stream->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file.
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(data, stream->size_, MADV_SEQUENTIAL);
+#endif
+
+    stream->data_ = static_cast<const uint8_t *>(data);
+    return stream;
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(data_), size_); // NOLINT(*-const-cast)
+    }
+}
+
+#endif
+
+} // namespace parakeet_crypto
@@ -0,0 +1,100 @@
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
+#include "parakeet-crypto/transformer/ncm.h"
+
+#include "test/read_fixture.test.hh"
+#include "test/test_env.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+std::string GetFixturePath(const char *name)
+{
+    return std::string(test::get_fixture_directory()) + name;
+}
+
+constexpr std::array<const uint8_t, 16> kNCMKey = {0x80, 0x88, 0x6A, 0x09, 0x09, 0x2E, 0x28, 0x7F,
+                                                   0xB1, 0x66, 0xB3, 0x8D, 0x0C, 0xEB, 0xC7, 0x1A};
+
+} // namespace
+
+TEST(MappedFileStream, ReadAndSeek)
+{
+    auto expected = test::read_fixture("test.ncm");
+    auto stream = MappedFileStream::Open(GetFixturePath("test.ncm").c_str());
+    ASSERT_NE(stream, nullptr);
+    ASSERT_EQ(stream->GetSize(), expected.size());
+
+    IReadSeekable &reader = *stream;
+    auto head = reader.Read(16);
+    ASSERT_THAT(head, ContainerEq(std::vector<uint8_t>(expected.begin(), expected.begin() + 16)));
+    ASSERT_EQ(reader.GetOffset(), 16);
+
+    reader.Seek(-8, SeekDirection::SEEK_FILE_END);
+    auto tail = reader.Read(32);
+    ASSERT_THAT(tail, ContainerEq(std::vector<uint8_t>(expected.end() - 8, expected.end())));
+}
+
+TEST(MappedFileStream, ContiguousView)
+{
+    auto expected = test::read_fixture("test.ncm");
+    auto stream = MappedFileStream::Open(GetFixturePath("test.ncm").c_str());
+    ASSERT_NE(stream, nullptr);
+
+    const auto *view = stream->GetContiguousView(100, 50);
+    ASSERT_NE(view, nullptr);
+    ASSERT_TRUE(std::equal(view, view + 50, expected.begin() + 100));
+
+    ASSERT_EQ(stream->GetContiguousView(expected.size() - 10, 11), nullptr);
+    ASSERT_EQ(stream->GetContiguousView(expected.size() + 1, 0), nullptr);
+}
+
+TEST(MappedFileStream, OpenMissingFile)
+{
+    auto stream = MappedFileStream::Open(GetFixturePath("file_does_not_exist.bin").c_str());
+    ASSERT_EQ(stream, nullptr);
+}
+
+TEST(MappedFileStream, DecryptFromMappedFile)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    auto stream = MappedFileStream::Open(GetFixturePath("test.ncm").c_str());
+    ASSERT_NE(stream, nullptr);
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(kNCMKey.data());
+    OutputMemoryStream output{};
+    ASSERT_EQ(transformer->Transform(&output, stream.get()), TransformResult::OK);
+    ASSERT_THAT(output.GetData(), ContainerEq(plain));
+}
+
+TEST(MappedFileStream, DecryptFromFileStreamWithoutView)
+{
+    auto plain = test::read_fixture("sample_test_121529_32kbps.ogg");
+    std::ifstream ifs(GetFixturePath("test.ncm"), std::ifstream::binary);
+    ASSERT_TRUE(ifs.is_open());
+    InputFileStream stream{ifs};
+    ASSERT_EQ(stream.GetContiguousView(0, 1), nullptr);
+
+    auto transformer = transformer::CreateNeteaseNCMDecryptionTransformer(kNCMKey.data());
+    OutputMemoryStream output{};
+    ASSERT_EQ(transformer->Transform(&output, &stream), TransformResult::OK);
+    ASSERT_THAT(output.GetData(), ContainerEq(plain));
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
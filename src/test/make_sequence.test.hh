@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parakeet_crypto::test
+{
+
+/**
+ * @brief Pseudo-random bytes (a linear congruential generator): the same `seed` always gives the same sequence.
+ */
+inline std::vector<uint8_t> make_sequence(size_t len, uint32_t seed)
+{
+    std::vector<uint8_t> result(len);
+    for (auto &value : result)
+    {
+        seed = seed * 1103515245 + 12345; // NOLINT(*-magic-numbers)
+        value = static_cast<uint8_t>(seed >> 16);
+    }
+    return result;
+}
+
+} // namespace parakeet_crypto::test
@@ -1,15 +1,22 @@
 #pragma once
 
 #include "read_fixture.test.hh"
+#include "test/make_sequence.test.hh"
 #include "test/read_fixture.test.hh"
 
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
 #include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/IStreamingDecryptor.h"
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/StreamHelper.h"
 #include "gmock/gmock.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -38,4 +45,239 @@ inline void should_decrypt_to_fixture(const char *input_fixture_name, std::uniqu
     ASSERT_THAT(output, testing::ContainerEq(fixture_plain));
 }
 
+/**
+ * @brief Decrypt the fixture several times with the same transformer: in a row, then from several threads at once.
+ */
+inline void should_decrypt_concurrently_to_fixture(const char *input_fixture_name,
+                                                   std::unique_ptr<ITransformer> &transformer)
+{
+    static const auto fixture_plain = read_fixture("sample_test_121529_32kbps.ogg");
+    constexpr size_t kThreadCount = 4;
+
+    auto fixture = read_fixture(input_fixture_name);
+    for (size_t i = 0; i < 2; i++)
+    {
+        auto [decryption_state, output] = transform_vector(fixture, transformer);
+        ASSERT_EQ(decryption_state, TransformResult::OK) << "pass: " << i;
+        ASSERT_THAT(output, testing::ContainerEq(fixture_plain)) << "pass: " << i;
+    }
+
+    std::array<std::pair<TransformResult, std::vector<uint8_t>>, kThreadCount> results{};
+    std::vector<std::thread> threads{};
+    for (auto &result : results)
+    {
+        threads.emplace_back([&]() { result = transform_vector(fixture, transformer); });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto &[decryption_state, output] : results)
+    {
+        ASSERT_EQ(decryption_state, TransformResult::OK);
+        ASSERT_THAT(output, testing::ContainerEq(fixture_plain));
+    }
+}
+
+inline void should_random_access_decrypt_to_fixture(const char *input_fixture_name,
+                                                    std::unique_ptr<ITransformer> &transformer)
+{
+    static const auto fixture_plain = read_fixture("sample_test_121529_32kbps.ogg");
+
+    auto fixture = read_fixture(input_fixture_name);
+    InputMemoryStream input{fixture};
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateRandomAccessDecryptor(decryptor, &input), TransformResult::OK);
+    ASSERT_NE(decryptor, nullptr);
+    ASSERT_EQ(decryptor->GetDataSize(), fixture_plain.size());
+    ASSERT_LE(decryptor->GetDataOffset() + decryptor->GetDataSize(), fixture.size());
+
+    const auto *encrypted = &fixture[decryptor->GetDataOffset()];
+
+    // Decrypt backwards, in chunks not aligned to any of the cipher page sizes.
+    constexpr size_t kChunkSize = 0x1001;
+    std::vector<uint8_t> output(fixture_plain.size());
+    for (size_t end = output.size(); end > 0;)
+    {
+        size_t start = end > kChunkSize ? end - kChunkSize : 0;
+        std::copy(&encrypted[start], &encrypted[end], &output[start]);
+        ASSERT_TRUE(decryptor->DecryptAt(start, &output[start], end - start));
+        end = start;
+    }
+    ASSERT_THAT(output, testing::ContainerEq(fixture_plain));
+
+    // Single bytes around segment/page boundaries used by the supported formats.
+    constexpr std::array<size_t, 8> kProbeOffsets{0x7f, 0x80, 0x3ff, 0x400, 0x13ff, 0x1400, 0x7fff, 0x8000};
+    for (auto offset : kProbeOffsets)
+    {
+        uint8_t value = encrypted[offset];
+        ASSERT_TRUE(decryptor->DecryptAt(offset, &value, 1));
+        ASSERT_EQ(value, fixture_plain[offset]) << "offset: " << offset;
+    }
+
+    uint8_t out_of_bounds{};
+    ASSERT_FALSE(decryptor->DecryptAt(fixture_plain.size(), &out_of_bounds, 1));
+}
+
+/**
+ * @brief Decrypt the fixture stored after some other data (e.g. a container header),
+ *        with the input positioned at the beginning of the encrypted file.
+ */
+inline void should_decrypt_after_prefix_to_fixture(const char *input_fixture_name,
+                                                   std::unique_ptr<ITransformer> &transformer)
+{
+    static const auto fixture_plain = read_fixture("sample_test_121529_32kbps.ogg");
+    constexpr size_t kPrefixSize = 0x123;
+
+    auto fixture = read_fixture(input_fixture_name);
+    std::vector<uint8_t> embedded(kPrefixSize + fixture.size(), 0xcc);
+    std::copy(fixture.begin(), fixture.end(), &embedded[kPrefixSize]);
+
+    {
+        OutputMemoryStream output{};
+        InputMemoryStream input{embedded};
+        input.Seek(kPrefixSize, SeekDirection::SEEK_FILE_BEGIN);
+        ASSERT_EQ(transformer->Transform(&output, &input), TransformResult::OK);
+        ASSERT_THAT(output.GetData(), testing::ContainerEq(fixture_plain));
+    }
+
+    InputMemoryStream input{embedded};
+    input.Seek(kPrefixSize, SeekDirection::SEEK_FILE_BEGIN);
+    std::unique_ptr<IRandomAccessDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateRandomAccessDecryptor(decryptor, &input), TransformResult::OK);
+    ASSERT_NE(decryptor, nullptr);
+    ASSERT_GE(decryptor->GetDataOffset(), kPrefixSize);
+    ASSERT_EQ(decryptor->GetDataSize(), fixture_plain.size());
+    ASSERT_LE(decryptor->GetDataOffset() + decryptor->GetDataSize(), embedded.size());
+
+    std::vector<uint8_t> output(&embedded[decryptor->GetDataOffset()],
+                                &embedded[decryptor->GetDataOffset() + decryptor->GetDataSize()]);
+    ASSERT_TRUE(decryptor->DecryptAt(0, output.data(), output.size()));
+    ASSERT_THAT(output, testing::ContainerEq(fixture_plain));
+}
+
+/**
+ * @brief Decrypt 5MiB of generated data on several threads, and compare with the single-threaded transformer:
+ *        after a header that is not part of the payload, to a positional writer between buffered writes, and
+ *        buffer to buffer.
+ */
+inline void should_decrypt_in_parallel_like(std::unique_ptr<ITransformer> &single_thread,
+                                            std::unique_ptr<ITransformer> &multi_thread)
+{
+    constexpr size_t kHeaderSize = 100;
+    auto encrypted = make_sequence(size_t{5 * 1024 * 1024 + 123}, 7);
+    const auto [expected_state, expected] = transform_vector(encrypted, single_thread);
+    ASSERT_EQ(expected_state, TransformResult::OK);
+
+    // In order, after a header that is not part of the payload.
+    std::vector<uint8_t> with_header(kHeaderSize + encrypted.size(), 0xAA);
+    std::copy(encrypted.begin(), encrypted.end(), &with_header[kHeaderSize]);
+    InputMemoryStream input{with_header};
+    input.Seek(kHeaderSize, SeekDirection::SEEK_FILE_BEGIN);
+    OutputMemoryStream output{};
+    ASSERT_EQ(multi_thread->Transform(&output, &input), TransformResult::OK);
+    ASSERT_THAT(output.GetData(), testing::ContainerEq(expected));
+    ASSERT_EQ(input.GetOffset(), with_header.size());
+
+    // Out of order, to a positional writer: at its current position, with data written (and buffered) before
+    //   and/or after the transform.
+    const std::vector<uint8_t> prefix(1000, 0x11);
+    const std::vector<uint8_t> suffix(2000, 0x22);
+    for (auto [with_prefix, with_suffix] : {std::pair{true, false}, std::pair{false, true}, std::pair{true, true}})
+    {
+        std::vector<uint8_t> expected_file = with_prefix ? prefix : std::vector<uint8_t>{};
+        expected_file.insert(expected_file.end(), expected.begin(), expected.end());
+        if (with_suffix)
+        {
+            expected_file.insert(expected_file.end(), suffix.begin(), suffix.end());
+        }
+
+        FILE *file = std::tmpfile();
+        ASSERT_NE(file, nullptr);
+        {
+            InputMemoryStream file_input{encrypted};
+            OutputFDStream file_output{fileno(file)};
+            ASSERT_TRUE(file_output.Write(prefix.data(), with_prefix ? prefix.size() : 0));
+            ASSERT_EQ(multi_thread->Transform(&file_output, &file_input), TransformResult::OK);
+            ASSERT_TRUE(file_output.Write(suffix.data(), with_suffix ? suffix.size() : 0));
+            ASSERT_TRUE(file_output.Flush());
+        }
+        InputFDStream file_reader{fileno(file)};
+        std::vector<uint8_t> file_data(file_reader.GetSize());
+        ASSERT_TRUE(file_reader.ReadExactAt(0, file_data.data(), file_data.size()));
+        fclose(file);
+        ASSERT_THAT(file_data, testing::ContainerEq(expected_file))
+            << "prefix: " << with_prefix << ", suffix: " << with_suffix;
+    }
+
+    // Buffer to buffer.
+    std::vector<uint8_t> buffer_output(encrypted.size());
+    size_t output_len = buffer_output.size();
+    ASSERT_EQ(multi_thread->Transform(buffer_output.data(), output_len, encrypted.data(), encrypted.size()),
+              TransformResult::OK);
+    ASSERT_EQ(output_len, expected.size());
+    ASSERT_THAT(buffer_output, testing::ContainerEq(expected));
+}
+
+inline void should_buffer_transform_to(const std::vector<uint8_t> &input, const std::vector<uint8_t> &expected,
+                                       std::unique_ptr<ITransformer> &transformer)
+{
+    // Size query
+    size_t output_len{0};
+    ASSERT_EQ(transformer->Transform(nullptr, output_len, input.data(), input.size()),
+              TransformResult::ERROR_INSUFFICIENT_OUTPUT);
+    ASSERT_EQ(output_len, expected.size());
+
+    // One byte short
+    std::vector<uint8_t> output(expected.size());
+    output_len = output.size() - 1;
+    ASSERT_EQ(transformer->Transform(output.data(), output_len, input.data(), input.size()),
+              TransformResult::ERROR_INSUFFICIENT_OUTPUT);
+    ASSERT_EQ(output_len, expected.size());
+
+    output_len = output.size();
+    ASSERT_EQ(transformer->Transform(output.data(), output_len, input.data(), input.size()), TransformResult::OK);
+    ASSERT_EQ(output_len, expected.size());
+    ASSERT_THAT(output, testing::ContainerEq(expected));
+}
+
+inline void should_buffer_transform_to_fixture(const char *input_fixture_name,
+                                               std::unique_ptr<ITransformer> &transformer)
+{
+    static const auto fixture_plain = read_fixture("sample_test_121529_32kbps.ogg");
+
+    auto fixture = read_fixture(input_fixture_name);
+    should_buffer_transform_to(fixture, fixture_plain, transformer);
+}
+
+inline void should_stream_decrypt_to(const std::vector<uint8_t> &input, const std::vector<uint8_t> &expected,
+                                     std::unique_ptr<ITransformer> &transformer)
+{
+    std::unique_ptr<IStreamingDecryptor> decryptor{};
+    ASSERT_EQ(transformer->CreateStreamingDecryptor(decryptor), TransformResult::OK);
+    ASSERT_NE(decryptor, nullptr);
+
+    // Chunks of varying sizes, as received from a network connection.
+    constexpr std::array<size_t, 6> kChunkSizes{1, 3, 17, 0, 1000, 0x1001};
+    OutputMemoryStream output{};
+    for (size_t offset = 0, i = 0; offset < input.size(); i++)
+    {
+        auto len = std::min(kChunkSizes[i % kChunkSizes.size()], input.size() - offset);
+        ASSERT_EQ(decryptor->Update(&input[offset], len, &output), TransformResult::OK) << "offset: " << offset;
+        offset += len;
+    }
+    ASSERT_EQ(decryptor->Final(&output), TransformResult::OK);
+    ASSERT_EQ(output.GetData().size(), expected.size());
+    ASSERT_THAT(output.GetData(), testing::ContainerEq(expected));
+}
+
+inline void should_stream_decrypt_to_fixture(const char *input_fixture_name,
+                                             std::unique_ptr<ITransformer> &transformer)
+{
+    static const auto fixture_plain = read_fixture("sample_test_121529_32kbps.ogg");
+
+    auto fixture = read_fixture(input_fixture_name);
+    should_stream_decrypt_to(fixture, fixture_plain, transformer);
+}
+
 } // namespace parakeet_crypto::test
@@ -54,6 +54,46 @@ template <size_t BlockSize> class BufferedTransform
             idx_ += n;
         }
     }
+
+    /**
+     * @brief Same as `ProcessBuffer`, but whole blocks of `buffer` are passed in runs: `callback(blocks, len)`, where
+     *        `len` is a multiple of `BlockSize`.
+     */
+    template <typename T> void ProcessBlocks(const uint8_t *buffer, size_t n, T &&callback)
+    {
+        if (idx_ != 0)
+        {
+            size_t to_copy = std::min(BlockSize - idx_, n);
+            std::copy_n(buffer, to_copy, &buffer_.at(idx_));
+            n -= to_copy;
+            buffer += to_copy;
+            idx_ += to_copy;
+            if (idx_ < BlockSize)
+            {
+                return;
+            }
+
+            idx_ = 0;
+            if (!callback(buffer_.data(), BlockSize))
+            {
+                return;
+            }
+        }
+
+        size_t blocks_len = n / BlockSize * BlockSize;
+        if (blocks_len > 0 && !callback(buffer, blocks_len))
+        {
+            return;
+        }
+        buffer += blocks_len;
+        n -= blocks_len;
+
+        if (n > 0)
+        {
+            std::copy_n(buffer, n, buffer_.data());
+            idx_ += n;
+        }
+    }
 };
 
 } // namespace parakeet_crypto
@@ -0,0 +1,81 @@
+#include "parakeet-crypto/KeyDerivationCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace parakeet_crypto
+{
+
+KeyDerivationCache::KeyDerivationCache(size_t capacity) : capacity_(std::max(capacity, size_t{1}))
+{
+}
+
+KeyDerivationCache::Key KeyDerivationCache::GetOrDerive(KeyDerivationKind kind, const std::vector<uint8_t> &input,
+                                                        const DeriveFunction &derive)
+{
+    std::string cache_key(1, static_cast<char>(kind));
+    cache_key.append(input.begin(), input.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = index_.find(cache_key); it != index_.end())
+        {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    auto derived = derive();
+    if (derived.empty())
+    {
+        return nullptr;
+    }
+    auto key = std::make_shared<const std::vector<uint8_t>>(std::move(derived));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = index_.find(cache_key); it != index_.end())
+    {
+        // Derived by another thread in the meantime.
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+
+    lru_.emplace_front(cache_key, key);
+    index_.emplace(std::move(cache_key), lru_.begin());
+    while (lru_.size() > capacity_)
+    {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return key;
+}
+
+void KeyDerivationCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    lru_.clear();
+}
+
+KeyDerivationCacheStats KeyDerivationCache::GetStats() const
+{
+    KeyDerivationCacheStats stats{};
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.entry_count = lru_.size();
+    return stats;
+}
+
+} // namespace parakeet_crypto
@@ -0,0 +1,136 @@
+#include "parakeet-crypto/KeyDerivationCache.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+std::vector<uint8_t> MakeInput(const std::string &value)
+{
+    return MakeKeyDerivationInput({{value.data(), value.size()}});
+}
+
+} // namespace
+
+TEST(KeyDerivationCache, HitsAndMisses)
+{
+    KeyDerivationCache cache{};
+    int derive_count = 0;
+    auto derive = [&]() {
+        derive_count++;
+        return std::vector<uint8_t>{1, 2, 3};
+    };
+
+    auto first = cache.GetOrDerive(KeyDerivationKind::JOOX_V4_PBKDF2, MakeInput("a"), derive);
+    auto second = cache.GetOrDerive(KeyDerivationKind::JOOX_V4_PBKDF2, MakeInput("a"), derive);
+    ASSERT_EQ(derive_count, 1);
+    ASSERT_EQ(first, second);
+    ASSERT_THAT(*second, ContainerEq(std::vector<uint8_t>{1, 2, 3}));
+
+    // Same input bytes, different derivation.
+    cache.GetOrDerive(KeyDerivationKind::MIGU3D_FILE_KEY, MakeInput("a"), derive);
+    ASSERT_EQ(derive_count, 2);
+
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.entry_count, 2);
+}
+
+TEST(KeyDerivationCache, FailuresAreNotCached)
+{
+    KeyDerivationCache cache{};
+    int derive_count = 0;
+    auto derive = [&]() {
+        derive_count++;
+        return std::vector<uint8_t>{};
+    };
+
+    ASSERT_EQ(cache.GetOrDerive(KeyDerivationKind::QMC2_EKEY, MakeInput("bad"), derive), nullptr);
+    ASSERT_EQ(cache.GetOrDerive(KeyDerivationKind::QMC2_EKEY, MakeInput("bad"), derive), nullptr);
+    ASSERT_EQ(derive_count, 2);
+    ASSERT_EQ(cache.GetStats().entry_count, 0);
+
+    ASSERT_TRUE(DeriveKey(&cache, KeyDerivationKind::QMC2_EKEY, MakeInput("bad"), derive).empty());
+}
+
+TEST(KeyDerivationCache, EvictsLeastRecentlyUsed)
+{
+    KeyDerivationCache cache{2};
+    auto derive_value = [](uint8_t value) { return [value]() { return std::vector<uint8_t>{value}; }; };
+
+    cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("1"), derive_value(1));
+    cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("2"), derive_value(2));
+    cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("1"), derive_value(1)); // "2" is now the oldest
+    auto evicted = cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("3"), derive_value(3));
+    ASSERT_EQ(cache.GetStats().evictions, 1);
+
+    bool derived_again = false;
+    cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("1"), [&]() {
+        derived_again = true;
+        return std::vector<uint8_t>{1};
+    });
+    ASSERT_FALSE(derived_again);
+
+    cache.GetOrDerive(KeyDerivationKind::KGM_V4_FILE_KEY, MakeInput("2"), [&]() {
+        derived_again = true;
+        return std::vector<uint8_t>{2};
+    });
+    ASSERT_TRUE(derived_again);
+    ASSERT_THAT(*evicted, ContainerEq(std::vector<uint8_t>{3})); // still valid after eviction
+}
+
+TEST(KeyDerivationCache, InputsAreSizePrefixed)
+{
+    std::string ab = "ab";
+    std::string c = "c";
+    std::string a = "a";
+    std::string bc = "bc";
+    ASSERT_NE(MakeKeyDerivationInput({{ab.data(), ab.size()}, {c.data(), c.size()}}),
+              MakeKeyDerivationInput({{a.data(), a.size()}, {bc.data(), bc.size()}}));
+}
+
+TEST(KeyDerivationCache, ConcurrentLookups)
+{
+    KeyDerivationCache cache{};
+    std::atomic<int> derive_count{0};
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 100; j++)
+            {
+                auto key = cache.GetOrDerive(KeyDerivationKind::KGM_V4_SLOT_KEY, MakeInput(std::to_string(j % 10)),
+                                             [&]() {
+                                                 derive_count++;
+                                                 return std::vector<uint8_t>{static_cast<uint8_t>(j % 10)};
+                                             });
+                ASSERT_THAT(*key, ContainerEq(std::vector<uint8_t>{static_cast<uint8_t>(j % 10)}));
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto stats = cache.GetStats();
+    ASSERT_EQ(stats.entry_count, 10);
+    ASSERT_EQ(stats.hits + stats.misses, 400);
+    ASSERT_EQ(stats.misses, static_cast<uint64_t>(derive_count.load()));
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
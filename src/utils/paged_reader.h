@@ -29,8 +29,20 @@ class PagedReader
     [[nodiscard]] inline bool ReadInPages(size_t page_size, size_t max_read, Callback callback)
     {
         size_t offset = input_->GetOffset();
-        std::vector<uint8_t> buffer_container(page_size, 0);
+        std::vector<uint8_t> buffer_container(std::min(page_size, max_read), 0);
         auto *buffer = buffer_container.data();
+
+        // Fast path: copy straight from the mapped pages, skipping the stream's own read buffer.
+        if (const auto *view = input_->GetContiguousView(offset, max_read); view != nullptr)
+        {
+            input_->Seek(offset + max_read, SeekDirection::SEEK_FILE_BEGIN);
+            return ViewInPages(page_size, offset, view, max_read, [&](size_t page_offset, const uint8_t *src,
+                                                                      size_t n) {
+                std::copy_n(src, n, buffer);
+                return callback(page_offset, buffer, n);
+            });
+        }
+
         for (size_t len_left = max_read; len_left > 0;)
         {
             size_t process_len = std::min(len_left, page_size);
@@ -50,6 +62,49 @@ class PagedReader
         return true;
     }
 
+    // std::function<bool(size_t file_offset, uint8_t *dst, const uint8_t *src, size_t n)>
+    // `src` is the (read-only) input, `dst` is the buffer to place the output. They may point to the same buffer.
+    template <typename Callback>
+    [[nodiscard]] inline bool TransformInPages(size_t page_size, size_t max_read, Callback callback)
+    {
+        size_t offset = input_->GetOffset();
+        if (const auto *view = input_->GetContiguousView(offset, max_read); view != nullptr)
+        {
+            input_->Seek(offset + max_read, SeekDirection::SEEK_FILE_BEGIN);
+
+            std::vector<uint8_t> buffer_container(std::min(page_size, max_read), 0);
+            auto *buffer = buffer_container.data();
+            return ViewInPages(page_size, offset, view, max_read, [&](size_t page_offset, const uint8_t *src,
+                                                                      size_t n) {
+                return callback(page_offset, buffer, src, n); //
+            });
+        }
+
+        return ReadInPages(page_size, max_read, [&](size_t page_offset, uint8_t *buffer, size_t n) {
+            return callback(page_offset, buffer, buffer, n); //
+        });
+    }
+
+    template <typename Callback>
+    [[nodiscard]] static inline bool ViewInPages(size_t page_size, size_t offset, const uint8_t *view, size_t len,
+                                                 Callback callback)
+    {
+        for (size_t len_left = len; len_left > 0;)
+        {
+            size_t process_len = std::min(len_left, page_size);
+            if (!callback(offset, view, process_len))
+            {
+                return false;
+            }
+
+            view += process_len;
+            offset += process_len;
+            len_left -= process_len;
+        }
+
+        return true;
+    }
+
     inline size_t GetBytesLeft()
     {
         return input_->GetSize() - input_->GetOffset();
@@ -72,6 +127,15 @@ class PagedReader
     {
         return ReadInPages(page_size, GetBytesLeft(), std::move(callback));
     }
+
+    template <typename Callback> [[nodiscard]] inline bool TransformInPages(Callback callback)
+    {
+        return TransformInPages(kDecryptionPageSize, GetBytesLeft(), std::move(callback));
+    }
+    template <typename Callback> [[nodiscard]] inline bool TransformInPages(size_t max_read, Callback callback)
+    {
+        return TransformInPages(kDecryptionPageSize, max_read, std::move(callback));
+    }
 };
 
 } // namespace parakeet_crypto::utils
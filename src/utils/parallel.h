@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parakeet_crypto::utils
+{
+
+/**
+ * @brief Number of threads to use when the caller did not choose: the number of CPU cores.
+ */
+inline size_t GetDefaultThreadCount()
+{
+    return std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Call `callback(worker_index, i)` for each `i` in `[0, count)`, in increasing order of `i`, spread over up to
+ *        `thread_count` threads (including the calling thread). `worker_index` is in `[0, thread_count)`, and
+ *        identifies the thread, e.g. to reuse a buffer.
+ */
+template <typename Callback> void RunOnThreads(size_t count, size_t thread_count, Callback callback)
+{
+    std::atomic<size_t> next_index{0};
+    auto worker = [&](size_t worker_index) {
+        for (size_t i = next_index++; i < count; i = next_index++)
+        {
+            callback(worker_index, i);
+        }
+    };
+
+    std::vector<std::thread> workers{};
+    for (size_t i = 1; i < std::min(thread_count, count); i++)
+    {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &thread : workers)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * @brief `RunOnThreads`, with results consumed in order: `process(worker_index, i)` runs concurrently, then
+ *        `commit(worker_index, i)` is called for each `i` in increasing order, one at a time. A worker waits for its
+ *        turn to commit before it takes the next item: at most one processed item per worker is held in memory.
+ *        Once a call returned false, the remaining items are skipped.
+ * @return false if a `process` or a `commit` call returned false.
+ */
+template <typename Process, typename Commit>
+bool RunOnThreadsInOrder(size_t count, size_t thread_count, Process process, Commit commit)
+{
+    std::atomic<bool> failed{false};
+    std::mutex commit_mutex{};
+    std::condition_variable commit_turn{};
+    size_t next_commit{0};
+
+    RunOnThreads(count, thread_count, [&](size_t worker_index, size_t i) {
+        bool ok = !failed && process(worker_index, i);
+
+        // Items are handed out in order: the earlier ones are already taken, and will reach their turn.
+        std::unique_lock<std::mutex> lock(commit_mutex);
+        commit_turn.wait(lock, [&]() { return next_commit == i; });
+        if (!failed && !(ok && commit(worker_index, i)))
+        {
+            failed = true;
+        }
+        next_commit++;
+        lock.unlock();
+        commit_turn.notify_all();
+    });
+
+    return !failed;
+}
+
+} // namespace parakeet_crypto::utils
@@ -0,0 +1,152 @@
+#include "parallel_decrypt.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace parakeet_crypto::utils
+{
+
+namespace
+{
+
+/**
+ * @brief Positional reads from several workers: serialized, unless the input supports concurrent reads.
+ */
+class SharedReader
+{
+  private:
+    IReadSeekable *input_;
+    bool concurrent_;
+    std::mutex mutex_{};
+
+  public:
+    explicit SharedReader(IReadSeekable *input) : input_(input), concurrent_(input->IsConcurrentReadAtSupported())
+    {
+    }
+
+    bool ReadExactAt(size_t offset, uint8_t *buffer, size_t len)
+    {
+        if (concurrent_)
+        {
+            return input_->ReadExactAt(offset, buffer, len);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return input_->ReadExactAt(offset, buffer, len);
+    }
+};
+
+} // namespace
+
+bool ParallelDecrypt(const IRandomAccessDecryptor &decryptor, IWriteable *output, IReadSeekable *input,
+                     size_t input_offset, size_t thread_count)
+{
+    const auto data_size = decryptor.GetDataSize();
+    const auto batch_count = (data_size + kParallelDecryptBatchSize - 1) / kParallelDecryptBatchSize;
+
+    std::vector<std::vector<uint8_t>> buffers(std::min(thread_count, batch_count));
+    SharedReader reader{input};
+    auto read_and_decrypt = [&](size_t worker, size_t batch) {
+        auto offset = batch * kParallelDecryptBatchSize;
+        auto len = std::min(kParallelDecryptBatchSize, data_size - offset);
+        auto &buffer = buffers[worker];
+        buffer.resize(len);
+        return reader.ReadExactAt(input_offset + offset, buffer.data(), len) &&
+               decryptor.DecryptAt(offset, buffer.data(), len);
+    };
+
+    bool ok{false};
+    size_t output_offset{0};
+    if (output->IsConcurrentWriteAtSupported() && output->ReserveForWriteAt(data_size, output_offset))
+    {
+        // Each batch goes to its place in the reserved range as soon as it is ready.
+        std::atomic<bool> failed{false};
+        RunOnThreads(batch_count, thread_count, [&](size_t worker, size_t batch) {
+            if (failed)
+            {
+                return;
+            }
+            const auto &buffer = buffers[worker];
+            if (!read_and_decrypt(worker, batch) ||
+                !output->WriteAt(output_offset + batch * kParallelDecryptBatchSize, buffer.data(), buffer.size()))
+            {
+                failed = true;
+            }
+        });
+        ok = !failed;
+    }
+    else
+    {
+        ok = RunOnThreadsInOrder(batch_count, thread_count, read_and_decrypt, [&](size_t worker, size_t /*batch*/) {
+            return output->Write(buffers[worker].data(), buffers[worker].size());
+        });
+    }
+
+    input->Seek(input_offset + data_size, SeekDirection::SEEK_FILE_BEGIN);
+    return ok;
+}
+
+bool ParallelDecrypt(const IRandomAccessDecryptor &decryptor, uint8_t *output, const uint8_t *input,
+                     size_t thread_count)
+{
+    const auto data_size = decryptor.GetDataSize();
+    const auto batch_count = (data_size + kParallelDecryptBatchSize - 1) / kParallelDecryptBatchSize;
+
+    std::atomic<bool> failed{false};
+    RunOnThreads(batch_count, thread_count, [&](size_t /*worker*/, size_t batch) {
+        auto offset = batch * kParallelDecryptBatchSize;
+        auto len = std::min(kParallelDecryptBatchSize, data_size - offset);
+        std::copy_n(input + offset, len, output + offset);
+        if (!decryptor.DecryptAt(offset, output + offset, len))
+        {
+            failed = true;
+        }
+    });
+    return !failed;
+}
+
+TransformResult ParallelTransformBlocks(IWriteable *output, IReadSeekable *input, size_t input_offset,
+                                        size_t input_len, size_t input_block_size, size_t output_block_size,
+                                        size_t thread_count, const BlockTransform &transform_block)
+{
+    const auto block_count = (input_len + input_block_size - 1) / input_block_size;
+    const auto worker_count = std::min(thread_count, block_count);
+
+    std::vector<std::vector<uint8_t>> buffers(worker_count,
+                                              std::vector<uint8_t>(std::max(input_block_size, output_block_size)));
+    std::vector<size_t> output_lens(worker_count);
+    std::vector<TransformResult> states(worker_count);
+    SharedReader reader{input};
+
+    // Failures are reported at commit time, so that the first failing block (in payload order) sets the result.
+    TransformResult result{TransformResult::OK};
+    RunOnThreadsInOrder(
+        block_count, worker_count,
+        [&](size_t worker, size_t block) {
+            auto offset = block * input_block_size;
+            auto len = std::min(input_block_size, input_len - offset);
+            auto *buffer = buffers[worker].data();
+            states[worker] = reader.ReadExactAt(input_offset + offset, buffer, len)
+                                 ? transform_block(buffer, len, output_lens[worker])
+                                 : TransformResult::ERROR_INSUFFICIENT_INPUT;
+            return true;
+        },
+        [&](size_t worker, size_t /*block*/) {
+            result = states[worker];
+            if (result == TransformResult::OK && !output->Write(buffers[worker].data(), output_lens[worker]))
+            {
+                result = TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+            }
+            return result == TransformResult::OK;
+        });
+
+    input->Seek(input_offset + input_len, SeekDirection::SEEK_FILE_BEGIN);
+    return result;
+}
+
+} // namespace parakeet_crypto::utils
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/TransformResult.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace parakeet_crypto::utils
+{
+
+/**
+ * @brief Amount of data decrypted by a worker at a time.
+ */
+constexpr size_t kParallelDecryptBatchSize = static_cast<size_t>(1024 * 1024);
+
+/**
+ * @brief Decrypt the payload of a file on several threads, in batches of `kParallelDecryptBatchSize`.
+ *
+ * Each worker reads a batch (`ReadAt`, serialized unless the input supports concurrent reads), decrypts it, then
+ * writes it. If the output supports concurrent `WriteAt`, the payload size is reserved at the current position of
+ * the output (`ReserveForWriteAt`), and batches are written there as soon as they are ready; otherwise they are
+ * written in order with `Write`, and at most one batch per worker is held in memory. Either way, the output
+ * continues after the payload.
+ *
+ * @param decryptor Decryptor of the payload; `DecryptAt` is called concurrently.
+ * @param output Output stream.
+ * @param input Input stream; left at the end of the payload.
+ * @param input_offset Offset of the payload in `input`.
+ * @param thread_count Number of threads, including the calling thread.
+ * @return false Read, decryption or write failed.
+ */
+bool ParallelDecrypt(const IRandomAccessDecryptor &decryptor, IWriteable *output, IReadSeekable *input,
+                     size_t input_offset, size_t thread_count);
+
+/**
+ * @brief Same as `ParallelDecrypt`, from a buffer holding the encrypted payload to a buffer of the same size.
+ */
+bool ParallelDecrypt(const IRandomAccessDecryptor &decryptor, uint8_t *output, const uint8_t *input,
+                     size_t thread_count);
+
+/**
+ * @brief Transform `buffer` in place: `len` bytes of input, up to `output_block_size` bytes of output (its length is
+ *        set to `output_len`). Called concurrently.
+ */
+using BlockTransform = std::function<TransformResult(uint8_t *buffer, size_t len, size_t &output_len)>;
+
+/**
+ * @brief Transform a payload made of independent blocks on several threads, for formats whose blocks change size
+ *        (e.g. padded blocks of JOOX).
+ *
+ * Each worker reads an input block (`ReadAt`, serialized unless the input supports concurrent reads), transforms it
+ * with `transform_block`, then writes it in order with `Write`. At most one block per worker is held in memory.
+ *
+ * @param input Input stream; left at the end of the payload.
+ * @param input_offset Offset of the payload in `input`.
+ * @param input_len Length of the payload. Every block but the last is `input_block_size` bytes long.
+ * @param output_block_size Maximum length of a transformed block.
+ * @param thread_count Number of threads, including the calling thread.
+ * @return TransformResult `OK`, or the error of the first failing block, in payload order: `ERROR_INSUFFICIENT_INPUT`
+ *         if its read failed, `ERROR_IO_OUTPUT_UNKNOWN` if its write failed, or the result of `transform_block`.
+ */
+TransformResult ParallelTransformBlocks(IWriteable *output, IReadSeekable *input, size_t input_offset,
+                                        size_t input_len, size_t input_block_size, size_t output_block_size,
+                                        size_t thread_count, const BlockTransform &transform_block);
+
+} // namespace parakeet_crypto::utils
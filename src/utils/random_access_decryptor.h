@@ -0,0 +1,113 @@
+#pragma once
+
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace parakeet_crypto::utils
+{
+
+/**
+ * @brief Base class of random access decryptors. Performs the bounds check, so implementations only need to
+ *        provide `DecryptRange`.
+ */
+class RandomAccessDecryptor : public IRandomAccessDecryptor
+{
+  private:
+    const char *name_{};
+    size_t data_offset_{};
+    size_t data_size_{};
+
+  public:
+    RandomAccessDecryptor(const char *name, size_t data_offset, size_t data_size)
+        : name_(name), data_offset_(data_offset), data_size_(data_size)
+    {
+    }
+
+    [[nodiscard]] const char *GetName() const override
+    {
+        return name_;
+    }
+
+    [[nodiscard]] size_t GetDataOffset() const override
+    {
+        return data_offset_;
+    }
+
+    [[nodiscard]] size_t GetDataSize() const override
+    {
+        return data_size_;
+    }
+
+    [[nodiscard]] bool DecryptAt(size_t offset, uint8_t *buffer, size_t len) const override
+    {
+        return DecryptAt(offset, buffer, buffer, len);
+    }
+
+    /**
+     * @brief Same as `DecryptAt(offset, buffer, len)`, but reads the encrypted data from `src`.
+     *        `dst` and `src` can point to the same buffer.
+     */
+    [[nodiscard]] bool DecryptAt(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const
+    {
+        if (offset > data_size_ || len > data_size_ - offset)
+        {
+            return false;
+        }
+
+        return len == 0 || DecryptRange(offset, dst, src, len);
+    }
+
+  protected:
+    /**
+     * @brief Decrypt a range of the payload, already validated to be within the payload.
+     *
+     * @param offset Offset relative to the payload.
+     * @param dst Output buffer.
+     * @param src Encrypted data. Can be the same as `dst`.
+     * @param len Number of bytes to process; always greater than 0.
+     */
+    [[nodiscard]] virtual bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const = 0;
+};
+
+/**
+ * @brief Wrap a decryptor created from a slice of the file (e.g. a container with its own header),
+ *        and report the payload offset relative to the full file.
+ */
+class OffsetRandomAccessDecryptor final : public IRandomAccessDecryptor
+{
+  private:
+    std::unique_ptr<IRandomAccessDecryptor> parent_{};
+    size_t slice_offset_{};
+
+  public:
+    OffsetRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> parent, size_t slice_offset)
+        : parent_(std::move(parent)), slice_offset_(slice_offset)
+    {
+    }
+
+    [[nodiscard]] const char *GetName() const override
+    {
+        return parent_->GetName();
+    }
+
+    [[nodiscard]] size_t GetDataOffset() const override
+    {
+        return slice_offset_ + parent_->GetDataOffset();
+    }
+
+    [[nodiscard]] size_t GetDataSize() const override
+    {
+        return parent_->GetDataSize();
+    }
+
+    [[nodiscard]] bool DecryptAt(size_t offset, uint8_t *buffer, size_t len) const override
+    {
+        return parent_->DecryptAt(offset, buffer, len);
+    }
+};
+
+} // namespace parakeet_crypto::utils
@@ -0,0 +1,14 @@
+#pragma once
+
+// Kernels for a wider instruction set than the build target, picked at runtime (see `utils::GetXorKernel`).
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PARAKEET_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PARAKEET_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PARAKEET_TARGET(isa)
+#endif
@@ -0,0 +1,209 @@
+#include "streaming_decryptor.h"
+#include "utils/paged_reader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace parakeet_crypto::utils
+{
+
+namespace
+{
+
+/**
+ * @brief The bytes received so far, as the beginning of a file.
+ *        Remembers how far the parser tried to read past them, i.e. how much data it needs.
+ */
+class ReceivedHeaderStream final : public IReadSeekable
+{
+  private:
+    // Large enough for any file, small enough to not overflow when parsers add offsets to it.
+    static constexpr size_t kUnknownFileSize = std::numeric_limits<size_t>::max() / 2;
+
+    const std::vector<uint8_t> &data_;
+    size_t size_{};
+    size_t offset_{0};
+    size_t required_size_{0};
+
+  public:
+    ReceivedHeaderStream(const std::vector<uint8_t> &data, bool is_complete)
+        : data_(data), size_(is_complete ? data.size() : kUnknownFileSize)
+    {
+    }
+
+    [[nodiscard]] bool IsReadPastEnd() const
+    {
+        return required_size_ > data_.size();
+    }
+
+    /**
+     * @brief Number of bytes of the file that the parser tried to read.
+     */
+    [[nodiscard]] size_t GetRequiredSize() const
+    {
+        return required_size_;
+    }
+
+    size_t Read(uint8_t *buffer, size_t len) override
+    {
+        auto bytes_read = ReadAt(offset_, buffer, len);
+        offset_ += bytes_read;
+        return bytes_read;
+    }
+    void Seek(size_t position, SeekDirection seek_dir) override
+    {
+        size_t next_offset{0};
+        switch (seek_dir)
+        {
+        case SeekDirection::SEEK_FILE_BEGIN:
+            next_offset = position;
+            break;
+        case SeekDirection::SEEK_CURRENT_POSITION:
+            next_offset = offset_ + position;
+            break;
+        case SeekDirection::SEEK_FILE_END:
+            next_offset = size_ + position;
+            break;
+        default:
+            return;
+        }
+        offset_ = std::min(next_offset, size_);
+    }
+    size_t GetSize() override
+    {
+        return size_;
+    }
+    size_t GetOffset() override
+    {
+        return offset_;
+    }
+    size_t ReadAt(size_t offset, uint8_t *buffer, size_t len) override
+    {
+        auto available = offset < data_.size() ? data_.size() - offset : 0;
+        if (len > available)
+        {
+            required_size_ = std::max(required_size_, offset + std::min(len, kUnknownFileSize));
+            len = available;
+        }
+        if (len > 0)
+        {
+            std::copy_n(&data_[offset], len, buffer);
+        }
+        return len;
+    }
+};
+
+} // namespace
+
+TransformResult RandomAccessStreamingDecryptor::ParseHeader(bool is_final)
+{
+    ReceivedHeaderStream header_stream{header_, is_final};
+    auto result = transformer_.CreateRandomAccessDecryptor(decryptor_, &header_stream);
+    if (result != TransformResult::OK)
+    {
+        decryptor_.reset();
+        if (!is_final && header_stream.IsReadPastEnd())
+        {
+            header_required_ = header_stream.GetRequiredSize();
+            return TransformResult::OK; // wait for more data
+        }
+        return result;
+    }
+
+    work_.resize(kDecryptionPageSize);
+    return TransformResult::OK;
+}
+
+TransformResult RandomAccessStreamingDecryptor::DecryptChunk(const uint8_t *input, size_t len, IWriteable *output)
+{
+    const auto data_offset = decryptor_->GetDataOffset();
+    while (len > 0)
+    {
+        // Skip the header
+        if (offset_ < data_offset)
+        {
+            auto skip_len = std::min(len, data_offset - offset_);
+            input += skip_len;
+            len -= skip_len;
+            offset_ += skip_len;
+            continue;
+        }
+
+        auto process_len = std::min(len, work_.size());
+        std::copy_n(input, process_len, work_.begin());
+        if (!decryptor_->DecryptAt(offset_ - data_offset, work_.data(), process_len))
+        {
+            return TransformResult::ERROR_INVALID_KEY;
+        }
+        if (!output->Write(work_.data(), process_len))
+        {
+            return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+        }
+
+        input += process_len;
+        len -= process_len;
+        offset_ += process_len;
+    }
+
+    return TransformResult::OK;
+}
+
+TransformResult RandomAccessStreamingDecryptor::Update(const uint8_t *input, size_t len, IWriteable *output)
+{
+    if (error_ != TransformResult::OK)
+    {
+        return error_;
+    }
+
+    if (!decryptor_)
+    {
+        header_.insert(header_.end(), input, input + len);
+        if (header_.size() < header_required_)
+        {
+            return TransformResult::OK; // the parser would stop at the same place
+        }
+
+        error_ = ParseHeader(false);
+        if (error_ == TransformResult::OK && decryptor_)
+        {
+            error_ = DecryptChunk(header_.data(), header_.size(), output);
+            header_ = std::vector<uint8_t>{};
+        }
+        return error_;
+    }
+
+    error_ = DecryptChunk(input, len, output);
+    return error_;
+}
+
+TransformResult RandomAccessStreamingDecryptor::Final(IWriteable *output)
+{
+    if (error_ != TransformResult::OK)
+    {
+        return error_;
+    }
+
+    if (!decryptor_)
+    {
+        // Header was never complete: parse it again, now that the file size is known.
+        error_ = ParseHeader(true);
+        if (error_ != TransformResult::OK)
+        {
+            return error_;
+        }
+        error_ = DecryptChunk(header_.data(), header_.size(), output);
+        header_ = std::vector<uint8_t>{};
+    }
+
+    if (error_ == TransformResult::OK && offset_ < decryptor_->GetDataOffset())
+    {
+        error_ = TransformResult::ERROR_INSUFFICIENT_INPUT; // ended within the header
+    }
+    return error_;
+}
+
+} // namespace parakeet_crypto::utils
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "parakeet-crypto/IRandomAccessDecryptor.h"
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/IStreamingDecryptor.h"
+#include "parakeet-crypto/ITransformer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace parakeet_crypto::utils
+{
+
+/**
+ * @brief Streaming decryptor for formats with a random access decryptor.
+ *
+ * The file header is buffered until `ITransformer::CreateRandomAccessDecryptor` can parse it; the total file size
+ * is unknown at that point, so the header is presented as the start of a file of unknown size. Past the header,
+ * each chunk is decrypted as it arrives, and nothing is carried over between calls.
+ */
+class RandomAccessStreamingDecryptor final : public IStreamingDecryptor
+{
+  private:
+    ITransformer &transformer_;
+    const char *name_{};
+    std::unique_ptr<IRandomAccessDecryptor> decryptor_{};
+    TransformResult error_{TransformResult::OK};
+
+    std::vector<uint8_t> header_{};
+    size_t header_required_{0}; // bytes the header parser asked for at its last attempt
+    std::vector<uint8_t> work_{};
+    size_t offset_{0}; // offset in the encrypted file
+
+    TransformResult ParseHeader(bool is_final);
+    TransformResult DecryptChunk(const uint8_t *input, size_t len, IWriteable *output);
+
+  public:
+    RandomAccessStreamingDecryptor(ITransformer &transformer)
+        : transformer_(transformer), name_(transformer.GetName())
+    {
+    }
+
+    [[nodiscard]] const char *GetName() const override
+    {
+        return name_;
+    }
+
+    TransformResult Update(const uint8_t *input, size_t len, IWriteable *output) override;
+    TransformResult Final(IWriteable *output) override;
+};
+
+} // namespace parakeet_crypto::utils
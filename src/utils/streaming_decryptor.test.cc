@@ -0,0 +1,109 @@
+#include "streaming_decryptor.h"
+#include "random_access_decryptor.h"
+
+#include "parakeet-crypto/IStream.h"
+#include "parakeet-crypto/ITransformer.h"
+#include "parakeet-crypto/StreamHelper.h"
+#include "utils/endian_helper.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+namespace
+{
+
+class XorDecryptor final : public utils::RandomAccessDecryptor
+{
+  public:
+    XorDecryptor(size_t data_offset, size_t data_size) : RandomAccessDecryptor("XOR", data_offset, data_size)
+    {
+    }
+
+  protected:
+    bool DecryptRange(size_t /*offset*/, uint8_t *dst, const uint8_t *src, size_t len) const override
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            dst[i] = src[i] ^ 0x5A;
+        }
+        return true;
+    }
+};
+
+// Header: a 4-byte length, then that many bytes. Counts the attempts to parse it.
+class LengthPrefixedTransformer final : public ITransformer
+{
+  public:
+    size_t parse_count_{0};
+
+    const char *GetName() override
+    {
+        return "LengthPrefixed";
+    }
+
+    TransformResult Transform(IWriteable * /*output*/, IReadSeekable * /*input*/) override
+    {
+        return TransformResult::ERROR_NOT_IMPLEMENTED;
+    }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        parse_count_++;
+        std::array<uint8_t, 4> size_field{};
+        if (!input->ReadExactAt(0, size_field.data(), size_field.size()))
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+        std::vector<uint8_t> header(ReadLittleEndian<uint32_t>(size_field.data()));
+        if (!input->ReadExactAt(size_field.size(), header.data(), header.size()))
+        {
+            return TransformResult::ERROR_INSUFFICIENT_INPUT;
+        }
+
+        auto data_offset = size_field.size() + header.size();
+        decryptor = std::make_unique<XorDecryptor>(data_offset, input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+};
+
+} // namespace
+
+TEST(RandomAccessStreamingDecryptor, ParsesHeaderOnceEnoughIsBuffered)
+{
+    std::vector<uint8_t> file{0x00, 0x10, 0x00, 0x00}; // 4KiB header
+    file.resize(file.size() + 0x1000, 0xEE);
+    std::vector<uint8_t> plain(1000);
+    for (size_t i = 0; i < plain.size(); i++)
+    {
+        plain[i] = static_cast<uint8_t>(i);
+        file.push_back(plain[i] ^ 0x5A);
+    }
+
+    LengthPrefixedTransformer transformer{};
+    utils::RandomAccessStreamingDecryptor decryptor{transformer};
+    OutputMemoryStream output{};
+    for (auto value : file)
+    {
+        ASSERT_EQ(decryptor.Update(&value, 1, &output), TransformResult::OK);
+    }
+    ASSERT_EQ(decryptor.Final(&output), TransformResult::OK);
+    ASSERT_THAT(output.GetData(), ContainerEq(plain));
+
+    // Once after the first byte, once the size field is complete, once the header is complete.
+    ASSERT_EQ(transformer.parse_count_, 3);
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
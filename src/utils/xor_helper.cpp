@@ -0,0 +1,260 @@
+#include "xor_helper.h"
+#include "simd_target.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if PARAKEET_SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace parakeet_crypto::utils
+{
+
+namespace
+{
+
+using XorBytesFunction = void (*)(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len);
+
+void XorBytesScalar(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    // Word at a time; `memcpy` keeps the unaligned access well-defined.
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t))
+    {
+        uint64_t data{};
+        uint64_t mask{};
+        std::memcpy(&data, src, sizeof(data));
+        std::memcpy(&mask, key, sizeof(mask));
+        data ^= mask;
+        std::memcpy(dst, &data, sizeof(data));
+
+        dst += sizeof(uint64_t);
+        src += sizeof(uint64_t);
+        key += sizeof(uint64_t);
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = src[i] ^ key[i];
+    }
+}
+
+#if PARAKEET_SIMD_X86
+
+// NOLINTBEGIN(*-reinterpret-cast)
+
+PARAKEET_TARGET("sse2")
+void XorBytesSSE2(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    constexpr size_t kLaneSize = sizeof(__m128i);
+    for (; len >= kLaneSize; len -= kLaneSize)
+    {
+        auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_xor_si128(data, mask));
+
+        dst += kLaneSize;
+        src += kLaneSize;
+        key += kLaneSize;
+    }
+    XorBytesScalar(dst, src, key, len);
+}
+
+PARAKEET_TARGET("avx2")
+void XorBytesAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    constexpr size_t kLaneSize = sizeof(__m256i);
+    for (; len >= kLaneSize * 2; len -= kLaneSize * 2)
+    {
+        auto data1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        auto data2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + kLaneSize));
+        auto mask1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key));
+        auto mask2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key + kLaneSize));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_xor_si256(data1, mask1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + kLaneSize), _mm256_xor_si256(data2, mask2));
+
+        dst += kLaneSize * 2;
+        src += kLaneSize * 2;
+        key += kLaneSize * 2;
+    }
+    XorBytesSSE2(dst, src, key, len);
+}
+
+PARAKEET_TARGET("avx512f")
+void XorBytesAVX512(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    constexpr size_t kLaneSize = sizeof(__m512i);
+    for (; len >= kLaneSize; len -= kLaneSize)
+    {
+        auto data = _mm512_loadu_si512(src);
+        auto mask = _mm512_loadu_si512(key);
+        _mm512_storeu_si512(dst, _mm512_xor_si512(data, mask));
+
+        dst += kLaneSize;
+        src += kLaneSize;
+        key += kLaneSize;
+    }
+    XorBytesAVX2(dst, src, key, len);
+}
+
+// NOLINTEND(*-reinterpret-cast)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+bool IsX86FeatureSupported(XorKernel kernel)
+{
+    constexpr int kLeafExtendedFeatures = 7;
+    constexpr int kEcxOSXSAVE = 1 << 27;
+    constexpr int kEcxAVX = 1 << 28;
+    constexpr int kEbxAVX2 = 1 << 5;
+    constexpr int kEbxAVX512F = 1 << 16;
+    constexpr unsigned kXcrYmmState = 0x06;
+    constexpr unsigned kXcrZmmState = 0xE6;
+
+    std::array<int, 4> regs{}; // eax, ebx, ecx, edx
+    __cpuid(regs.data(), 1);
+    const bool os_avx = (regs[2] & kEcxOSXSAVE) != 0 && (regs[2] & kEcxAVX) != 0;
+    const auto xcr0 = os_avx ? static_cast<unsigned>(_xgetbv(0)) : 0U;
+
+    __cpuidex(regs.data(), kLeafExtendedFeatures, 0);
+    switch (kernel)
+    {
+    case XorKernel::AVX2:
+        return (xcr0 & kXcrYmmState) == kXcrYmmState && (regs[1] & kEbxAVX2) != 0;
+    case XorKernel::AVX512:
+        return (xcr0 & kXcrZmmState) == kXcrZmmState && (regs[1] & kEbxAVX512F) != 0;
+    default:
+        return true; // SSE2 is part of the x86-64 baseline.
+    }
+}
+#else
+bool IsX86FeatureSupported(XorKernel kernel)
+{
+    // `__builtin_cpu_supports` also checks that the OS saves the wider registers (XGETBV).
+    __builtin_cpu_init();
+    switch (kernel)
+    {
+    case XorKernel::SSE2:
+        return __builtin_cpu_supports("sse2") != 0;
+    case XorKernel::AVX2:
+        return __builtin_cpu_supports("avx2") != 0;
+    case XorKernel::AVX512:
+        return __builtin_cpu_supports("avx512f") != 0;
+    default:
+        return true;
+    }
+}
+#endif
+
+#endif // PARAKEET_SIMD_X86
+
+XorBytesFunction GetXorBytesFunction(XorKernel kernel)
+{
+    switch (kernel)
+    {
+#if PARAKEET_SIMD_X86
+    case XorKernel::SSE2:
+        return XorBytesSSE2;
+    case XorKernel::AVX2:
+        return XorBytesAVX2;
+    case XorKernel::AVX512:
+        return XorBytesAVX512;
+#endif
+    default:
+        return XorBytesScalar;
+    }
+}
+
+XorKernel SelectXorKernel()
+{
+    for (auto kernel : {XorKernel::AVX512, XorKernel::AVX2, XorKernel::SSE2})
+    {
+        if (IsXorKernelSupported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return XorKernel::SCALAR;
+}
+
+} // namespace
+
+bool IsXorKernelSupported(XorKernel kernel)
+{
+    if (kernel == XorKernel::SCALAR)
+    {
+        return true;
+    }
+
+#if PARAKEET_SIMD_X86
+    return IsX86FeatureSupported(kernel);
+#else
+    return false;
+#endif
+}
+
+XorKernel GetXorKernel()
+{
+    static const XorKernel kSelectedKernel = SelectXorKernel();
+    return kSelectedKernel;
+}
+
+const char *GetXorKernelName(XorKernel kernel)
+{
+    switch (kernel)
+    {
+    case XorKernel::SSE2:
+        return "sse2";
+    case XorKernel::AVX2:
+        return "avx2";
+    case XorKernel::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+void XorBytes(XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    assert(IsXorKernelSupported(kernel));
+    GetXorBytesFunction(kernel)(dst, src, key, len);
+}
+
+void XorBytes(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len)
+{
+    static const XorBytesFunction kXorBytes = GetXorBytesFunction(GetXorKernel());
+    kXorBytes(dst, src, key, len);
+}
+
+PeriodicXorKey::PeriodicXorKey(const uint8_t *key, size_t key_len) : key_len_(key_len)
+{
+    assert(key_len > 0);
+
+    // One period, followed by `kMinExpandedWindow` bytes of its repetition: from any offset within the first
+    //   period there are at least `kMinExpandedWindow` bytes of contiguous keystream.
+    expanded_key_.resize(key_len + kMinExpandedWindow);
+    for (size_t i = 0; i < expanded_key_.size(); i += key_len)
+    {
+        std::copy_n(key, std::min(key_len, expanded_key_.size() - i), &expanded_key_[i]);
+    }
+}
+
+void PeriodicXorKey::Apply(uint8_t *dst, const uint8_t *src, size_t len, size_t offset) const
+{
+    auto key_offset = offset % key_len_;
+    while (len > 0)
+    {
+        auto process_len = std::min(len, expanded_key_.size() - key_offset);
+        XorBytes(dst, src, &expanded_key_[key_offset], process_len);
+
+        dst += process_len;
+        src += process_len;
+        len -= process_len;
+        key_offset = (key_offset + process_len) % key_len_;
+    }
+}
+
+} // namespace parakeet_crypto::utils
@@ -5,40 +5,60 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <vector>
 
 namespace parakeet_crypto::utils
 {
 
+enum class XorKernel
+{
+    SCALAR = 0,
+    SSE2,
+    AVX2,
+    AVX512,
+};
+
+/**
+ * @brief Check if the CPU (and the OS) can run the given kernel.
+ */
+bool IsXorKernelSupported(XorKernel kernel);
+
+/**
+ * @brief The fastest supported kernel, detected with `cpuid` on first use.
+ */
+XorKernel GetXorKernel();
+
+const char *GetXorKernelName(XorKernel kernel);
+
+/**
+ * @brief `dst[i] = src[i] ^ key[i]`, with the given kernel; it must be supported.
+ */
+void XorBytes(XorKernel kernel, uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len);
+
+/**
+ * @brief `dst[i] = src[i] ^ key[i]`; `dst` and `src` can point to the same buffer.
+ */
+void XorBytes(uint8_t *dst, const uint8_t *src, const uint8_t *key, size_t len);
+
+/**
+ * @brief `dst[i] = src[i] ^ key[(offset + i) % key_len]`.
+ *        Each contiguous run of the key is one `XorBytes` call; short keys applied to long inputs should use
+ *        `PeriodicXorKey` instead.
+ */
 inline void XorFromOffset(uint8_t *dst, const uint8_t *src, size_t data_len, //
                           const uint8_t *key, size_t key_len,                //
                           size_t offset)
 {
-    auto *dst_end = dst + data_len;
-    auto *dst_end_last_block = dst_end - key_len;
-
-    if (offset % key_len != 0)
+    auto key_offset = offset % key_len;
+    while (data_len > 0)
     {
-        auto block_offset = offset % key_len;
-        const auto *stc_stop = &dst[block_offset];
-        const auto *p_key = &key[block_offset];
-        while (dst < stc_stop)
-        {
-            *dst++ = *src++ ^ *p_key++;
-        }
-    }
-
-    // Process in blocks, that can be optimised by compiler.
-    while (dst < dst_end_last_block)
-    {
-        for (auto i = 0; i < key_len; i++)
-        {
-            *dst++ = *src++ ^ key[i];
-        }
-    }
+        auto process_len = std::min(data_len, key_len - key_offset);
+        XorBytes(dst, src, &key[key_offset], process_len);
 
-    while (dst < dst_end)
-    {
-        *dst++ = *src++ ^ *key++;
+        dst += process_len;
+        src += process_len;
+        data_len -= process_len;
+        key_offset = 0;
     }
 }
 
@@ -50,8 +70,6 @@ inline void XorFromOffset(uint8_t *dst, size_t dst_len, const uint8_t *key, size
 inline void XorBlockFromOffset(uint8_t *dst, const uint8_t *src, size_t data_len, size_t block_len, const uint8_t *key,
                                size_t key_len, size_t offset)
 {
-    const auto *p_dst_end = dst + data_len;
-
     if (auto prev_block_offset = offset % block_len; prev_block_offset > 0)
     {
         auto process_len = std::min(data_len, block_len - prev_block_offset);
@@ -62,16 +80,15 @@ inline void XorBlockFromOffset(uint8_t *dst, const uint8_t *src, size_t data_len
         data_len -= process_len;
     }
 
-    for (const auto *p_stop = p_dst_end - block_len; dst < p_stop;)
+    for (; data_len >= block_len; data_len -= block_len)
     {
         XorFromOffset(dst, src, block_len, key, key_len, 0);
 
         src += block_len;
         dst += block_len;
-        data_len -= block_len;
     }
 
-    if (dst < p_dst_end)
+    if (data_len > 0)
     {
         XorFromOffset(dst, src, data_len, key, key_len, 0);
     }
@@ -82,4 +99,44 @@ inline void XorBlockFromOffset(uint8_t *dst, size_t data_len, size_t block_len,
 {
     XorBlockFromOffset(dst, dst, data_len, block_len, key, key_len, offset);
 }
+
+/**
+ * @brief A periodic key, pre-expanded so that each call to the SIMD kernels covers several kilobytes,
+ *        regardless of the key period or of the offset.
+ */
+class PeriodicXorKey
+{
+  public:
+    static constexpr size_t kMinExpandedWindow = 4096;
+
+  private:
+    size_t key_len_{};
+    std::vector<uint8_t> expanded_key_{};
+
+  public:
+    PeriodicXorKey(const uint8_t *key, size_t key_len);
+
+    template <typename Container>
+    explicit PeriodicXorKey(const Container &key) : PeriodicXorKey(key.data(), key.size())
+    {
+    }
+
+    [[nodiscard]] size_t GetKeyLength() const
+    {
+        return key_len_;
+    }
+
+    /**
+     * @brief Keystream from `offset`: `key[(offset + i) % key_len]`, for `i` up to `kMinExpandedWindow`.
+     */
+    [[nodiscard]] const uint8_t *GetWindow(size_t offset) const
+    {
+        return &expanded_key_[offset % key_len_];
+    }
+
+    /**
+     * @brief `dst[i] = src[i] ^ key[(offset + i) % key_len]`; `dst` and `src` can point to the same buffer.
+     */
+    void Apply(uint8_t *dst, const uint8_t *src, size_t len, size_t offset) const;
+};
 } // namespace parakeet_crypto::utils
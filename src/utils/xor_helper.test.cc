@@ -0,0 +1,118 @@
+#include "utils/xor_helper.h"
+
+#include "test/make_sequence.test.hh"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+using ::testing::ContainerEq;
+
+using namespace parakeet_crypto;
+
+// NOLINTBEGIN(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+
+TEST(Utils_Xor, XorFromOffset)
+{
+    std::array<uint8_t, 5> key = {1, 2, 3, 4, 5};
+    std::vector<uint8_t> data(13, 0);
+    std::vector<uint8_t> expected = {4, 5, 1, 2, 3, 4, 5, 1, 2, 3, 4, 5, 1};
+
+    utils::XorFromOffset(data.data(), data.size(), key.data(), key.size(), 8);
+    ASSERT_THAT(data, ContainerEq(expected));
+}
+
+TEST(Utils_Xor, XorFromOffsetShortInput)
+{
+    std::array<uint8_t, 5> key = {1, 2, 3, 4, 5};
+    std::vector<uint8_t> src = {0x10, 0x20};
+    std::vector<uint8_t> dst(2, 0);
+    std::vector<uint8_t> expected = {0x12, 0x23};
+
+    utils::XorFromOffset(dst.data(), src.data(), src.size(), key.data(), key.size(), 6);
+    ASSERT_THAT(dst, ContainerEq(expected));
+}
+
+TEST(Utils_Xor, XorBlockFromOffset)
+{
+    std::array<uint8_t, 2> key = {1, 2};
+    std::vector<uint8_t> data(8, 0);
+    std::vector<uint8_t> expected = {2, 1, 1, 2, 1, 1, 2, 1};
+
+    // block of 3 bytes, key restarts at every block; start at the 2nd byte of the first block.
+    utils::XorBlockFromOffset(data.data(), data.size(), 3, key.data(), key.size(), 1);
+    ASSERT_THAT(data, ContainerEq(expected));
+}
+
+TEST(Utils_Xor, XorBytesAllKernels)
+{
+    const auto src = test::make_sequence(1000, 3);
+    const auto key = test::make_sequence(1000, 91);
+
+    for (auto kernel : {utils::XorKernel::SCALAR, utils::XorKernel::SSE2, utils::XorKernel::AVX2,
+                        utils::XorKernel::AVX512})
+    {
+        if (!utils::IsXorKernelSupported(kernel))
+        {
+            continue;
+        }
+
+        // Odd lengths and misaligned pointers, to cover the tails of each kernel.
+        for (size_t start : {0, 1, 13})
+        {
+            for (size_t len : {0, 1, 15, 16, 31, 63, 64, 65, 130, 257, 900})
+            {
+                std::vector<uint8_t> expected(len);
+                std::vector<uint8_t> actual(len);
+                for (size_t i = 0; i < len; i++)
+                {
+                    expected[i] = src[start + i] ^ key[i];
+                }
+                utils::XorBytes(kernel, actual.data(), &src[start], key.data(), len);
+                ASSERT_THAT(actual, ContainerEq(expected)) << utils::GetXorKernelName(kernel) << ", len=" << len;
+            }
+        }
+    }
+
+    ASSERT_TRUE(utils::IsXorKernelSupported(utils::GetXorKernel()));
+}
+
+TEST(Utils_Xor, PeriodicXorKey)
+{
+    for (size_t key_len : {5, 32, 128, 256, 0x7fff})
+    {
+        const auto key = test::make_sequence(key_len, 17);
+        const utils::PeriodicXorKey periodic_key{key};
+        ASSERT_EQ(periodic_key.GetKeyLength(), key_len);
+
+        const auto src = test::make_sequence(3 * 0x7fff + 11, 5);
+        for (size_t offset : {size_t{0}, size_t{3}, key_len - 1, size_t{0x7fff + 7}, size_t{1} << 40U})
+        {
+            const auto *window = periodic_key.GetWindow(offset);
+            for (size_t i = 0; i < utils::PeriodicXorKey::kMinExpandedWindow; i++)
+            {
+                ASSERT_EQ(window[i], key[(offset + i) % key_len]) << "key_len=" << key_len << ", offset=" << offset;
+            }
+
+            for (size_t len : {size_t{1}, size_t{100}, size_t{4097}, src.size()})
+            {
+                std::vector<uint8_t> expected(len);
+                for (size_t i = 0; i < len; i++)
+                {
+                    expected[i] = src[i] ^ key[(offset + i) % key_len];
+                }
+
+                std::vector<uint8_t> actual(src.begin(), src.begin() + static_cast<std::ptrdiff_t>(len));
+                periodic_key.Apply(actual.data(), actual.data(), len, offset); // in place
+                ASSERT_THAT(actual, ContainerEq(expected)) << "key_len=" << key_len << ", offset=" << offset;
+            }
+        }
+    }
+}
+
+// NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -42,4 +42,17 @@ TEST(Xiami, TestDecryption)
     test::should_decrypt_to_fixture("test.xm", transformer);
 }
 
+TEST(Xiami, RandomAccess)
+{
+    auto transformer = transformer::CreateXiamiDecryptionTransformer();
+    test::should_random_access_decrypt_to_fixture("test.xm", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test.xm", transformer);
+}
+
+TEST(Xiami, StreamingDecryption)
+{
+    auto transformer = transformer::CreateXiamiDecryptionTransformer();
+    test::should_stream_decrypt_to_fixture("test.xm", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
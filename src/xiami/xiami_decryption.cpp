@@ -2,10 +2,14 @@
 #include "parakeet-crypto/transformer/xiami.h"
 #include "utils/endian_helper.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <memory>
+#include <utility>
 
 namespace parakeet_crypto::transformer
 {
@@ -21,27 +25,55 @@ namespace parakeet_crypto::transformer
 //   0x10  Plaintext data
 //   ????  Encrypted data
 
-class XiamiDecryptionTransformer final : public ITransformer
+class XiamiRandomAccessDecryptor final : public utils::RandomAccessDecryptor
 {
+  private:
+    size_t copy_len_{};
+    uint8_t key_{};
+
   public:
-    XiamiDecryptionTransformer() = default;
+    XiamiRandomAccessDecryptor(size_t copy_len, uint8_t key, size_t data_offset, size_t data_size)
+        : RandomAccessDecryptor("Xiami", data_offset, data_size), copy_len_(copy_len), key_(key)
+    {
+    }
 
-    const char *GetName() override
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
     {
-        return "Xiami";
+        if (offset < copy_len_)
+        {
+            auto copy_len = std::min(len, copy_len_ - offset);
+            std::copy_n(src, copy_len, dst);
+
+            dst += copy_len;
+            src += copy_len;
+            len -= copy_len;
+        }
+
+        std::transform(src, src + len, dst, [&](auto value) {
+            return static_cast<uint8_t>(key_ - value); //
+        });
+        return true;
     }
+};
 
-    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+class XiamiDecryptionTransformer final : public ITransformer
+{
+  private:
+    static constexpr size_t kHeaderSize = 0x10;
+
+    static TransformResult CreateDecryptor(std::unique_ptr<XiamiRandomAccessDecryptor> &decryptor,
+                                           IReadSeekable *input)
     {
         constexpr std::array<uint8_t, 4> kMagicHeader1 = {'i', 'f', 'm', 't'};
         constexpr size_t kMagicHeader1Offset = 0x00;
         constexpr std::array<uint8_t, 4> kMagicHeader2 = {0xfe, 0xfe, 0xfe, 0xfe};
         constexpr size_t kMagicHeader2Offset = 0x08;
 
-        constexpr size_t kHeaderSize = 0x10;
         constexpr size_t kHeaderKeyOffset = 0x0C;
         constexpr size_t kLittleEndianOffsetMask = 0x00FFFFFF;
 
+        const auto data_offset = input->GetOffset() + kHeaderSize;
         std::array<uint8_t, kHeaderSize> header{};
         if (!input->ReadExact(header.data(), header.size()))
         {
@@ -53,26 +85,51 @@ class XiamiDecryptionTransformer final : public ITransformer
             return TransformResult::ERROR_INVALID_FORMAT;
         }
         size_t copy_len = ReadLittleEndian<uint32_t>(&header.at(kHeaderKeyOffset)) & kLittleEndianOffsetMask;
+        uint8_t key = header.back() - uint8_t{1};
 
-        auto copy_ok = utils::PagedReader{input}.ReadInPages(copy_len, [&](size_t /*offset*/, uint8_t *buff, size_t n) {
-            return output->Write(buff, n); //
-        });
+        decryptor = std::make_unique<XiamiRandomAccessDecryptor>(copy_len, key, data_offset,
+                                                                 input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+
+  public:
+    XiamiDecryptionTransformer() = default;
+
+    const char *GetName() override
+    {
+        return "Xiami";
+    }
 
-        if (!copy_ok)
+    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    {
+        std::unique_ptr<XiamiRandomAccessDecryptor> decryptor{};
+        if (auto result = CreateDecryptor(decryptor, input); result != TransformResult::OK)
         {
-            return TransformResult::ERROR_OTHER;
+            return result;
         }
 
-        uint8_t key = header.back() - uint8_t{1};
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            std::transform(buffer, buffer + n, buffer, [&](auto value) {
-                return static_cast<uint8_t>(key - value); //
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                return decryptor->DecryptAt(offset - decryptor->GetDataOffset(), dst, src, n) && output->Write(dst, n);
             });
-            return output->Write(buffer, n);
-        });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_OTHER;
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::unique_ptr<XiamiRandomAccessDecryptor> result{};
+        auto state = CreateDecryptor(result, input);
+        decryptor = std::move(result);
+        return state;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateXiamiDecryptionTransformer()
@@ -1,39 +1,65 @@
 #include "parakeet-crypto/ITransformer.h"
 #include "parakeet-crypto/transformer/ximalaya.h"
-#include "utils/loop_iterator.h"
 #include "utils/paged_reader.h"
+#include "utils/random_access_decryptor.h"
+#include "utils/streaming_decryptor.h"
 #include "utils/xor_helper.h"
 #include <algorithm>
 #include <array>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
 namespace parakeet_crypto::transformer
 {
 
-class XimalayaTransformer final : public ITransformer
+class XimalayaRandomAccessDecryptor final : public utils::RandomAccessDecryptor
 {
   private:
-    size_t offset_{};
-    std::array<uint16_t, kXimalayaScrambleKeyLen> scramble_key_{};
-    std::vector<uint8_t> content_key_{};
+    // The header is scrambled across its whole range, keep the decrypted copy.
+    std::array<uint8_t, kXimalayaScrambleKeyLen> header_{};
 
   public:
-    XimalayaTransformer(const uint16_t *scramble_key, const uint8_t *content_key, size_t content_key_len)
+    XimalayaRandomAccessDecryptor(const std::array<uint8_t, kXimalayaScrambleKeyLen> &header, size_t data_offset,
+                                  size_t data_size)
+        : RandomAccessDecryptor("Xmly (X2M/X3M)", data_offset, data_size), header_(header)
     {
-        std::copy_n(scramble_key, scramble_key_.size(), scramble_key_.begin());
-        content_key_.assign(content_key, content_key + content_key_len);
     }
 
-    const char *GetName() override
+  protected:
+    bool DecryptRange(size_t offset, uint8_t *dst, const uint8_t *src, size_t len) const override
     {
-        return "Xmly (X2M/X3M)";
+        if (offset < header_.size())
+        {
+            auto header_len = std::min(len, header_.size() - offset);
+            std::copy_n(&header_[offset], header_len, dst);
+
+            dst += header_len;
+            src += header_len;
+            len -= header_len;
+        }
+
+        // Transparent copy.
+        if (dst != src)
+        {
+            std::copy_n(src, len, dst);
+        }
+        return true;
     }
+};
 
-    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+class XimalayaTransformer final : public ITransformer
+{
+  private:
+    size_t offset_{};
+    std::array<uint16_t, kXimalayaScrambleKeyLen> scramble_key_{};
+    std::vector<uint8_t> content_key_{};
+
+    TransformResult CreateDecryptor(std::unique_ptr<XimalayaRandomAccessDecryptor> &decryptor, IReadSeekable *input)
     {
+        const auto data_offset = input->GetOffset();
         std::array<uint8_t, kXimalayaScrambleKeyLen> header_src{};
         if (!input->ReadExact(header_src.data(), header_src.size()))
         {
@@ -46,21 +72,61 @@ class XimalayaTransformer final : public ITransformer
             header_dst[i] = header_src[scramble_key_[i]];
         }
 
-        utils::LoopIterator key_iter{content_key_.data(), content_key_.size(), 0};
-        std::for_each(header_dst.begin(), header_dst.end(), [&](auto &value) { value ^= key_iter.GetAndMove(); });
+        utils::XorFromOffset(header_dst.data(), header_dst.size(), content_key_.data(), content_key_.size(), 0);
+
+        decryptor =
+            std::make_unique<XimalayaRandomAccessDecryptor>(header_dst, data_offset, input->GetSize() - data_offset);
+        return TransformResult::OK;
+    }
+
+  public:
+    XimalayaTransformer(const uint16_t *scramble_key, const uint8_t *content_key, size_t content_key_len)
+    {
+        std::copy_n(scramble_key, scramble_key_.size(), scramble_key_.begin());
+        content_key_.assign(content_key, content_key + content_key_len);
+    }
+
+    const char *GetName() override
+    {
+        return "Xmly (X2M/X3M)";
+    }
 
-        if (!output->Write(header_dst.data(), header_dst.size()))
+    TransformResult Transform(IWriteable *output, IReadSeekable *input) override
+    {
+        std::unique_ptr<XimalayaRandomAccessDecryptor> decryptor{};
+        if (auto result = CreateDecryptor(decryptor, input); result != TransformResult::OK)
         {
-            return TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
+            return result;
         }
 
-        // Transparent copy.
-        auto decrypt_ok = utils::PagedReader{input}.ReadInPages([&](size_t /*offset*/, uint8_t *buffer, size_t n) {
-            return output->Write(buffer, n); //
-        });
+        const auto data_offset = decryptor->GetDataOffset();
+        input->Seek(data_offset, SeekDirection::SEEK_FILE_BEGIN);
+        auto decrypt_ok = utils::PagedReader{input}.TransformInPages(
+            [&](size_t offset, uint8_t *dst, const uint8_t *src, size_t n) {
+                if (offset - data_offset >= kXimalayaScrambleKeyLen)
+                {
+                    return output->Write(src, n); // Transparent copy.
+                }
+                return decryptor->DecryptAt(offset - data_offset, dst, src, n) && output->Write(dst, n);
+            });
 
         return decrypt_ok ? TransformResult::OK : TransformResult::ERROR_IO_OUTPUT_UNKNOWN;
     }
+
+    TransformResult CreateRandomAccessDecryptor(std::unique_ptr<IRandomAccessDecryptor> &decryptor,
+                                                IReadSeekable *input) override
+    {
+        std::unique_ptr<XimalayaRandomAccessDecryptor> result{};
+        auto state = CreateDecryptor(result, input);
+        decryptor = std::move(result);
+        return state;
+    }
+
+    TransformResult CreateStreamingDecryptor(std::unique_ptr<IStreamingDecryptor> &decryptor) override
+    {
+        decryptor = std::make_unique<utils::RandomAccessStreamingDecryptor>(*this);
+        return TransformResult::OK;
+    }
 };
 
 std::unique_ptr<ITransformer> CreateXimalayaDecryptionTransformer(const uint16_t *scramble_key,
@@ -102,4 +102,21 @@ TEST(Ximalaya, X3MDecryption)
                                                                         content_key.size());
     test::should_decrypt_to_fixture("test_xmly.x3m", transformer);
 }
+TEST(Ximalaya, RandomAccess)
+{
+    std::array<uint8_t, 4> content_key = {0x9A, 0x5A, 0xD5, 0x06};
+    auto transformer = transformer::CreateXimalayaDecryptionTransformer(kTestScrambleKey.data(), content_key.data(),
+                                                                        content_key.size());
+    test::should_random_access_decrypt_to_fixture("test_xmly.x2m", transformer);
+    test::should_decrypt_after_prefix_to_fixture("test_xmly.x2m", transformer);
+}
+
+TEST(Ximalaya, StreamingDecryption)
+{
+    std::array<uint8_t, 4> content_key = {0x9A, 0x5A, 0xD5, 0x06};
+    auto transformer = transformer::CreateXimalayaDecryptionTransformer(kTestScrambleKey.data(), content_key.data(),
+                                                                        content_key.size());
+    test::should_stream_decrypt_to_fixture("test_xmly.x2m", transformer);
+}
+
 // NOLINTEND(*-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)